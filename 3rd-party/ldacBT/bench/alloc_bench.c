@@ -0,0 +1,239 @@
+/*
+ * Check of the libldac bit allocation when it has to give up bands.
+ *
+ * ldacBT only offers frame lengths that the encode settings fit, so the band reduction at the end
+ * of alloc_bits_ldac() never runs from there. This bench drives ldaclib directly: every encode
+ * setting row, in every gradient mode, is coded with all the bands of the sampling frequency
+ * into frames shorter than the row was made for, so the allocator has to drop bands. Each frame
+ * goes through the packer, which checks that the bits written match the allocation, and the
+ * streams are hashed so that they can be checked against golden hashes of the allocation without
+ * the per QU bits cache.
+ *
+ *  usage: alloc_bench [-c golden | -w golden]
+ *      -c golden  check the stream hashes against a golden file, exit 1 on mismatch
+ *      -w golden  write the stream hashes to a golden file
+ *  exit 1 as well if a frame fails to pack, or if no frame needed fewer bands
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ldaclib.c"
+
+/* frames per case, must not change once hashes are stored */
+#define BENCH_FRAMES 200
+#define BENCH_NSINES 12
+
+static unsigned long long a_hash[LDAC_NSUPSMPLRATEID][LDAC_ENC_NSETTING];
+static short a_pcm[LDAC_PRCNCH][LDAC_MAXLSU];
+static unsigned char a_stream[LDAC_MAXNBYTES];
+
+static unsigned int next_random(void)
+{
+    static unsigned int state = 0x12345678u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/* sines at random frequencies and levels over quiet noise: the steep steps between neighbouring
+ * scale factors give the additional word lengths that depend on where the bands end */
+static void make_frame(int nsmpl)
+{
+    static double a_phase[BENCH_NSINES], a_step[BENCH_NSINES], a_amp[BENCH_NSINES];
+    double x;
+    int ich, i, j;
+
+    if ((next_random() % 16) == 0 || a_amp[0] == 0.0) {
+        for (j = 0; j < BENCH_NSINES; j++) {
+            a_step[j] = (double)(next_random() % 10000) * (M_PI / 10000.0);
+            a_amp[j] = 16000.0 / BENCH_NSINES / (double)(1 << (next_random() % 12));
+        }
+    }
+    for (i = 0; i < nsmpl; i++) {
+        x = 0.0;
+        for (j = 0; j < BENCH_NSINES; j++) {
+            x += a_amp[j] * sin(a_phase[j]);
+            a_phase[j] += a_step[j];
+        }
+        for (ich = 0; ich < LDAC_PRCNCH; ich++) {
+            a_pcm[ich][i] = (short)(x + (double)((int)(next_random() % 64) - 32));
+        }
+    }
+}
+
+static unsigned long long fnv1a(unsigned long long hash, const unsigned char *data, int len)
+{
+    int i;
+    for (i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* frames of the row coded into frame_length bytes, returns the frames with fewer bands or -1 */
+static int run_case(int smplrate_id, int row, int frame_length, int *p_nnull)
+{
+    const int *p_set = saa_encode_setting_ldac[row];
+    HANDLE_LDAC hData;
+    char *ap_pcm[LDAC_PRCNCH] = {(char *)a_pcm[0], (char *)a_pcm[1]};
+    int nbands = ga_max_nbands_ldac[smplrate_id];
+    int nsmpl, nbytes_used;
+    int frame, ncuts = 0;
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    LDAC_RESULT result;
+
+    hData = ldaclib_get_handle();
+    if (hData == NULL) {
+        return -1;
+    }
+    ldaclib_get_frame_samples(smplrate_id, &nsmpl);
+    if (LDAC_FAILED(ldaclib_set_config_info(hData, smplrate_id, LDAC_CHCONFIGID_ST, frame_length,
+            LDAC_FRMSTAT_LEV_0)) ||
+        LDAC_FAILED(ldaclib_set_encode_info(hData, nbands, p_set[3], p_set[4], p_set[5], p_set[6],
+            p_set[7], p_set[8])) ||
+        LDAC_FAILED(ldaclib_init_encode(hData))) {
+        fprintf(stderr, "setting %d at %d bytes: setup failed, error %d\n",
+                row, frame_length, hData->error_code);
+        ldaclib_free_handle(hData);
+        return -1;
+    }
+
+    for (frame = 0; frame < BENCH_FRAMES; frame++) {
+        make_frame(nsmpl);
+        result = ldaclib_encode(hData, ap_pcm, LDAC_SMPL_FMT_S16, a_stream, &nbytes_used);
+        if (LDAC_FAILED(result)) {
+            fprintf(stderr, "setting %d at %d bytes: frame %d failed, error %d\n",
+                    row, frame_length, frame, hData->error_code);
+            ncuts = -1;
+            break;
+        }
+        hash = fnv1a(hash, a_stream, nbytes_used);
+        if (result == LDAC_S_FALSE) {
+            /* not even the fewest bands fit, sent as a null data frame */
+            (*p_nnull)++;
+        }
+        else if (hData->sfinfo.p_ab->nbands < nbands) {
+            ncuts++;
+        }
+    }
+
+    a_hash[smplrate_id][row] = hash;
+    ldaclib_free_encode(hData);
+    ldaclib_free_handle(hData);
+    return ncuts;
+}
+
+static int write_golden(const char *path)
+{
+    int smplrate_id, row;
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    fprintf(f, "# alloc_bench stream hashes, %d frames per case\n", BENCH_FRAMES);
+    for (smplrate_id = LDAC_SMPLRATEID_0; smplrate_id <= LDAC_SMPLRATEID_3; smplrate_id++) {
+        for (row = 0; row < LDAC_ENC_NSETTING; row++) {
+            fprintf(f, "%d %d %016llx\n", smplrate_id, row, a_hash[smplrate_id][row]);
+        }
+    }
+    fclose(f);
+    printf("wrote %s\n", path);
+    return 0;
+}
+
+static int check_golden(const char *path)
+{
+    char line[256];
+    int smplrate_id, row, matched = 0, failed = 0;
+    unsigned long long hash;
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#' || sscanf(line, "%d %d %llx", &smplrate_id, &row, &hash) != 3) {
+            continue;
+        }
+        if ((smplrate_id < LDAC_SMPLRATEID_0) || (LDAC_SMPLRATEID_3 < smplrate_id) ||
+            (row < 0) || (LDAC_ENC_NSETTING <= row)) {
+            printf("unknown case: %s", line);
+            failed++;
+            continue;
+        }
+        matched++;
+        if (a_hash[smplrate_id][row] != hash) {
+            printf("MISMATCH fs id %d, setting %d: got %016llx, expected %016llx\n", smplrate_id,
+                   row, a_hash[smplrate_id][row], hash);
+            failed++;
+        }
+    }
+    fclose(f);
+
+    if (matched != LDAC_NSUPSMPLRATEID * LDAC_ENC_NSETTING) {
+        printf("%s covers %d of %d cases\n", path, matched, LDAC_NSUPSMPLRATEID * LDAC_ENC_NSETTING);
+        failed++;
+    }
+    if (failed) {
+        printf("FAIL: %d problems against %s\n", failed, path);
+        return 1;
+    }
+    printf("all %d streams match %s\n", matched, path);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *golden = NULL;
+    int write = 0;
+    int smplrate_id, row, ncuts, nnull;
+    int total_cuts = 0, failed = 0;
+
+    if ((argc == 3) && (!strcmp(argv[1], "-c") || !strcmp(argv[1], "-w"))) {
+        write = (argv[1][1] == 'w');
+        golden = argv[2];
+    }
+    else if (argc != 1) {
+        fprintf(stderr, "usage: %s [-c golden | -w golden]\n", argv[0]);
+        return 2;
+    }
+
+    for (smplrate_id = LDAC_SMPLRATEID_0; smplrate_id <= LDAC_SMPLRATEID_3; smplrate_id++) {
+        for (row = 0; row < LDAC_ENC_NSETTING; row++) {
+            /* the shortest stereo frame, or the row's own length per channel for both */
+            int frame_length = max_ldac(saa_encode_setting_ldac[row][1], LDAC_MINSUPNBYTES);
+
+            nnull = 0;
+            ncuts = run_case(smplrate_id, row, frame_length, &nnull);
+            if (ncuts < 0) {
+                failed = 1;
+                continue;
+            }
+            printf("fs id %d, setting %2d (mode %d), %3d bytes: %4d of %d frames with fewer bands,"
+                    " %d null\n", smplrate_id, row, saa_encode_setting_ldac[row][3], frame_length,
+                    ncuts, BENCH_FRAMES, nnull);
+            total_cuts += ncuts;
+        }
+    }
+
+    if (failed) {
+        printf("bit allocation FAILED to pack\n");
+        return 1;
+    }
+    if (total_cuts == 0) {
+        printf("no frame needed fewer bands, the reduction went untested\n");
+        return 1;
+    }
+    printf("%d frames with fewer bands, all packed\n", total_cuts);
+
+    if (golden == NULL) {
+        return 0;
+    }
+    return write ? write_golden(golden) : check_golden(golden);
+}
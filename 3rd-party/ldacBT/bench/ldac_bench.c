@@ -0,0 +1,849 @@
+/*
+ * Host benchmark and bit exact regression check of the LDAC encoder.
+ *
+ * Encodes a set of generated signals at every sampling frequency and EQMID (plus ABR driven by a
+ * scripted queue depth) through ldacBT_encode(), and reports the time per LDAC frame together with
+ * the time spent in each encoder stage. The encoded streams are hashed so that changes to the
+ * encoder can be checked against stored golden hashes.
+ *
+ *  usage: ldac_bench [-p] [-r] [-s] [-f | -z] [-n calls] [-c golden | -w golden]
+ *      -p         process the two channels in parallel, on a helper thread
+ *      -r         encode in place from a PCM ring with ldacBT_encode_s16_view()
+ *      -s         get every handle in one static arena with ldacBT_get_handle_static()
+ *      -f         fast frame status analysis, each stream is compared against a second encoder
+ *                 that analyzes every frame, exit 1 if they differ outside the status bits
+ *      -z         as -r, but frames of digital silence go through ldacBT_encode_silence(), each
+ *                 stream is compared against a second encoder that codes them, exit 1 if they
+ *                 differ in a frame that is not a null data frame
+ *      -n calls   ldacBT_encode() calls per signal in benchmark mode (default 2000)
+ *      -c golden  check the stream hashes against a golden file, exit 1 on mismatch
+ *      -w golden  write the stream hashes to a golden file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "ldacBT.h"
+#include "ldacBT_abr.h"
+
+#ifdef _32BIT_FIXED_POINT
+#define BENCH_CONFIG "fixed point"
+#else
+#define BENCH_CONFIG "floating point"
+#endif
+
+/* 2-DH5, the only packet size libldac encodes for */
+#define BENCH_MTU 679
+
+/* the frame status is the lowest two bits of the third header byte, above them the frame length */
+#define FRAME_HEADER_BYTES 3
+#define FRAME_STATUS_BYTE 2
+#define FRAME_STATUS_MASK 0x03
+
+/* calls per signal for the golden hashes, must not change once hashes are stored */
+#define GOLDEN_CALLS 500
+
+#define ABR_INTERVAL_MS 20
+
+/* -s fails once the static handle comes this close to LDACBT_STATIC_SIZE_MAX, before it outgrows it */
+#define STATIC_SIZE_MARGIN 1024
+
+/* not a multiple of any frame size, so reads wrap at every position */
+#define RING_FRAMES 1000
+
+#define NUM_SIGNALS 5
+#define NUM_RATES 4
+#define NUM_EQMIDS 4
+
+static const char * const signal_names[NUM_SIGNALS] = {"sine", "sweep", "noise", "transient", "silence"};
+static const int rates[NUM_RATES] = {44100, 48000, 88200, 96000};
+static const int eqmids[NUM_EQMIDS] = {LDACBT_EQMID_HQ, LDACBT_EQMID_SQ, LDACBT_EQMID_MQ, LDACBT_EQMID_ABR};
+static const char * const eqmid_names[NUM_EQMIDS] = {"HQ", "SQ", "MQ", "ABR"};
+static const char * const stage_names[LDACBT_PROF_NUM] = {"mdct", "sigana", "norm", "alloc", "quant", "pack"};
+
+typedef struct {
+    unsigned long long hash;
+    long long encode_ns;
+    long long stage_ns[LDACBT_PROF_NUM];
+    long long stage_max_ns[LDACBT_PROF_NUM];
+    long ldac_frames;
+    long stream_bytes;
+    long status_frames;     /* -f: frames whose status differs from the full analysis */
+    long other_bytes;       /* -f, -z: bytes that differ elsewhere, must stay 0 */
+    long null_frames;       /* -z: frames sent as null data frames */
+} case_result_t;
+
+static case_result_t results[NUM_SIGNALS][NUM_RATES][NUM_EQMIDS];
+
+static int use_view;
+static short ring[RING_FRAMES * 2];
+static int use_static;
+static long long arena[LDACBT_STATIC_SIZE_MAX / sizeof(long long)];
+static int use_fast;
+static int use_silence;
+
+
+/*
+ * Timing
+ */
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* stage probes, the helper thread reports its own channel into a separate slot */
+static __thread int prof_slot;
+static __thread long long prof_start[LDACBT_PROF_NUM];
+static long long prof_total[2][LDACBT_PROF_NUM];
+static long long prof_max[2][LDACBT_PROF_NUM];
+
+static void prof_begin(int stage, void *user)
+{
+    (void)user;
+    prof_start[stage] = now_ns();
+}
+
+static void prof_end(int stage, void *user)
+{
+    long long elapsed = now_ns() - prof_start[stage];
+    (void)user;
+    prof_total[prof_slot][stage] += elapsed;
+    if (prof_max[prof_slot][stage] < elapsed) {
+        prof_max[prof_slot][stage] = elapsed;
+    }
+}
+
+
+/*
+ * Channel helper thread for -p, hands jobs over the way the Pico does between its cores: no lock,
+ * the helper polls for a job and the encoder takes the job back if the helper has not claimed it
+ * by the time the encoder is done with its own channel. The wall time per frame against a run
+ * without -p is the gain of the second core, the job counts tell how often the helper got there.
+ */
+
+static LDACBT_CH_JOB helper_job;
+static void *helper_job_arg;
+static int helper_done;
+static long helper_jobs_run;
+static long helper_jobs_taken_back;
+
+static LDACBT_CH_JOB helper_claim(void)
+{
+    return __atomic_exchange_n(&helper_job, NULL, __ATOMIC_ACQUIRE);
+}
+
+static void *helper_main(void *arg)
+{
+    (void)arg;
+    prof_slot = 1;
+    while (1) {
+        LDACBT_CH_JOB job = helper_claim();
+        if (job == NULL) {
+            /* a spare core would spin, a shared one has to give the encoder its turn */
+            sched_yield();
+            continue;
+        }
+        job(helper_job_arg);
+        helper_jobs_run++;
+        __atomic_store_n(&helper_done, 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static void helper_start(LDACBT_CH_JOB job, void *job_arg, void *user)
+{
+    (void)user;
+    helper_done = 0;
+    helper_job_arg = job_arg;
+    __atomic_store_n(&helper_job, job, __ATOMIC_RELEASE);
+}
+
+static void helper_wait(void *user)
+{
+    LDACBT_CH_JOB job = helper_claim();
+    (void)user;
+    if (job != NULL) {
+        job(helper_job_arg);
+        helper_jobs_taken_back++;
+        return;
+    }
+    while (!__atomic_load_n(&helper_done, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+
+/*
+ * Signal generation, integer only so the input is identical on every host
+ */
+
+static unsigned int noise_state;
+
+static int noise(void)
+{
+    noise_state ^= noise_state << 13;
+    noise_state ^= noise_state >> 17;
+    noise_state ^= noise_state << 5;
+    return (int)(noise_state >> 16) - 0x8000;
+}
+
+/* Bhaskara I approximation of sin(), phase is a full turn per 2^32, result is Q15 */
+static int sine(unsigned int phase)
+{
+    long long half = 1 << 15;
+    long long p = (phase >> 17) & (half - 1);
+    long long q = p * (half - p);
+    int value = (int)(16 * q * 32767 / (5 * half * half - 4 * q));
+    return (phase & 0x80000000u) ? -value : value;
+}
+
+typedef struct {
+    int signal;
+    int rate;
+    unsigned long long n;
+    unsigned int phase[2];
+    unsigned int increment;
+    int envelope;
+} generator_t;
+
+static void generator_init(generator_t *gen, int signal, int rate)
+{
+    memset(gen, 0, sizeof(*gen));
+    gen->signal = signal;
+    gen->rate = rate;
+    noise_state = 0x2545f491u;
+}
+
+static void generate(generator_t *gen, short *pcm, int nframes)
+{
+    int i, ch;
+    for (i = 0; i < nframes; i++, gen->n++) {
+        int v[2] = {0, 0};
+        switch (gen->signal) {
+            case 0:
+                /* 1 kHz left, 6.3 kHz right, -6 dBFS */
+                gen->phase[0] += (unsigned int)(1000ULL * 4294967296ULL / (unsigned int)gen->rate);
+                gen->phase[1] += (unsigned int)(6300ULL * 4294967296ULL / (unsigned int)gen->rate);
+                v[0] = sine(gen->phase[0]) / 2;
+                v[1] = sine(gen->phase[1]) / 2;
+                break;
+            case 1:
+                /* linear sweep up to nyquist over 2 seconds, right channel inverted */
+                if ((gen->n % ((unsigned long long)gen->rate * 2)) == 0) {
+                    gen->increment = 0;
+                }
+                gen->increment += (unsigned int)(0x80000000ULL / ((unsigned long long)gen->rate * 2));
+                gen->phase[0] += gen->increment;
+                v[0] = sine(gen->phase[0]) / 2;
+                v[1] = -v[0];
+                break;
+            case 2:
+                /* white noise, -12 dBFS, uncorrelated channels */
+                v[0] = noise() / 4;
+                v[1] = noise() / 4;
+                break;
+            case 3:
+                /* decaying noise bursts every 250 ms over silence */
+                if ((gen->n % ((unsigned long long)gen->rate / 4)) == 0) {
+                    gen->envelope = 32767;
+                }
+                v[0] = noise() * gen->envelope / 32768;
+                v[1] = noise() * gen->envelope / 32768;
+                gen->envelope -= gen->envelope / 256 + 1;
+                if (gen->envelope < 0) {
+                    gen->envelope = 0;
+                }
+                break;
+            default:
+                break;
+        }
+        for (ch = 0; ch < 2; ch++) {
+            pcm[i * 2 + ch] = (short)v[ch];
+        }
+    }
+}
+
+/* scripted TX queue depth for the ABR runs: a slow triangle between empty and congested */
+static unsigned int abr_queue_depth(long long elapsed_ms)
+{
+    int step = (int)((elapsed_ms / 100) % 16);
+    return (unsigned int)(step < 8 ? step : 15 - step);
+}
+
+
+/*
+ * Encoding
+ */
+
+static unsigned long long fnv1a(unsigned long long hash, const unsigned char *data, int len)
+{
+    int i;
+    for (i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* bytes of the fast analysis stream that differ from the full one, outside the status bits */
+static void compare_status(const unsigned char *stream, int stream_sz, const unsigned char *ref, int ref_sz,
+                           int frame_num, case_result_t *result)
+{
+    int f, b, frame_len;
+
+    if (stream_sz != ref_sz || frame_num <= 0) {
+        result->other_bytes += stream_sz > ref_sz ? stream_sz : ref_sz;
+        return;
+    }
+    frame_len = stream_sz / frame_num;
+    for (f = 0; f < frame_num; f++) {
+        const unsigned char *p = stream + f * frame_len, *q = ref + f * frame_len;
+        for (b = 0; b < frame_len; b++) {
+            if (b == FRAME_STATUS_BYTE) {
+                if ((p[b] ^ q[b]) & ~FRAME_STATUS_MASK) {
+                    result->other_bytes++;
+                }
+                if ((p[b] ^ q[b]) & FRAME_STATUS_MASK) {
+                    result->status_frames++;
+                }
+            } else if (p[b] != q[b]) {
+                result->other_bytes++;
+            }
+        }
+    }
+}
+
+/* bytes of the silence aware stream that differ from the fully coded one, outside the null frames */
+static void compare_silence(const unsigned char *stream, int stream_sz, const unsigned char *ref, int ref_sz,
+                            int frame_num, const unsigned char *null_frame, long *frames_out,
+                            case_result_t *result)
+{
+    int f, b, pos = 0, frame_len;
+
+    if (stream_sz != ref_sz || frame_num <= 0) {
+        result->other_bytes += stream_sz > ref_sz ? stream_sz : ref_sz;
+        return;
+    }
+    /* the frames of a packet need not be of one length while ABR moves, walk their headers */
+    for (f = 0; f < frame_num && pos + FRAME_HEADER_BYTES <= stream_sz; f++, (*frames_out)++) {
+        const unsigned char *p = stream + pos, *q = ref + pos;
+        frame_len = FRAME_HEADER_BYTES + (((p[1] & 0x07) << 6) | (p[2] >> 2)) + 1;
+        if (pos + frame_len > stream_sz) {
+            frame_len = stream_sz - pos;
+        }
+        pos += frame_len;
+        if (null_frame[*frames_out]) {
+            result->null_frames++;
+            continue;
+        }
+        for (b = 0; b < frame_len; b++) {
+            if (p[b] != q[b]) {
+                result->other_bytes++;
+            }
+        }
+    }
+}
+
+/* the next frame in the ring is digital silence */
+static int ring_silent(int tail, int nframes)
+{
+    int s;
+    for (s = 0; s < nframes; s++) {
+        int slot = (tail + s) % RING_FRAMES;
+        if (ring[slot * 2] != 0 || ring[slot * 2 + 1] != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static HANDLE_LDAC_BT open_encoder(HANDLE_LDAC_BT h_ldac, int rate, int eqmid)
+{
+    if (h_ldac == NULL) {
+        return NULL;
+    }
+    if (ldacBT_init_handle_encode(h_ldac, BENCH_MTU, eqmid == LDACBT_EQMID_ABR ? LDACBT_EQMID_SQ : eqmid,
+                                  LDACBT_CHANNEL_MODE_STEREO, LDACBT_SMPL_FMT_S16, rate) < 0) {
+        fprintf(stderr, "init failed: %d\n", ldacBT_get_error_code(h_ldac));
+        ldacBT_free_handle(h_ldac);
+        return NULL;
+    }
+    return h_ldac;
+}
+
+static int run_case(int signal, int rate, int eqmid, int calls, int parallel, case_result_t *result)
+{
+    HANDLE_LDAC_BT h_ldac;
+    HANDLE_LDAC_BT h_ref = NULL;
+    HANDLE_LDAC_ABR h_abr = NULL;
+    HANDLE_LDAC_ABR h_abr_ref = NULL;
+    generator_t gen;
+    short pcm[LDACBT_ENC_LSU * 2];
+    unsigned char stream[LDACBT_MAX_NBYTES];
+    unsigned char stream_ref[LDACBT_MAX_NBYTES];
+    long long abr_elapsed_ms = 0, abr_next_ms = ABR_INTERVAL_MS;
+    int ring_head = 0, ring_tail = 0;
+    int frame_samples = rate > 48000 ? 2 * LDACBT_ENC_LSU : LDACBT_ENC_LSU;
+    unsigned char *null_frame = NULL;
+    long frames_in = 0, frames_out = 0;
+    int silent_run = 0;
+    int i, s, slot;
+
+    memset(result, 0, sizeof(*result));
+    result->hash = 0xcbf29ce484222325ULL;
+    memset(prof_total, 0, sizeof(prof_total));
+    memset(prof_max, 0, sizeof(prof_max));
+
+    h_ldac = open_encoder(use_static ? ldacBT_get_handle_static(arena, sizeof(arena)) : ldacBT_get_handle(),
+                          rate, eqmid);
+    if (h_ldac == NULL) {
+        return -1;
+    }
+    if (use_fast || use_silence) {
+        if (use_fast) {
+            ldacBT_set_sigana_mode(h_ldac, LDACBT_SIGANA_FAST);
+        }
+        /* same input, every frame analyzed and coded */
+        h_ref = open_encoder(ldacBT_get_handle(), rate, eqmid);
+        if (h_ref == NULL) {
+            ldacBT_free_handle(h_ldac);
+            return -1;
+        }
+    }
+    if (use_silence) {
+        /* which of the frames are expected as null data frames, at most one per call */
+        null_frame = calloc((size_t)calls, 1);
+        if (null_frame == NULL) {
+            ldacBT_free_handle(h_ref);
+            ldacBT_free_handle(h_ldac);
+            return -1;
+        }
+    }
+    if (parallel) {
+        ldacBT_set_channel_parallel(h_ldac, helper_start, helper_wait, NULL);
+    }
+    ldacBT_set_profile_hook(h_ldac, prof_begin, prof_end, NULL);
+    if (eqmid == LDACBT_EQMID_ABR) {
+        h_abr = ldac_ABR_get_handle();
+        ldac_ABR_Init(h_abr, ABR_INTERVAL_MS);
+        if (h_ref != NULL) {
+            h_abr_ref = ldac_ABR_get_handle();
+            ldac_ABR_Init(h_abr_ref, ABR_INTERVAL_MS);
+        }
+    }
+
+    generator_init(&gen, signal, rate);
+
+    for (i = 0; i < calls; i++) {
+        int pcm_used, stream_sz, frame_num;
+        long long t0;
+
+        generate(&gen, pcm, LDACBT_ENC_LSU);
+
+        if (use_view) {
+            int level, offset, first;
+            for (s = 0; s < LDACBT_ENC_LSU; s++, ring_head++) {
+                ring[(ring_head % RING_FRAMES) * 2] = pcm[s * 2];
+                ring[(ring_head % RING_FRAMES) * 2 + 1] = pcm[s * 2 + 1];
+            }
+            level = ring_head - ring_tail;
+            offset = ring_tail % RING_FRAMES;
+            first = RING_FRAMES - offset < level ? RING_FRAMES - offset : level;
+
+            if (use_silence && level >= frame_samples && ring_silent(ring_tail, frame_samples)) {
+                t0 = now_ns();
+                s = ldacBT_encode_silence(h_ldac, &pcm_used, stream, &stream_sz, &frame_num);
+                result->encode_ns += now_ns() - t0;
+                /* the first silent frame still codes the decay of the sound before */
+                null_frame[frames_in++] = ++silent_run >= 2;
+            } else {
+                t0 = now_ns();
+                s = ldacBT_encode_s16_view(h_ldac, &ring[offset * 2], first, ring, level - first, LDACBT_GAIN_UNITY,
+                                           &pcm_used, stream, &stream_sz, &frame_num);
+                result->encode_ns += now_ns() - t0;
+                if (pcm_used > 0) {
+                    frames_in++;
+                    silent_run = 0;
+                }
+            }
+            ring_tail += pcm_used / 4;
+        } else {
+            t0 = now_ns();
+            s = ldacBT_encode(h_ldac, pcm, &pcm_used, stream, &stream_sz, &frame_num);
+            result->encode_ns += now_ns() - t0;
+        }
+        if (s < 0) {
+            fprintf(stderr, "encode failed: %d\n", ldacBT_get_error_code(h_ldac));
+            ldacBT_free_handle(h_ldac);
+            return -1;
+        }
+
+        if (stream_sz > 0) {
+            result->hash = fnv1a(result->hash, stream, stream_sz);
+            result->stream_bytes += stream_sz;
+        }
+
+        if (h_ref != NULL) {
+            int ref_used, ref_sz, ref_frame_num;
+            if (ldacBT_encode(h_ref, pcm, &ref_used, stream_ref, &ref_sz, &ref_frame_num) < 0) {
+                fprintf(stderr, "reference encode failed: %d\n", ldacBT_get_error_code(h_ref));
+                ref_sz = 0;
+            }
+            if (use_silence) {
+                compare_silence(stream, stream_sz, stream_ref, ref_sz, frame_num, null_frame, &frames_out, result);
+            } else {
+                compare_status(stream, stream_sz, stream_ref, ref_sz, frame_num, result);
+            }
+        }
+
+        if (h_abr != NULL) {
+            abr_elapsed_ms = (long long)gen.n * 1000 / rate;
+            while (abr_elapsed_ms >= abr_next_ms) {
+                ldac_ABR_Proc(h_ldac, h_abr, abr_queue_depth(abr_next_ms), 1);
+                if (h_abr_ref != NULL) {
+                    ldac_ABR_Proc(h_ref, h_abr_ref, abr_queue_depth(abr_next_ms), 1);
+                }
+                abr_next_ms += ABR_INTERVAL_MS;
+            }
+        }
+    }
+
+    /* 44.1/48 kHz frames are 128 samples, 88.2/96 kHz frames 256 */
+    result->ldac_frames = rate > 48000 ? calls / 2 : calls;
+    for (slot = 0; slot < 2; slot++) {
+        for (s = 0; s < LDACBT_PROF_NUM; s++) {
+            result->stage_ns[s] += prof_total[slot][s];
+            if (result->stage_max_ns[s] < prof_max[slot][s]) {
+                result->stage_max_ns[s] = prof_max[slot][s];
+            }
+        }
+    }
+
+    if (h_abr != NULL) {
+        ldac_ABR_free_handle(h_abr);
+    }
+    if (h_abr_ref != NULL) {
+        ldac_ABR_free_handle(h_abr_ref);
+    }
+    if (h_ref != NULL) {
+        ldacBT_free_handle(h_ref);
+    }
+    free(null_frame);
+    ldacBT_free_handle(h_ldac);
+    return 0;
+}
+
+
+/*
+ * Golden hashes
+ */
+
+static int write_golden(const char *path)
+{
+    int sg, r, e;
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    fprintf(f, "# ldac_bench stream hashes, %s, %d calls per signal\n", BENCH_CONFIG, GOLDEN_CALLS);
+    for (sg = 0; sg < NUM_SIGNALS; sg++) {
+        for (r = 0; r < NUM_RATES; r++) {
+            for (e = 0; e < NUM_EQMIDS; e++) {
+                fprintf(f, "%s %d %s %016llx\n", signal_names[sg], rates[r], eqmid_names[e],
+                        results[sg][r][e].hash);
+            }
+        }
+    }
+    fclose(f);
+    printf("wrote %s\n", path);
+    return 0;
+}
+
+static int check_golden(const char *path)
+{
+    char line[256], signal[32], eqmid[8];
+    int rate, sg, r, e, matched = 0, failed = 0;
+    unsigned long long hash;
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#' || sscanf(line, "%31s %d %7s %llx", signal, &rate, eqmid, &hash) != 4) {
+            continue;
+        }
+        for (sg = 0; sg < NUM_SIGNALS && strcmp(signal, signal_names[sg]); sg++) {
+        }
+        for (r = 0; r < NUM_RATES && rate != rates[r]; r++) {
+        }
+        for (e = 0; e < NUM_EQMIDS && strcmp(eqmid, eqmid_names[e]); e++) {
+        }
+        if (sg == NUM_SIGNALS || r == NUM_RATES || e == NUM_EQMIDS) {
+            printf("unknown case: %s", line);
+            failed++;
+            continue;
+        }
+        matched++;
+        if (results[sg][r][e].hash != hash) {
+            printf("MISMATCH %s %d %s: got %016llx, expected %016llx\n", signal, rate, eqmid,
+                   results[sg][r][e].hash, hash);
+            failed++;
+        }
+    }
+    fclose(f);
+
+    if (matched != NUM_SIGNALS * NUM_RATES * NUM_EQMIDS) {
+        printf("%s covers %d of %d cases\n", path, matched, NUM_SIGNALS * NUM_RATES * NUM_EQMIDS);
+        failed++;
+    }
+    if (failed) {
+        printf("FAIL: %d problems against %s\n", failed, path);
+        return 1;
+    }
+    printf("all %d streams match %s\n", matched, path);
+    return 0;
+}
+
+
+/*
+ * Report
+ */
+
+/* the fast analysis may only change the status field, the coded audio must be the same */
+static int report_fast(void)
+{
+    int sg, r, e;
+    long frames, status_frames, other_bytes, failed = 0;
+
+    printf("\nfast frame status analysis against the full one\n");
+    printf("%-10s %9s %14s %12s\n", "signal", "frames", "status differs", "other bytes");
+    for (sg = 0; sg < NUM_SIGNALS; sg++) {
+        frames = status_frames = other_bytes = 0;
+        for (r = 0; r < NUM_RATES; r++) {
+            for (e = 0; e < NUM_EQMIDS; e++) {
+                frames += results[sg][r][e].ldac_frames;
+                status_frames += results[sg][r][e].status_frames;
+                other_bytes += results[sg][r][e].other_bytes;
+            }
+        }
+        printf("%-10s %9ld %8ld %4.1f%% %12ld\n", signal_names[sg], frames, status_frames,
+               frames > 0 ? 100.0 * status_frames / frames : 0.0, other_bytes);
+        failed += other_bytes;
+    }
+    if (failed) {
+        printf("FAIL: the fast analysis changed %ld bytes outside the frame status\n", failed);
+        return 1;
+    }
+    printf("coded audio identical, only frame status bits differ\n");
+    return 0;
+}
+
+/* the silence shortcut may only replace frames of a silent window, the others must be the same */
+static int report_silence(void)
+{
+    int sg, r, e;
+    long frames, null_frames, other_bytes, failed = 0;
+
+    printf("\nsilence aware encoding against coding every frame\n");
+    printf("%-10s %9s %14s %12s\n", "signal", "frames", "null frames", "other bytes");
+    for (sg = 0; sg < NUM_SIGNALS; sg++) {
+        frames = null_frames = other_bytes = 0;
+        for (r = 0; r < NUM_RATES; r++) {
+            for (e = 0; e < NUM_EQMIDS; e++) {
+                frames += results[sg][r][e].ldac_frames;
+                null_frames += results[sg][r][e].null_frames;
+                other_bytes += results[sg][r][e].other_bytes;
+            }
+        }
+        printf("%-10s %9ld %8ld %4.1f%% %12ld\n", signal_names[sg], frames, null_frames,
+               frames > 0 ? 100.0 * null_frames / frames : 0.0, other_bytes);
+        failed += other_bytes;
+    }
+    if (failed) {
+        printf("FAIL: the silence shortcut changed %ld bytes outside the null frames\n", failed);
+        return 1;
+    }
+    printf("coded audio identical outside the null frames\n");
+    return 0;
+}
+
+static void report(void)
+{
+    int sg, r, e, s;
+
+    printf("\n%s encoder, ns per LDAC frame (all signals)\n", BENCH_CONFIG);
+    printf("%6s %4s %7s %9s", "rate", "eqmid", "kbps", "total");
+    for (s = 0; s < LDACBT_PROF_NUM; s++) {
+        printf(" %8s", stage_names[s]);
+    }
+    printf("\n");
+
+    for (r = 0; r < NUM_RATES; r++) {
+        for (e = 0; e < NUM_EQMIDS; e++) {
+            long long total = 0, stage[LDACBT_PROF_NUM] = {0};
+            long frames = 0, bytes = 0;
+            for (sg = 0; sg < NUM_SIGNALS; sg++) {
+                case_result_t *res = &results[sg][r][e];
+                total += res->encode_ns;
+                frames += res->ldac_frames;
+                bytes += res->stream_bytes;
+                for (s = 0; s < LDACBT_PROF_NUM; s++) {
+                    stage[s] += res->stage_ns[s];
+                }
+            }
+            if (frames == 0) {
+                continue;
+            }
+            printf("%6d %4s %7.0f %9.0f", rates[r], eqmid_names[e],
+                   (double)bytes * 8 * rates[r] / ((double)frames * (rates[r] > 48000 ? 256 : 128)) / 1000,
+                   (double)total / frames);
+            for (s = 0; s < LDACBT_PROF_NUM; s++) {
+                printf(" %8.0f", (double)stage[s] / frames);
+            }
+            printf("\n");
+        }
+    }
+
+    /* a probe covers one audio block of one frame, or one channel of it */
+    printf("\n%s encoder, worst single stage call in ns (all signals)\n", BENCH_CONFIG);
+    printf("%6s %4s", "rate", "eqmid");
+    for (s = 0; s < LDACBT_PROF_NUM; s++) {
+        printf(" %8s", stage_names[s]);
+    }
+    printf("\n");
+
+    for (r = 0; r < NUM_RATES; r++) {
+        for (e = 0; e < NUM_EQMIDS; e++) {
+            long long stage_max[LDACBT_PROF_NUM] = {0};
+            for (sg = 0; sg < NUM_SIGNALS; sg++) {
+                case_result_t *res = &results[sg][r][e];
+                for (s = 0; s < LDACBT_PROF_NUM; s++) {
+                    if (stage_max[s] < res->stage_max_ns[s]) {
+                        stage_max[s] = res->stage_max_ns[s];
+                    }
+                }
+            }
+            printf("%6d %4s", rates[r], eqmid_names[e]);
+            for (s = 0; s < LDACBT_PROF_NUM; s++) {
+                printf(" %8lld", stage_max[s]);
+            }
+            printf("\n");
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *golden = NULL;
+    int write = 0, parallel = 0, calls = 2000;
+    int i, sg, r, e;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-p")) {
+            parallel = 1;
+        } else if (!strcmp(argv[i], "-r")) {
+            use_view = 1;
+        } else if (!strcmp(argv[i], "-s")) {
+            use_static = 1;
+        } else if (!strcmp(argv[i], "-f")) {
+            use_fast = 1;
+        } else if (!strcmp(argv[i], "-z")) {
+            use_silence = 1;
+            use_view = 1;
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            calls = atoi(argv[++i]);
+        } else if ((!strcmp(argv[i], "-c") || !strcmp(argv[i], "-w")) && i + 1 < argc) {
+            write = argv[i][1] == 'w';
+            golden = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-p] [-r] [-s] [-f | -z] [-n calls] [-c golden | -w golden]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (use_fast && golden != NULL) {
+        fprintf(stderr, "the golden hashes are of the full frame status analysis, -f takes no -c or -w\n");
+        return 2;
+    }
+    if (use_silence && (use_fast || golden != NULL)) {
+        fprintf(stderr, "the golden hashes are of every frame coded, -z takes no -f, -c or -w\n");
+        return 2;
+    }
+    if (golden != NULL) {
+        calls = GOLDEN_CALLS;
+    }
+    if (calls <= 0) {
+        fprintf(stderr, "invalid number of calls\n");
+        return 2;
+    }
+
+    if (use_static) {
+        int size = ldacBT_get_static_size(0);
+        if (size < 0 || size > (int)sizeof(arena) - STATIC_SIZE_MARGIN) {
+            printf("FAIL: static handle needs %d bytes, LDACBT_STATIC_SIZE_MAX is %d, keep %d spare\n", size,
+                   (int)sizeof(arena), STATIC_SIZE_MARGIN);
+            return 1;
+        }
+        printf("static handle: %d of %d bytes (mono %d, dual %d, stereo %d)\n", size, (int)sizeof(arena),
+               ldacBT_get_static_size(LDACBT_CHANNEL_MODE_MONO),
+               ldacBT_get_static_size(LDACBT_CHANNEL_MODE_DUAL_CHANNEL),
+               ldacBT_get_static_size(LDACBT_CHANNEL_MODE_STEREO));
+    }
+
+    if (parallel) {
+        pthread_t helper;
+        if (pthread_create(&helper, NULL, helper_main, NULL) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+        pthread_detach(helper);
+    }
+
+    {
+        /* the probe registration fails if libldac was built without them */
+        HANDLE_LDAC_BT h_ldac = ldacBT_get_handle();
+        if (h_ldac != NULL) {
+            if (ldacBT_set_profile_hook(h_ldac, prof_begin, prof_end, NULL) < 0) {
+                printf("note: libldac built without LDAC_PROFILE, no stage breakdown\n");
+            }
+            ldacBT_free_handle(h_ldac);
+        }
+    }
+
+    for (sg = 0; sg < NUM_SIGNALS; sg++) {
+        for (r = 0; r < NUM_RATES; r++) {
+            for (e = 0; e < NUM_EQMIDS; e++) {
+                if (run_case(sg, rates[r], eqmids[e], calls, parallel, &results[sg][r][e]) < 0) {
+                    printf("FAIL: %s %d %s did not encode\n", signal_names[sg], rates[r], eqmid_names[e]);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    report();
+    if (parallel) {
+        printf("\nchannel jobs: %ld run by the helper thread, %ld taken back by the encoder, %ld CPUs online\n",
+               helper_jobs_run, helper_jobs_taken_back, sysconf(_SC_NPROCESSORS_ONLN));
+    }
+
+    if (use_fast) {
+        return report_fast();
+    }
+    if (use_silence) {
+        return report_silence();
+    }
+    if (golden == NULL) {
+        return 0;
+    }
+    return write ? write_golden(golden) : check_golden(golden);
+}
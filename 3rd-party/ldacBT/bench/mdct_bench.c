@@ -0,0 +1,180 @@
+/*
+ * Host benchmark of the libldac fixed point MDCT kernel.
+ * Reports the time per frame of the kernel, then times the per frame update of the overlap window:
+ * the history shift libldac used to do against the ping-pong halves it uses now.
+ *
+ *  usage: mdct_bench [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#define MAX_LNN 8
+#define MAX_LSU (1 << MAX_LNN)
+
+void mdct_kernel(int *p_x, int *p_y, int nlnn);
+
+static int a_input[MAX_LSU * 2];
+
+static unsigned int next_random(void)
+{
+    static unsigned int state = 0x12345678u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/* audio like input: a few sines plus noise, at a random level so the block floating point shift
+ * of the kernel gets exercised */
+static void make_frame(int *p_x, int nsmpl, int frame)
+{
+    int i;
+    int level = 8 + (int)(next_random() % 23);
+    for (i = 0; i < nsmpl * 2; i++) {
+        int t = frame * nsmpl + i;
+        int v = ((t * 37) & 0xffff) - 0x8000 + ((t * 11) & 0x3fff) - 0x2000;
+        v += (int)(next_random() & 0xfff) - 0x800;
+        p_x[i] = (v << level) >> 8;
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static unsigned long long now_cycles(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void run(int nlnn, int frames)
+{
+    int i, a_x[MAX_LSU * 2], a_y[MAX_LSU];
+    int nsmpl = 1 << nlnn;
+    double t0, t1;
+    unsigned long long c0, c1;
+
+    /* warm up caches and clock */
+    for (i = 0; i < frames / 10 + 1; i++) {
+        mdct_kernel(a_input, a_y, nlnn);
+    }
+
+    t0 = now_ns();
+    c0 = now_cycles();
+    for (i = 0; i < frames; i++) {
+        /* the kernel only reads the input, but keep it from being hoisted */
+        memcpy(a_x, a_input, sizeof(int) * nsmpl * 2);
+        mdct_kernel(a_x, a_y, nlnn);
+    }
+    c1 = now_cycles();
+    t1 = now_ns();
+
+    printf("MDCT %4d samples: %8.1f ns/frame", nsmpl, (t1 - t0) / frames);
+    if (c1 != c0) {
+        printf(", %8.0f cycles/frame", (double)(c1 - c0) / frames);
+    }
+    printf("\n");
+}
+
+/* the input stage of libldac for one channel, the 16 bit samples scaled to Q15 */
+static void convert_s16(const short *p_s, int *p_out, int nsmpl)
+{
+    int i;
+    for (i = 0; i < nsmpl; i++) {
+        p_out[i] = (int)p_s[i] << 15;
+    }
+}
+
+/* history shift: the newer half moves down, the new frame goes into the upper half */
+static int *update_shift(int *p_time, int *p_new, const short *p_s, int nsmpl)
+{
+    int i;
+    (void)p_new;
+    for (i = 0; i < nsmpl; i++) {
+        p_time[i] = p_time[nsmpl + i];
+    }
+    convert_s16(p_s, p_time + nsmpl, nsmpl);
+    return p_time;
+}
+
+/* ping-pong: the older half is overwritten in place, only the index flips */
+static int *update_pingpong(int *p_time, int *p_new, const short *p_s, int nsmpl)
+{
+    *p_new ^= 1;
+    convert_s16(p_s, p_time + *p_new * nsmpl, nsmpl);
+    return p_time;
+}
+
+typedef int *(*window_update_t)(int *, int *, const short *, int);
+
+static void run_window(const char *name, window_update_t update, int nlnn, int frames)
+{
+    static int a_time[2][MAX_LSU * 2];
+    static short a_pcm[2][MAX_LSU];
+    int i, ich, a_new[2] = {0, 0};
+    int nsmpl = 1 << nlnn;
+    int sink = 0;
+    double t0, t1;
+    unsigned long long c0, c1;
+
+    for (i = 0; i < nsmpl; i++) {
+        a_pcm[0][i] = (short)(next_random() & 0xffff);
+        a_pcm[1][i] = (short)(next_random() & 0xffff);
+    }
+
+    t0 = now_ns();
+    c0 = now_cycles();
+    for (i = 0; i < frames; i++) {
+        for (ich = 0; ich < 2; ich++) {
+            /* touch the result so the update is not dropped */
+            sink += update(a_time[ich], &a_new[ich], a_pcm[ich], nsmpl)[i & (nsmpl * 2 - 1)];
+        }
+    }
+    c1 = now_cycles();
+    t1 = now_ns();
+
+    printf("  %-8s %4d samples: %8.1f ns/frame", name, nsmpl, (t1 - t0) / frames);
+    if (c1 != c0) {
+        printf(", %8.0f cycles/frame", (double)(c1 - c0) / frames);
+    }
+    printf("%s\n", sink == 0x7fffffff ? " " : "");
+}
+
+int main(int argc, char *argv[])
+{
+    int nlnn, frames = 200000;
+
+    if (argc > 1) {
+        frames = atoi(argv[1]);
+        if (frames <= 0) {
+            fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (nlnn = 7; nlnn <= MAX_LNN; nlnn++) {
+        make_frame(a_input, 1 << nlnn, 0);
+        run(nlnn, frames);
+    }
+
+    for (nlnn = 7; nlnn <= MAX_LNN; nlnn++) {
+        printf("Window update %d, stereo:\n", 1 << nlnn);
+        run_window("shift", update_shift, nlnn, frames);
+        run_window("pingpong", update_pingpong, nlnn, frames);
+    }
+    return 0;
+}
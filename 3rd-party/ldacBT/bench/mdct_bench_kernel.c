@@ -0,0 +1,14 @@
+/*
+ * The MDCT kernel of libldac (fixed point) behind a plain entry point for the benchmark.
+ */
+
+#include "ldac.h"
+#include "tables_sigproc_fixp_ldac.c"
+#include "func_fixp_ldac.c"
+#include "mdct_fixp_ldac.c"
+
+void mdct_kernel(int *p_x, int *p_y, int nlnn)
+{
+    set_mdct_table_ldac(nlnn);
+    proc_mdct_core_ldac((INT32 *)p_x, (INT32 *)p_x + npow2_ldac(nlnn), (INT32 *)p_y, nlnn);
+}
@@ -133,6 +133,17 @@ enum {
     LDACBT_EQMID_ABR = 0x7F,
 };
 
+/* EQMIDs between SQ and MQ.
+ *  They can not be configured, ldacBT_alter_eqmid_priority() steps through them on the way from
+ *  SQ to MQ and ldacBT_get_eqmid() returns them while they are in use.
+ *   - LDACBT_EQMID_Q0 : one step below SQ.
+ *   - LDACBT_EQMID_Q1 : one step below Q0, MQ follows.
+ */
+enum {
+    LDACBT_EQMID_Q0 = LDACBT_EQMID_MQ + 1,
+    LDACBT_EQMID_Q1,
+};
+
 /* Bit rates
  *  Bit rates in each EQMID are depend on sampling frequency.
  *  In this API specification, these relations are shown below.
@@ -142,6 +153,8 @@ enum {
  *    +-----------------+------------+------------+
  *    | LDACBT_EQMID_HQ |   909kbps  |   990kbps  |
  *    | LDACBT_EQMID_SQ |   606kbps  |   660kbps  |
+ *    | LDACBT_EQMID_Q0 |   452kbps  |   492kbps  |
+ *    | LDACBT_EQMID_Q1 |   364kbps  |   396kbps  |
  *    | LDACBT_EQMID_MQ |   303kbps  |   330kbps  |
  *     -------------------------------------------
  */
@@ -165,6 +178,38 @@ typedef struct _st_ldacbt_handle * HANDLE_LDAC_BT;
  */
 LDACBT_API HANDLE_LDAC_BT ldacBT_get_handle( void );
 
+/* Size of static memory for an LDAC handle.
+ * Returns the exact number of bytes ldacBT_get_handle_static() needs to encode with channel mode
+ * "cm", or with any channel mode if "cm" is 0. LDACBT_STATIC_SIZE_MAX is a compile time bound of
+ * the latter, for sizing a static buffer. The library fails to compile for a target whose handle
+ * would not fit; 32 bit ARM needs about 24.1 KB, a 64 bit host about 24.3 KB.
+ *  Format
+ *      int  ldacBT_get_static_size( int cm );
+ *  Arguments
+ *      cm         int               Channel mode, LDACBT_CHANNEL_MODE_*, or 0.
+ *  Return value
+ *      int : size in bytes for success, -1 for failure.
+ */
+#define LDACBT_STATIC_SIZE_MAX (25*1024)
+LDACBT_API int  ldacBT_get_static_size( int cm );
+
+/* Allocation of LDAC handle in static memory.
+ * The handle and everything ldacBT_init_handle_encode() allocates for it are placed in "p_mem",
+ * nothing is taken from the heap. "p_mem" must be 8 byte aligned and stay valid until the handle
+ * is released. Each ldacBT_init_handle_encode() reuses the same memory, so closing and initializing
+ * the handle again, or getting a new handle in the same memory after ldacBT_free_handle(), never
+ * grows it. ldacBT_init_handle_encode() fails with an allocation error if "size" is smaller than
+ * ldacBT_get_static_size() of the requested channel mode.
+ *  Format
+ *      HANDLE_LDAC_BT ldacBT_get_handle_static( void *p_mem, int size );
+ *  Arguments
+ *      p_mem      void *            Memory for the handle.
+ *      size       int               Size of "p_mem" in bytes.
+ *  Return value
+ *      HANDLE_LDAC_BT for success, NULL for failure.
+ */
+LDACBT_API HANDLE_LDAC_BT ldacBT_get_handle_static( void *p_mem, int size );
+
 /* Release of LDAC handle.
  *  Format
  *      void ldacBT_free_handle( HANDLE_LDAC_BT hLdacBt );
@@ -301,6 +346,82 @@ LDACBT_API int  ldacBT_get_eqmid( HANDLE_LDAC_BT hLdacBt );
 #define LDACBT_EQMID_INC_CONNECTION -1
 LDACBT_API int  ldacBT_alter_eqmid_priority( HANDLE_LDAC_BT hLdacBt, int priority );
 
+/* Registration of a helper for processing the two channels in parallel.
+ * MDCT, frame analysis and normalization before bit allocation, and quantization after it, are
+ * independent per channel. With a helper registered, the encoder hands the second channel to
+ * "start" and processes the first one itself, then calls "wait" before it continues.
+ * "start" must arrange for job(job_arg) to run exactly once, e.g. on another core, and "wait" must
+ * not return before that call has returned. The encoded stream is the same as without a helper.
+ * Setting "start" as NULL restores processing on the calling thread only.
+ * The LDAC handle must be allocated by API function ldacBT_get_handle() prior to calling this
+ * function. The setting is kept across ldacBT_init_handle_encode().
+ *  Format
+ *      int  ldacBT_set_channel_parallel( HANDLE_LDAC_BT hLdacBt, LDACBT_CH_JOB_START start,
+ *                                        LDACBT_CH_JOB_WAIT wait, void *user );
+ *  Arguments
+ *      hLdacBt    HANDLE_LDAC_BT       LDAC handle.
+ *      start      LDACBT_CH_JOB_START  Starts job(job_arg) elsewhere, called with "user".
+ *      wait       LDACBT_CH_JOB_WAIT   Waits for the started job, called with "user".
+ *      user       void *               Passed through to "start" and "wait".
+ *  Return value
+ *      int : 0 for success, -1 for failure.
+ */
+typedef void (*LDACBT_CH_JOB)( void *job_arg );
+typedef void (*LDACBT_CH_JOB_START)( LDACBT_CH_JOB job, void *job_arg, void *user );
+typedef void (*LDACBT_CH_JOB_WAIT)( void *user );
+LDACBT_API int  ldacBT_set_channel_parallel( HANDLE_LDAC_BT hLdacBt, LDACBT_CH_JOB_START start,
+                                             LDACBT_CH_JOB_WAIT wait, void *user );
+
+/* Registration of encoder stage probes.
+ * When the library is built with LDAC_PROFILE defined, the encoder calls "begin" and "end" around
+ * each stage of a frame, with one of the LDACBT_PROF_* stage numbers below. With the channels
+ * processed in parallel, the per-channel stages are reported from both threads. Without
+ * LDAC_PROFILE the probes are compiled out and this function fails with LDACBT_ERR_NOT_IMPLEMENTED.
+ * Setting "begin" and "end" as NULL stops the reports.
+ *  Format
+ *      int  ldacBT_set_profile_hook( HANDLE_LDAC_BT hLdacBt, LDACBT_PROF_HOOK begin,
+ *                                    LDACBT_PROF_HOOK end, void *user );
+ *  Arguments
+ *      hLdacBt    HANDLE_LDAC_BT    LDAC handle.
+ *      begin      LDACBT_PROF_HOOK  Called with the stage number and "user" when a stage begins.
+ *      end        LDACBT_PROF_HOOK  Called with the stage number and "user" when a stage ends.
+ *      user       void *            Passed through to "begin" and "end".
+ *  Return value
+ *      int : 0 for success, -1 for failure.
+ */
+#define LDACBT_PROF_MDCT     0
+#define LDACBT_PROF_SIGANA   1
+#define LDACBT_PROF_NORM     2
+#define LDACBT_PROF_BITALLOC 3
+#define LDACBT_PROF_QUANT    4
+#define LDACBT_PROF_PACK     5
+#define LDACBT_PROF_NUM      6
+typedef void (*LDACBT_PROF_HOOK)( int stage, void *user );
+LDACBT_API int  ldacBT_set_profile_hook( HANDLE_LDAC_BT hLdacBt, LDACBT_PROF_HOOK begin,
+                                         LDACBT_PROF_HOOK end, void *user );
+
+/* Selection of the frame status analysis.
+ * Every frame carries a status, derived from the low band energy and, when the signal crosses
+ * zero often enough, the centroid of its spectrum. It goes into the frame header only, the coded
+ * spectrum does not depend on it.
+ *   - LDACBT_SIGANA_FULL : Analyzes every frame (default).
+ *   - LDACBT_SIGANA_FAST : Once the status of a channel held for a number of frames in a row, the
+ *                          next few frames reuse it without analysis. The frame headers may then
+ *                          differ from LDACBT_SIGANA_FULL around status changes.
+ * The LDAC handle must be allocated by API function ldacBT_get_handle() prior to calling this
+ * function. The setting is kept across ldacBT_init_handle_encode().
+ *  Format
+ *      int  ldacBT_set_sigana_mode( HANDLE_LDAC_BT hLdacBt, int mode );
+ *  Arguments
+ *      hLdacBt    HANDLE_LDAC_BT    LDAC handle.
+ *      mode       int               LDACBT_SIGANA_FULL or LDACBT_SIGANA_FAST.
+ *  Return value
+ *      int : 0 for success, -1 for failure.
+ */
+#define LDACBT_SIGANA_FULL 0
+#define LDACBT_SIGANA_FAST 1
+LDACBT_API int  ldacBT_set_sigana_mode( HANDLE_LDAC_BT hLdacBt, int mode );
+
 
 /* LDAC encode processing.
  * The LDAC handle must be initialized by API function ldacBT_init_handle_encode() prior to calling
@@ -349,6 +470,62 @@ LDACBT_API int  ldacBT_alter_eqmid_priority( HANDLE_LDAC_BT hLdacBt, int priorit
 LDACBT_API int  ldacBT_encode( HANDLE_LDAC_BT hLdacBt, void *p_pcm, int *pcm_used,
                                unsigned char *p_stream, int *stream_sz, int *frame_num );
 
+/* LDAC encode processing, reading interleaved 16bit PCM in place.
+ * Works as ldacBT_encode() with LDACBT_SMPL_FMT_S16, but the PCM is not copied into the encoder.
+ * It is read from the caller's buffer straight into the encoder's time windows, in one pass that
+ * splits the channels, converts the samples and applies "gain".
+ * The PCM is given as up to two spans, so that a ring buffer can be read across its wrap point.
+ * Each call takes exactly one frame, i.e. 128 samples per channel at 44.1 and 48 kHz and 256
+ * samples per channel at 88.2 and 96 kHz. With fewer samples in the spans nothing is encoded and
+ * "pcm_used" is set as zero. Samples after the frame are left for the next call.
+ * The handle must be initialized with LDACBT_SMPL_FMT_S16, and this function must not be mixed
+ * with ldacBT_encode() on the same stream except for the final flush with "p_pcm" as zero.
+ *  Format
+ *      int  ldacBT_encode_s16_view( HANDLE_LDAC_BT hLdacBt, const short *p_pcm0, int nsmpl0,
+ *                                   const short *p_pcm1, int nsmpl1, int gain, int *pcm_used,
+ *                                   unsigned char *p_stream, int *stream_sz, int *frame_num );
+ *  Arguments
+ *      hLdacBt    HANDLE_LDAC_BT    LDAC handle.
+ *      p_pcm0     const short *     First span of interleaved PCM.
+ *      nsmpl0     int               Samples per channel in the first span.
+ *      p_pcm1     const short *     Second span, continuing the first one. May be zero.
+ *      nsmpl1     int               Samples per channel in the second span.
+ *      gain       int               Gain applied to the PCM, Q15, 0 to LDACBT_GAIN_UNITY.
+ *      pcm_used   int *             Data size of referenced PCM singnal. Unit:Byte.
+ *      p_stream   unsigned char *   Output "ldac_transport_frame" sequence.
+ *      stream_sz  int *             Size of output data. Unit:Byte.
+ *      frame_num  int *             Number of output "ldac_transport_frame"
+ *  Return value
+ *      int : 0 for success, -1 for failure.
+ */
+#define LDACBT_GAIN_UNITY 0x8000
+LDACBT_API int  ldacBT_encode_s16_view( HANDLE_LDAC_BT hLdacBt, const short *p_pcm0, int nsmpl0,
+                                        const short *p_pcm1, int nsmpl1, int gain, int *pcm_used,
+                                        unsigned char *p_stream, int *stream_sz, int *frame_num );
+
+/* LDAC encode processing of one frame of digital silence.
+ * Works as ldacBT_encode_s16_view() given a frame of zero samples, without reading any PCM.
+ * As long as the previous frame still held sound, its decay is encoded in full. Once the whole
+ * transform window is silent, a null data frame is emitted instead, skipping the signal
+ * processing. A following call with sound is encoded in full again, so the output switches back
+ * within one frame.
+ * "pcm_used" is set as the data size of one frame, which the caller should skip in its input.
+ * The same restrictions as for ldacBT_encode_s16_view() apply.
+ *  Format
+ *      int  ldacBT_encode_silence( HANDLE_LDAC_BT hLdacBt, int *pcm_used,
+ *                                  unsigned char *p_stream, int *stream_sz, int *frame_num );
+ *  Arguments
+ *      hLdacBt    HANDLE_LDAC_BT    LDAC handle.
+ *      pcm_used   int *             Data size of the silent frame. Unit:Byte.
+ *      p_stream   unsigned char *   Output "ldac_transport_frame" sequence.
+ *      stream_sz  int *             Size of output data. Unit:Byte.
+ *      frame_num  int *             Number of output "ldac_transport_frame"
+ *  Return value
+ *      int : 0 for success, -1 for failure.
+ */
+LDACBT_API int  ldacBT_encode_silence( HANDLE_LDAC_BT hLdacBt, int *pcm_used,
+                                       unsigned char *p_stream, int *stream_sz, int *frame_num );
+
 /* Acquisition of previously established error code.
  * The LDAC handle must be allocated by API function ldacBT_get_handle() prior to calling this function.
  * The details of error code are described below at the end of this header file.
@@ -21,14 +21,15 @@
 /***************************************************************************************************
     Subfunction: Calculate Bits for Audio Block
 ***************************************************************************************************/
-static int encode_audio_block_a_ldac(
+LDAC_HOT_FUNC static int encode_audio_block_a_ldac(
 AB *p_ab, 
 int hqu)
 {
     AC *p_ac;
-    int ich, iqu;
+    int ich, iqu, lqu, uqu;
     int nchs = p_ab->blk_nchs;
-    int tmp, nbits = 0;
+    int nqus_cached = p_ab->nqus_cached;
+    int tmp, nbits = p_ab->nbits_cached;
     int idsp, idwl1, idwl2;
     int grad_mode = p_ab->grad_mode;
     int grad_qu_l = p_ab->grad_qu_l;
@@ -36,7 +37,7 @@ int hqu)
     int grad_os_l = p_ab->grad_os_l;
     int grad_os_h = p_ab->grad_os_h;
     int *p_grad = p_ab->a_grad;
-    int *p_idsf, *p_addwl, *p_idwl1, *p_idwl2;
+    int *p_idsf, *p_addwl, *p_idwl1, *p_idwl2, *p_nbits_qu;
     const unsigned char *p_t;
 
     /* Calculate Gradient Curve */
@@ -67,16 +68,52 @@ int hqu)
         }
     }
 
+    /* Find the QUs whose gradient moved since the previous call, the bits of the others are kept */
+    if ((nqus_cached == 0) || (hqu > nqus_cached) ||
+        (grad_mode != p_ab->grad_mode_cached) || (grad_qu_h != p_ab->grad_qu_h_cached)) {
+        lqu = 0;
+        uqu = hqu;
+        nbits = 0;
+    }
+    else {
+        lqu = hqu;
+        uqu = 0;
+        if (grad_os_l != p_ab->grad_os_l_cached) {
+            lqu = 0;
+            uqu = grad_qu_h;
+        }
+        if (grad_os_h != p_ab->grad_os_h_cached) {
+            lqu = min_ldac(lqu, grad_qu_l);
+            uqu = hqu;
+        }
+        if (grad_qu_l != p_ab->grad_qu_l_cached) {
+            lqu = min_ldac(lqu, min_ldac(grad_qu_l, p_ab->grad_qu_l_cached));
+            uqu = max_ldac(uqu, grad_qu_h);
+        }
+        uqu = min_ldac(uqu, hqu);
+
+        for (ich = 0; ich < nchs; ich++) {
+            p_nbits_qu = p_ab->ap_ac[ich]->a_nbits_qu;
+            for (iqu = lqu; iqu < uqu; iqu++) {
+                nbits -= p_nbits_qu[iqu];
+            }
+            for (iqu = hqu; iqu < nqus_cached; iqu++) {
+                nbits -= p_nbits_qu[iqu];
+            }
+        }
+    }
+
     /* Calculate Bits */
     for (ich = 0; ich < nchs; ich++) {
         p_ac = p_ab->ap_ac[ich];
-	p_idsf = p_ac->a_idsf;
-	p_addwl = p_ac->a_addwl;
-	p_idwl1 = p_ac->a_idwl1;
-	p_idwl2 = p_ac->a_idwl2;
+        p_idsf = p_ac->a_idsf;
+        p_addwl = p_ac->a_addwl;
+        p_idwl1 = p_ac->a_idwl1;
+        p_idwl2 = p_ac->a_idwl2;
+        p_nbits_qu = p_ac->a_nbits_qu;
 
         if (grad_mode == LDAC_MODE_0) { 
-            for (iqu = 0; iqu < hqu; iqu++) {
+            for (iqu = lqu; iqu < uqu; iqu++) {
                 idwl1 = p_idsf[iqu] + p_grad[iqu];
                 if (idwl1 < LDAC_MINIDWL1) {
                     idwl1 = LDAC_MINIDWL1;
@@ -92,11 +129,13 @@ int hqu)
                 p_idwl1[iqu] = idwl1;
                 p_idwl2[iqu] = idwl2;
                 idsp = ga_idsp_ldac[iqu];
-                nbits += gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+                tmp = gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+                p_nbits_qu[iqu] = tmp;
+                nbits += tmp;
             }
         }
         else if (grad_mode == LDAC_MODE_1) {
-            for (iqu = 0; iqu < hqu; iqu++) {
+            for (iqu = lqu; iqu < uqu; iqu++) {
                 idwl1 = p_idsf[iqu] + p_grad[iqu] + p_addwl[iqu];
                 if (idwl1 > 0) {
                     idwl1 = idwl1 >> 1;
@@ -115,11 +154,13 @@ int hqu)
                 p_idwl1[iqu] = idwl1;
                 p_idwl2[iqu] = idwl2;
                 idsp = ga_idsp_ldac[iqu];
-                nbits += gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+                tmp = gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+                p_nbits_qu[iqu] = tmp;
+                nbits += tmp;
             }
         }
         else if (grad_mode == LDAC_MODE_2) {
-            for (iqu = 0; iqu < hqu; iqu++) {
+            for (iqu = lqu; iqu < uqu; iqu++) {
                 idwl1 = p_idsf[iqu] + p_grad[iqu] + p_addwl[iqu];
                 if (idwl1 > 0) {
                     idwl1 = (idwl1*3) >> 3;
@@ -138,11 +179,13 @@ int hqu)
                 p_idwl1[iqu] = idwl1;
                 p_idwl2[iqu] = idwl2;
                 idsp = ga_idsp_ldac[iqu];
-                nbits += gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+                tmp = gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+                p_nbits_qu[iqu] = tmp;
+                nbits += tmp;
             }
         }
         else if (grad_mode == LDAC_MODE_3) {
-            for (iqu = 0; iqu < hqu; iqu++) {
+            for (iqu = lqu; iqu < uqu; iqu++) {
                 idwl1 = p_idsf[iqu] + p_grad[iqu] + p_addwl[iqu];
                 if (idwl1 > 0) {
                     idwl1 = idwl1 >> 2;
@@ -161,18 +204,28 @@ int hqu)
                 p_idwl1[iqu] = idwl1;
                 p_idwl2[iqu] = idwl2;
                 idsp = ga_idsp_ldac[iqu];
-                nbits += gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+                tmp = gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+                p_nbits_qu[iqu] = tmp;
+                nbits += tmp;
             }
         }
     }
 
+    p_ab->nqus_cached = hqu;
+    p_ab->nbits_cached = nbits;
+    p_ab->grad_mode_cached = grad_mode;
+    p_ab->grad_qu_l_cached = grad_qu_l;
+    p_ab->grad_qu_h_cached = grad_qu_h;
+    p_ab->grad_os_l_cached = grad_os_l;
+    p_ab->grad_os_h_cached = grad_os_h;
+
     return nbits;
 }
 
 /***************************************************************************************************
     Subfunction: Calculate Bits for Audio Block
 ***************************************************************************************************/
-static int encode_audio_block_b_ldac(
+LDAC_HOT_FUNC static int encode_audio_block_b_ldac(
 AB *p_ab,
 int nadjqus)
 {
@@ -217,7 +270,7 @@ int nadjqus)
 /***************************************************************************************************
     Subfunction: Decrease Lower Offset of Gradient Curve
 ***************************************************************************************************/
-static int decrease_offset_low_ldac(
+LDAC_HOT_FUNC static int decrease_offset_low_ldac(
 AB *p_ab,
 int limit,
 int *p_nbits_spec)
@@ -282,7 +335,7 @@ int *p_nbits_spec)
 /***************************************************************************************************
     Subfunction: Decrease Higher Offset of Gradient Curve
 ***************************************************************************************************/
-static int decrease_offset_high_ldac(
+LDAC_HOT_FUNC static int decrease_offset_high_ldac(
 AB *p_ab,
 int *p_nbits_spec)
 {
@@ -346,7 +399,7 @@ int *p_nbits_spec)
 /***************************************************************************************************
     Subfunction: Increase Lower Offset of Gradient Curve
 ***************************************************************************************************/
-static int increase_offset_low_ldac(
+LDAC_HOT_FUNC static int increase_offset_low_ldac(
 AB *p_ab,
 int *p_nbits_spec)
 {
@@ -409,7 +462,7 @@ int *p_nbits_spec)
 /***************************************************************************************************
     Subfunction: Increase Lower QU of Gradient Curve
 ***************************************************************************************************/
-static int increase_qu_low_ldac(
+LDAC_HOT_FUNC static int increase_qu_low_ldac(
 AB *p_ab,
 int *p_nbits_spec)
 {
@@ -472,7 +525,7 @@ int *p_nbits_spec)
 /***************************************************************************************************
     Subfunction: Increase Lower QU of Gradient Curve
 ***************************************************************************************************/
-static int increase_qu_low_0_ldac(
+LDAC_HOT_FUNC static int increase_qu_low_0_ldac(
 AB *p_ab,
 int *p_nbits_spec)
 {
@@ -532,10 +585,32 @@ int *p_nbits_spec)
     return ncalls;
 }
 
+/***************************************************************************************************
+    Subfunction: Calculate Bits for One QU of Audio Block B
+***************************************************************************************************/
+LDAC_HOT_FUNC __inline static int calc_nbits_qu_b_ldac(
+int iqu,
+int idwl1)
+{
+    int idsp, idwl2;
+
+    idwl2 = 0;
+    if (idwl1 > LDAC_MAXIDWL1) {
+        idwl2 = idwl1 - LDAC_MAXIDWL1;
+        if (idwl2 > LDAC_MAXIDWL2) {
+            idwl2 = LDAC_MAXIDWL2;
+        }
+        idwl1 = LDAC_MAXIDWL1;
+    }
+    idsp = ga_idsp_ldac[iqu];
+
+    return gaa_ndim_wls_ldac[idsp][idwl1] + ga_wl_ldac[idwl2] * ga_nsps_ldac[iqu];
+}
+
 /***************************************************************************************************
     Subfunction: Adjust Remaining Bits
 ***************************************************************************************************/
-static int adjust_remain_bits_ldac(
+LDAC_HOT_FUNC static int adjust_remain_bits_ldac(
 AB *p_ab, 
 int *p_nbits_spec,
 int *p_nadjqus)
@@ -552,6 +627,7 @@ int *p_nadjqus)
     int grad_mode = p_ab->grad_mode;
     int *p_grad = p_ab->a_grad;
     int *p_idsf, *p_addwl, *p_idwl1, *p_idwl2, *p_tmp;
+    int a_nbits_b[LDAC_MAXNADJQUS+1];
     AC *p_ac;
 
     nbits_fix = 0;
@@ -627,7 +703,25 @@ int *p_nadjqus)
     }
 
     nbits_fix = *p_nbits_spec - nbits_fix;
-    nbits_spec = nbits_fix + encode_audio_block_b_ldac(p_ab, nadjqus);
+
+    /* Bits of audio block B for each count of adjusted QUs, so that a search step is one lookup */
+    a_nbits_b[0] = 0;
+    for (iqu = 0; iqu < nqus; iqu++) {
+        a_nbits_b[iqu+1] = 0;
+    }
+    for (ich = 0; ich < nchs; ich++) {
+        p_tmp = p_ab->ap_ac[ich]->a_tmp;
+        for (iqu = 0; iqu < nqus; iqu++) {
+            tmp = calc_nbits_qu_b_ldac(iqu, p_tmp[iqu]);
+            a_nbits_b[0] += tmp;
+            a_nbits_b[iqu+1] += calc_nbits_qu_b_ldac(iqu, p_tmp[iqu]+1) - tmp;
+        }
+    }
+    for (iqu = 0; iqu < nqus; iqu++) {
+        a_nbits_b[iqu+1] += a_nbits_b[iqu];
+    }
+
+    nbits_spec = nbits_fix + a_nbits_b[min_ldac(nadjqus, nqus)];
     ncalls++;
 
     while (step > 1) {
@@ -648,15 +742,18 @@ int *p_nadjqus)
             }
             break;
         }
-        nbits_spec = nbits_fix + encode_audio_block_b_ldac(p_ab, nadjqus);
+        nbits_spec = nbits_fix + a_nbits_b[min_ldac(nadjqus, nqus)];
         ncalls++;
     }
 
     if (nbits_spec > nbits_avail) {
         nadjqus--;
-        nbits_spec = nbits_fix + encode_audio_block_b_ldac(p_ab, nadjqus);
+        nbits_spec = nbits_fix + a_nbits_b[min_ldac(nadjqus, nqus)];
         ncalls++;
     }
+
+    /* Word lengths of the chosen count */
+    encode_audio_block_b_ldac(p_ab, nadjqus);
     *p_nadjqus = nadjqus;
     *p_nbits_spec = nbits_spec;
 
@@ -669,7 +766,7 @@ int *p_nadjqus)
 #define LDAC_UPPER_NOISE_LEVEL 20
 #define LDAC_LOWER_NOISE_LEVEL 5
 
-DECLFUNC int alloc_bits_ldac(
+LDAC_HOT_FUNC DECLFUNC int alloc_bits_ldac(
 AB *p_ab)
 {
     int nbits_avail, nbits_side = 0, nbits_spec = 0;
@@ -678,6 +775,9 @@ AB *p_ab)
     nbits_side = encode_side_info_ldac(p_ab);
     p_ab->nbits_avail = nbits_avail = nbits_ab - nbits_side;
 
+    /* The bits cached by the previous frame are stale */
+    p_ab->nqus_cached = 0;
+    p_ab->nbits_cached = 0;
     nbits_spec = encode_audio_block_a_ldac(p_ab, p_ab->nqus);
 
     if (nbits_spec > nbits_avail) {
@@ -699,6 +799,9 @@ AB *p_ab)
             nbits_side = encode_side_info_ldac(p_ab);
             p_ab->nbits_avail = nbits_avail = nbits_ab - nbits_side;
 
+            /* The side info of fewer QUs changes the additional word lengths */
+            p_ab->nqus_cached = 0;
+            p_ab->nbits_cached = 0;
             nbits_spec = encode_audio_block_a_ldac(p_ab, p_ab->nqus);
         }
     }
@@ -19,7 +19,7 @@
 /***************************************************************************************************
     Calculate Bits for Band Info
 ***************************************************************************************************/
-static int encode_band_info_ldac(
+LDAC_HOT_FUNC static int encode_band_info_ldac(
 __attribute__((unused)) AB *p_ab)
 {
     int	nbits;
@@ -32,7 +32,7 @@ __attribute__((unused)) AB *p_ab)
 /***************************************************************************************************
     Calculate Bits for Gradient Data
 ***************************************************************************************************/
-static int encode_gradient_ldac(
+LDAC_HOT_FUNC static int encode_gradient_ldac(
 AB *p_ab)
 {
     int	nbits;
@@ -50,7 +50,7 @@ AB *p_ab)
 /***************************************************************************************************
     Subfunction: Get Index of Minimum Value
 ***************************************************************************************************/
-__inline static int get_minimum_id_ldac(
+LDAC_HOT_FUNC __inline static int get_minimum_id_ldac(
 int *p_nbits,
 int n)
 {
@@ -79,11 +79,11 @@ typedef struct {
 /***************************************************************************************************
     Subfunction: Calculate Bits for Scale Factor Data - Mode 0
 ***************************************************************************************************/
-static const unsigned char sa_bitlen_maxdif_0_ldac[LDAC_NIDSF] = {
+LDAC_HOT_TABLE static const unsigned char sa_bitlen_maxdif_0_ldac[LDAC_NIDSF] = {
     3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
 };
 
-static int encode_scale_factor_0_ldac(
+LDAC_HOT_FUNC static int encode_scale_factor_0_ldac(
 AC *p_ac,
 SFCINF *p_sfcinf)
 {
@@ -133,11 +133,11 @@ SFCINF *p_sfcinf)
 /***************************************************************************************************
     Subfunction: Calculate Bits for Scale Factor Data - Mode 1
 ***************************************************************************************************/
-static const unsigned char sa_bitlen_maxdif_1_ldac[LDAC_NIDSF] = {
+LDAC_HOT_TABLE static const unsigned char sa_bitlen_maxdif_1_ldac[LDAC_NIDSF] = {
     2, 2, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
 };
 
-static int encode_scale_factor_1_ldac(
+LDAC_HOT_FUNC static int encode_scale_factor_1_ldac(
 AC *p_ac,
 SFCINF *p_sfcinf)
 {
@@ -184,11 +184,11 @@ SFCINF *p_sfcinf)
 /***************************************************************************************************
     Subfunction: Calculate Bits for Scale Factor Data - Mode 2
 ***************************************************************************************************/
-static const unsigned char sa_bitlen_absmax_2_ldac[LDAC_NIDSF>>1] = {
+LDAC_HOT_TABLE static const unsigned char sa_bitlen_absmax_2_ldac[LDAC_NIDSF>>1] = {
     2, 3, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
 };
 
-static int encode_scale_factor_2_ldac(
+LDAC_HOT_FUNC static int encode_scale_factor_2_ldac(
 AC *p_ac,
 SFCINF *p_sfcinf)
 {
@@ -226,7 +226,7 @@ SFCINF *p_sfcinf)
 /***************************************************************************************************
     Calculate Bits for Scale Factor Data
 ***************************************************************************************************/
-static int encode_scale_factor_ldac(
+LDAC_HOT_FUNC static int encode_scale_factor_ldac(
 AC *p_ac)
 {
     SFCINF a_sfcinf[LDAC_NSFCMODE];
@@ -256,7 +256,7 @@ AC *p_ac)
 /***************************************************************************************************
     Calculate Bits for Side Information (Band Info, Gradient Data & Scale Factor Data)
 ***************************************************************************************************/
-DECLFUNC int encode_side_info_ldac(
+LDAC_HOT_FUNC DECLFUNC int encode_side_info_ldac(
 AB *p_ab)
 {
     AC *p_ac;
@@ -281,7 +281,7 @@ AB *p_ab)
 /***************************************************************************************************
     Calculate Additional Word Length Data
 ***************************************************************************************************/
-DECLFUNC void calc_add_word_length_ldac(
+LDAC_HOT_FUNC DECLFUNC void calc_add_word_length_ldac(
 AC *p_ac)
 {
     int iqu;
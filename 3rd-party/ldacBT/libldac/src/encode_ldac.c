@@ -57,6 +57,18 @@ SFINFO *p_sfinfo)
     return result;
 }
 
+/***************************************************************************************************
+    Get Memory Size
+***************************************************************************************************/
+DECLFUNC size_t get_encode_memory_size_ldac(
+int chconfig_id)
+{
+    int nchs = ga_ch_ldac[chconfig_id];
+    int nbks = gaa_block_setting_ldac[chconfig_id][1];
+
+    return nchs * (align_ldac(sizeof(AC)) + align_ldac(sizeof(ACSUB))) + nbks * align_ldac(sizeof(AB));
+}
+
 /***************************************************************************************************
     Initialize Memory
 ***************************************************************************************************/
@@ -72,6 +84,9 @@ SFINFO *p_sfinfo)
     int chconfig_id = p_cfg->chconfig_id;
     int nbks = gaa_block_setting_ldac[chconfig_id][1];
 
+    if (p_sfinfo->p_membase != (char *)NULL) {
+        p_sfinfo->p_mempos = p_sfinfo->p_membase;
+    }
     if (alloc_encode_ldac(p_sfinfo) == LDAC_E_FAIL) {
         p_sfinfo->error_code = LDAC_ERR_ALLOC_MEMORY;
         return LDAC_E_FAIL;
@@ -94,6 +109,10 @@ SFINFO *p_sfinfo)
             p_ab->ap_ac[ich]->p_ab = p_ab;
             p_ab->ap_ac[ich]->ich = ich;
             p_ab->ap_ac[ich]->frmana_cnt = 0;
+            p_ab->ap_ac[ich]->frmana_zcros = 0;
+            p_ab->ap_ac[ich]->frmana_status = LDAC_FRMSTAT_LEV_0;
+            p_ab->ap_ac[ich]->frmana_steady = 0;
+            p_ab->ap_ac[ich]->frmana_skip = 0;
         }
 
         p_ab++;
@@ -170,23 +189,31 @@ SFINFO *p_sfinfo)
 /***************************************************************************************************
     Encode Audio Block
 ***************************************************************************************************/
-static int encode_audio_block_ldac(
+LDAC_HOT_FUNC static int encode_audio_block_ldac(
+SFINFO *p_sfinfo,
 AB *p_ab)
 {
     AC *p_ac;
     int ich;
     int nchs = p_ab->blk_nchs;
+    int result;
 
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_NORM);
     for (ich = 0; ich < nchs; ich++) {
         p_ac = p_ab->ap_ac[ich];
 
         norm_spectrum_ldac(p_ac);
     }
+    prof_end_ldac(p_sfinfo, LDAC_PROF_NORM);
 
-    if (!alloc_bits_ldac(p_ab)) {
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_BITALLOC);
+    result = alloc_bits_ldac(p_ab);
+    prof_end_ldac(p_sfinfo, LDAC_PROF_BITALLOC);
+    if (!result) {
         return LDAC_FALSE;
     }
 
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_QUANT);
     for (ich = 0; ich < nchs; ich++) {
         p_ac = p_ab->ap_ac[ich];
 
@@ -194,6 +221,7 @@ AB *p_ab)
 
         quant_residual_ldac(p_ac);
     }
+    prof_end_ldac(p_sfinfo, LDAC_PROF_QUANT);
 
     return LDAC_TRUE;
 }
@@ -201,7 +229,7 @@ AB *p_ab)
 /***************************************************************************************************
     Encode
 ***************************************************************************************************/
-DECLFUNC int encode_ldac(
+LDAC_HOT_FUNC DECLFUNC int encode_ldac(
 SFINFO *p_sfinfo,
 int nbands,
 int grad_mode,
@@ -225,7 +253,7 @@ int abc_status)
         p_ab->grad_os_h = grad_os_h;
         p_ab->abc_status = abc_status;
 
-        if (!encode_audio_block_ldac(p_ab)) {
+        if (!encode_audio_block_ldac(p_sfinfo, p_ab)) {
             return LDAC_ERR_NON_FATAL_ENCODE;
         }
 
@@ -235,3 +263,135 @@ int abc_status)
     return LDAC_ERR_NONE;
 }
 
+/***************************************************************************************************
+    Subfunction: Process Channel Front End
+***************************************************************************************************/
+typedef struct {
+    SFINFO *p_sfinfo;
+    AC *p_ac;
+    int nlnn;
+    int frame_status;
+} CHJOB;
+
+LDAC_HOT_FUNC static void encode_channel_front_ldac(
+void *p_arg)
+{
+    CHJOB *p_job = (CHJOB *)p_arg;
+    SFINFO *p_sfinfo = p_job->p_sfinfo;
+
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_MDCT);
+    proc_mdct_channel_ldac(p_job->p_ac, p_job->nlnn);
+    prof_end_ldac(p_sfinfo, LDAC_PROF_MDCT);
+
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_SIGANA);
+    p_job->frame_status = ana_channel_status_ldac(p_job->p_ac, p_job->nlnn, p_sfinfo->sigana_mode);
+    prof_end_ldac(p_sfinfo, LDAC_PROF_SIGANA);
+
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_NORM);
+    norm_spectrum_ldac(p_job->p_ac);
+    prof_end_ldac(p_sfinfo, LDAC_PROF_NORM);
+
+    return;
+}
+
+/***************************************************************************************************
+    Subfunction: Process Channel Back End
+***************************************************************************************************/
+LDAC_HOT_FUNC static void encode_channel_back_ldac(
+void *p_arg)
+{
+    CHJOB *p_job = (CHJOB *)p_arg;
+    SFINFO *p_sfinfo = p_job->p_sfinfo;
+
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_QUANT);
+    quant_spectrum_ldac(p_job->p_ac);
+
+    quant_residual_ldac(p_job->p_ac);
+    prof_end_ldac(p_sfinfo, LDAC_PROF_QUANT);
+
+    return;
+}
+
+/***************************************************************************************************
+    Subfunction: Run Channel Jobs
+***************************************************************************************************/
+LDAC_HOT_FUNC static void run_channel_jobs_ldac(
+SFINFO *p_sfinfo,
+LDAC_CHJOB job,
+CHJOB *p_jobs,
+int nchs)
+{
+    if (nchs == LDAC_MAXNCH) {
+        p_sfinfo->chjob_start(job, p_jobs+1, p_sfinfo->p_chjob_user);
+        job(p_jobs);
+        p_sfinfo->chjob_wait(p_sfinfo->p_chjob_user);
+    }
+    else {
+        job(p_jobs);
+    }
+
+    return;
+}
+
+/***************************************************************************************************
+    Encode with Channels Processed in Parallel
+***************************************************************************************************/
+LDAC_HOT_FUNC DECLFUNC int encode_parallel_ldac(
+SFINFO *p_sfinfo,
+int nlnn,
+int nbands,
+int grad_mode,
+int grad_qu_l,
+int grad_qu_h,
+int grad_os_l,
+int grad_os_h,
+int abc_status)
+{
+    AB *p_ab = p_sfinfo->p_ab;
+    int ibk, ich;
+    int nbks = gaa_block_setting_ldac[p_sfinfo->cfg.chconfig_id][1];
+    int nchs = p_sfinfo->cfg.ch;
+    CHJOB a_job[LDAC_MAXNCH];
+
+    for (ibk = 0; ibk < nbks; ibk++){
+        p_ab[ibk].nbands = nbands;
+        p_ab[ibk].nqus = ga_nqus_ldac[nbands];
+        p_ab[ibk].grad_mode = grad_mode;
+        p_ab[ibk].grad_qu_l = grad_qu_l;
+        p_ab[ibk].grad_qu_h = grad_qu_h;
+        p_ab[ibk].grad_os_l = grad_os_l;
+        p_ab[ibk].grad_os_h = grad_os_h;
+        p_ab[ibk].abc_status = abc_status;
+    }
+
+    clear_data_ldac(a_job, LDAC_MAXNCH*sizeof(CHJOB));
+    for (ich = 0; ich < nchs; ich++) {
+        a_job[ich].p_sfinfo = p_sfinfo;
+        a_job[ich].p_ac = p_sfinfo->ap_ac[ich];
+        a_job[ich].nlnn = nlnn;
+    }
+
+    /* Channels are independent until bit allocation */
+    run_channel_jobs_ldac(p_sfinfo, encode_channel_front_ldac, a_job, nchs);
+
+    if (nchs == LDAC_CHANNEL_1CH) {
+        p_sfinfo->cfg.frame_status = a_job[0].frame_status;
+    }
+    else {
+        p_sfinfo->cfg.frame_status = min_ldac(a_job[0].frame_status, a_job[1].frame_status);
+    }
+
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_BITALLOC);
+    for (ibk = 0; ibk < nbks; ibk++){
+        if (!alloc_bits_ldac(p_ab+ibk)) {
+            prof_end_ldac(p_sfinfo, LDAC_PROF_BITALLOC);
+            return LDAC_ERR_NON_FATAL_ENCODE;
+        }
+    }
+    prof_end_ldac(p_sfinfo, LDAC_PROF_BITALLOC);
+
+    run_channel_jobs_ldac(p_sfinfo, encode_channel_back_ldac, a_job, nchs);
+
+    return LDAC_ERR_NONE;
+}
+
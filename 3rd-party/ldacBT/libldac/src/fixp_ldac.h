@@ -27,6 +27,7 @@
 #define LDAC_C_BLKFLT   31
 
 #define LDAC_Q_SETPCM   15
+#define LDAC_Q_GAIN     15
 
 #define LDAC_Q_MDCT_WIN 30
 #define LDAC_Q_MDCT_COS 31
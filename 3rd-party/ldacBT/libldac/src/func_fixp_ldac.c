@@ -20,7 +20,7 @@
 /*******************************************************************************
     Subfunction: Check Saturation
 *******************************************************************************/
-__inline static INT32 check_sature_ldac(
+LDAC_HOT_FUNC __inline static INT32 check_sature_ldac(
 INT64 val)
 {
 
@@ -30,7 +30,7 @@ INT64 val)
 /*******************************************************************************
     Shift and Round
 *******************************************************************************/
-DECLFUNC INT32 sftrnd_ldac(
+LDAC_HOT_FUNC DECLFUNC INT32 sftrnd_ldac(
 INT32 in,
 int shift)
 {
@@ -50,9 +50,16 @@ int shift)
 /*******************************************************************************
     Get Bit Length of Value
 *******************************************************************************/
-DECLFUNC int get_bit_length_ldac(
+LDAC_HOT_FUNC DECLFUNC int get_bit_length_ldac(
 INT32 val)
 {
+#if defined(__GNUC__)
+    if (val <= 0) {
+        return 0;
+    }
+
+    return 32 - __builtin_clz((unsigned int)val);
+#else /* __GNUC__ */
     int len;
 
     len = 0;
@@ -62,12 +69,13 @@ INT32 val)
     }
 
     return len;
+#endif /* __GNUC__ */
 }
 
 /*******************************************************************************
     Get Maximum Absolute Value
 *******************************************************************************/
-DECLFUNC INT32 get_absmax_ldac(
+LDAC_HOT_FUNC DECLFUNC INT32 get_absmax_ldac(
 INT32 *p_x,
 int num)
 {
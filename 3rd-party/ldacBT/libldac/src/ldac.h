@@ -92,6 +92,9 @@
 #define LDAC_NSP_LOWENERGY    12
 #define LDAC_TH_ZCROSNUM      90
 #define LDAC_MAXCNT_FRMANA    10
+/* Fast mode: a status that held for STEADY analyses is reused for the next SKIP frames */
+#define LDAC_FRMANA_STEADY     8
+#define LDAC_FRMANA_SKIP       3
 
 /* Stream Syntax */
 #define LDAC_BLKID_MONO        0
@@ -172,22 +175,32 @@ struct _config_info_ldac {
 };
 
 /* Audio Channel (AC) Sub Structure */
+/* a_time holds two frames of nsmpl samples used as a ping-pong pair, */
+/* time_new selects the half holding the latest input frame */
 #ifndef _32BIT_FIXED_POINT
 struct _audio_channel_sub_ldac {
     SCALAR a_time[LDAC_MAXLSU*LDAC_NFRAME];
     SCALAR a_spec[LDAC_MAXLSU];
+    int time_new;
 };
 #else /* _32BIT_FIXED_POINT */
 struct _audio_channel_sub_ldac {
     INT32 a_time[LDAC_MAXLSU*LDAC_NFRAME];
     INT32 a_spec[LDAC_MAXLSU];
+    int time_new;
 };
 #endif /* _32BIT_FIXED_POINT */
 
 /* Audio Channel (AC) Structure */
+/* a_nbits_qu caches the spectrum bits of each QU counted during bit allocation */
+/* frmana_zcros holds the zero crosses inside the newer time half, -1 if they were not counted */
 struct _audio_channel_ldac {
     int ich;
     int frmana_cnt;
+    int frmana_zcros;
+    int frmana_status;
+    int frmana_steady;
+    int frmana_skip;
     int sfc_mode;
     int sfc_bitlen;
     int sfc_offset;
@@ -197,6 +210,7 @@ struct _audio_channel_ldac {
     int a_idwl2[LDAC_MAXNQUS];
     int a_addwl[LDAC_MAXNQUS];
     int a_tmp[LDAC_MAXNQUS];
+    int a_nbits_qu[LDAC_MAXNQUS];
     int a_qspec[LDAC_MAXLSU];
     int a_rspec[LDAC_MAXLSU];
     AB *p_ab;
@@ -204,6 +218,8 @@ struct _audio_channel_ldac {
 };
 
 /* Audio Block (AB) Structure */
+/* The cached bits of the first nqus_cached QUs of all channels sum up to nbits_cached, */
+/* counted with the gradient given by the grad_*_cached parameters */
 struct _audio_block_ldac {
     int blk_type;
     int blk_nchs;
@@ -224,21 +240,40 @@ struct _audio_block_ldac {
     int nbits_spec;
     int nbits_avail;
     int nbits_used;
+    int nqus_cached;
+    int nbits_cached;
+    int grad_mode_cached;
+    int grad_qu_l_cached;
+    int grad_qu_h_cached;
+    int grad_os_l_cached;
+    int grad_os_h_cached;
     int *p_smplrate_id;
     int *p_error_code;
     AC  *ap_ac[2];
 };
 
 /* Sound Frame Structure */
+/* With p_mempos set, calloc_ldac hands out [p_mempos, p_memend) instead of the heap, and */
+/* init_encode_ldac starts again from p_membase */
 struct _sfinfo_ldac {
     CFG cfg;
     AB *p_ab;
     AC *ap_ac[LDAC_MAXNCH];
     char *p_mempos;
+    char *p_membase;
+    char *p_memend;
     int error_code;
+    LDAC_CHJOB_START chjob_start;
+    LDAC_CHJOB_WAIT chjob_wait;
+    void *p_chjob_user;
+    LDAC_PROF_HOOK prof_begin;
+    LDAC_PROF_HOOK prof_end;
+    void *p_prof_user;
+    int sigana_mode;
 };
 
 /* LDAC Handle */
+/* nsilent counts the silent halves of the time windows, up to LDAC_NFRAME */
 typedef struct _handle_ldac_struct {
     int nlnn;
     int nbands;
@@ -248,6 +283,7 @@ typedef struct _handle_ldac_struct {
     int grad_os_l;
     int grad_os_h;
     int abc_status;
+    int nsilent;
     int error_code;
     SFINFO sfinfo;
 } HANDLE_LDAC_STRUCT;
@@ -282,6 +318,29 @@ struct _hcenc_ldac {
 /* Convert a Signed Number with nbits to a Signed Integer */
 #define bs_to_int_ldac(bs, nbits) (((bs)&(0x1<<((nbits)-1))) ? ((bs)|((~0x0)<<(nbits))) : bs)
 
+/* Get the Older and Newer Halves of the Time Domain Window */
+#define get_time_old_ldac(p_acsub, nsmpl) ((p_acsub)->a_time+(((p_acsub)->time_new)^1)*(nsmpl))
+#define get_time_new_ldac(p_acsub, nsmpl) ((p_acsub)->a_time+((p_acsub)->time_new)*(nsmpl))
+
+/* Encoder Stage Probes */
+#ifdef LDAC_PROFILE
+#define prof_begin_ldac(p_sfinfo, stage) \
+    do { \
+        if ((p_sfinfo)->prof_begin != NULL) { \
+            (p_sfinfo)->prof_begin((stage), (p_sfinfo)->p_prof_user); \
+        } \
+    } while (0)
+#define prof_end_ldac(p_sfinfo, stage) \
+    do { \
+        if ((p_sfinfo)->prof_end != NULL) { \
+            (p_sfinfo)->prof_end((stage), (p_sfinfo)->p_prof_user); \
+        } \
+    } while (0)
+#else /* LDAC_PROFILE */
+#define prof_begin_ldac(p_sfinfo, stage) ((void)(p_sfinfo))
+#define prof_end_ldac(p_sfinfo, stage) ((void)(p_sfinfo))
+#endif /* LDAC_PROFILE */
+
 #ifdef _32BIT_FIXED_POINT
 #include "fixp_ldac.h"
 #endif /* _32BIT_FIXED_POINT */
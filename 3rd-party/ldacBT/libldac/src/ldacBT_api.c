@@ -32,6 +32,7 @@ LDACBT_API HANDLE_LDAC_BT ldacBT_get_handle( void )
     HANDLE_LDAC_BT hLdacBT;
     hLdacBT = (HANDLE_LDAC_BT)malloc( sizeof(STRUCT_LDACBT_HANDLE) );
     if( hLdacBT == NULL ){ return NULL; }
+    hLdacBT->flg_static = FALSE;
 
     /* Get ldaclib Handler */
     if( (hLdacBT->hLDAC = ldaclib_get_handle()) == NULL ){
@@ -43,6 +44,56 @@ LDACBT_API HANDLE_LDAC_BT ldacBT_get_handle( void )
     return hLdacBT;
 }
 
+/* LDACBT_STATIC_SIZE_MAX has to hold the handle with the sizes of the build target, and whatever
+   ldaclib takes behind it */
+typedef char ldacbt_static_size_check[
+    (LDACBT_STATIC_HDL_SZ + LDAC_STATIC_MEMORY_SIZE_MAX <= LDACBT_STATIC_SIZE_MAX) ? 1 : -1];
+
+/* Get size of static memory for LDAC handle */
+LDACBT_API int ldacBT_get_static_size( int cm )
+{
+    int size, size_cm;
+    int a_cm[] = {LDACBT_CHANNEL_MODE_MONO, LDACBT_CHANNEL_MODE_DUAL_CHANNEL, LDACBT_CHANNEL_MODE_STEREO};
+    int i;
+
+    if( cm != 0 ){
+        if( ldacBT_assert_cm( cm ) != LDACBT_ERR_NONE ){ return LDACBT_E_FAIL; }
+        if( ldaclib_get_static_memory_size( ldacBT_cm_to_cci( cm ), &size ) != LDAC_S_OK ){
+            return LDACBT_E_FAIL;
+        }
+    }else{
+        /* large enough for any channel mode */
+        size = 0;
+        for( i = 0; i < (int)(sizeof(a_cm)/sizeof(a_cm[0])); i++ ){
+            if( ldaclib_get_static_memory_size( ldacBT_cm_to_cci( a_cm[i] ), &size_cm ) != LDAC_S_OK ){
+                return LDACBT_E_FAIL;
+            }
+            if( size < size_cm ){ size = size_cm; }
+        }
+    }
+    return (int)LDACBT_STATIC_HDL_SZ + size;
+}
+
+/* Get LDAC handle in static memory */
+LDACBT_API HANDLE_LDAC_BT ldacBT_get_handle_static( void *p_mem, int size )
+{
+    HANDLE_LDAC_BT hLdacBT;
+    if( p_mem == NULL ){ return NULL; }
+    if( ((size_t)p_mem & (LDACBT_STATIC_ALIGN - 1)) != 0 ){ return NULL; }
+    if( size < (int)LDACBT_STATIC_HDL_SZ ){ return NULL; }
+
+    hLdacBT = (HANDLE_LDAC_BT)p_mem;
+    hLdacBT->flg_static = TRUE;
+
+    /* ldaclib handle and encoder follow in the same memory */
+    hLdacBT->hLDAC = ldaclib_get_handle_static( (char *)p_mem + LDACBT_STATIC_HDL_SZ,
+                                                size - (int)LDACBT_STATIC_HDL_SZ );
+    if( hLdacBT->hLDAC == NULL ){ return NULL; }
+
+    ldacBT_param_clear( hLdacBT );
+    return hLdacBT;
+}
+
 /* Free LDAC handle */
 LDACBT_API void ldacBT_free_handle( HANDLE_LDAC_BT hLdacBT )
 {
@@ -57,8 +108,10 @@ LDACBT_API void ldacBT_free_handle( HANDLE_LDAC_BT hLdacBT )
         ldaclib_free_handle( hLdacBT->hLDAC );
         hLdacBT->hLDAC = NULL;
     }
-    /* free ldacbt handle */
-    free( hLdacBT );
+    /* free ldacbt handle, static memory is only given back to the caller */
+    if( !hLdacBT->flg_static ){
+        free( hLdacBT );
+    }
 }
 
 /* Close LDAC handle */
@@ -343,9 +396,48 @@ LDACBT_API int  ldacBT_alter_eqmid_priority( HANDLE_LDAC_BT hLdacBT, int priorit
     return LDACBT_S_OK;
 }
 
-/* LDAC encode proccess */
-LDACBT_API int ldacBT_encode( HANDLE_LDAC_BT hLdacBT, void *p_pcm, int *pcm_used,
-                          unsigned char *p_stream, int *stream_sz, int *frame_num )
+/* Set parallel channel processing */
+LDACBT_API int ldacBT_set_channel_parallel( HANDLE_LDAC_BT hLdacBT, LDACBT_CH_JOB_START start,
+                                        LDACBT_CH_JOB_WAIT wait, void *user )
+{
+    if( hLdacBT == NULL ){ return LDACBT_E_FAIL; }
+    if( (start != NULL) && (wait == NULL) ){
+        hLdacBT->error_code_api = LDACBT_ERR_ILL_PARAM;
+        return LDACBT_E_FAIL;
+    }
+
+    ldaclib_set_channel_parallel( hLdacBT->hLDAC, start, wait, user );
+    return LDACBT_S_OK;
+}
+
+/* Set encoder stage probes */
+LDACBT_API int ldacBT_set_profile_hook( HANDLE_LDAC_BT hLdacBT, LDACBT_PROF_HOOK begin,
+                                        LDACBT_PROF_HOOK end, void *user )
+{
+    if( hLdacBT == NULL ){ return LDACBT_E_FAIL; }
+
+    if( LDAC_FAILED(ldaclib_set_profile_hook( hLdacBT->hLDAC, begin, end, user )) ){
+        hLdacBT->error_code_api = LDACBT_ERR_NOT_IMPLEMENTED;
+        return LDACBT_E_FAIL;
+    }
+    return LDACBT_S_OK;
+}
+
+/* Set frame status analysis mode */
+LDACBT_API int ldacBT_set_sigana_mode( HANDLE_LDAC_BT hLdacBT, int mode )
+{
+    if( hLdacBT == NULL ){ return LDACBT_E_FAIL; }
+
+    if( LDAC_FAILED(ldaclib_set_sigana_mode( hLdacBT->hLDAC, mode )) ){
+        hLdacBT->error_code_api = LDACBT_ERR_ILL_PARAM;
+        return LDACBT_E_FAIL;
+    }
+    return LDACBT_S_OK;
+}
+
+/* LDAC encode proccess, from the pcm ring or from a view of the caller's pcm */
+LDAC_HOT_FUNC static int ldacBT_encode_core( HANDLE_LDAC_BT hLdacBT, void *p_pcm, const LDACBT_PCM_VIEW *p_view,
+                          int *pcm_used, unsigned char *p_stream, int *stream_sz, int *frame_num )
 {
     LDAC_RESULT result;
     LDACBT_SMPL_FMT_T fmt;
@@ -392,7 +484,17 @@ LDACBT_API int ldacBT_encode( HANDLE_LDAC_BT hLdacBT, void *p_pcm, int *pcm_used
     ppcmring = &hLdacBT->pcmring;
 
     /* update input pcm data */
-    if( p_pcm != NULL ){
+    if( p_view != NULL ){
+        /* the view is read in place, one whole frame at a time */
+        if( (fmt != LDACBT_SMPL_FMT_S16) || (ppcmring->nsmpl != 0) ){
+            hLdacBT->error_code_api = LDACBT_ERR_ILL_PARAM;
+            return LDACBT_E_FAIL;
+        }
+        if( p_view->silent || (p_view->a_nsmpl[0] + p_view->a_nsmpl[1] >= hLdacBT->frm_samples) ){
+            flg_Do_Encode = 1;
+        }
+    }
+    else if( p_pcm != NULL ){
         int nByteCpy, sz;
         nByteCpy = LDACBT_ENC_LSU * wl * ch;
         sz = ppcmring->nsmpl * wl * ch + nByteCpy;
@@ -524,7 +626,19 @@ LDACBT_API int ldacBT_encode( HANDLE_LDAC_BT hLdacBT, void *p_pcm, int *pcm_used
     p_ldac_transport_frame = ptfbuf->buf + ptfbuf->used;
 
     /* Encode Frame */
-    if( ppcmring->nsmpl > 0 ){
+    if( (p_view != NULL) && p_view->silent ){
+        result = ldaclib_encode_silence(hLdacBT->hLDAC,
+                         p_ldac_transport_frame+LDACBT_FRMHDRBYTES, &frmlen_wrote);
+        *pcm_used = hLdacBT->frm_samples * wl * ch;
+    }
+    else if( p_view != NULL ){
+        result = ldaclib_encode_s16_view(hLdacBT->hLDAC, (const short **)p_view->ap_span,
+                         p_view->a_nsmpl, p_view->gain,
+                         p_ldac_transport_frame+LDACBT_FRMHDRBYTES, &frmlen_wrote);
+        /* the frame is taken even if encoding failed, as ldacBT_encode() does with its ring */
+        *pcm_used = hLdacBT->frm_samples * wl * ch;
+    }
+    else if( ppcmring->nsmpl > 0 ){
         char *p_pcm_ring_r;
         int nsmpl_to_clr;
         nsmpl_to_clr = hLdacBT->frm_samples - ppcmring->nsmpl;
@@ -606,7 +720,7 @@ LDACBT_API int ldacBT_encode( HANDLE_LDAC_BT hLdacBT, void *p_pcm, int *pcm_used
         if( (( ptfbuf->used + frmlen_wrote) > hLdacBT->tx.tx_size) ||
             (  ptfbuf->nfrm_in >= LDACBT_NFRM_TX_MAX ) || 
             (( ptfbuf->used + frmlen_wrote) >= LDACBT_ENC_STREAM_BUF_SZ ) ||
-            ( p_pcm == NULL ) /* flush encode */
+            ( (p_pcm == NULL) && (p_view == NULL) ) /* flush encode */
             )
         {
             copy_data_ldac( ptfbuf->buf, p_stream, ptfbuf->used );
@@ -624,3 +738,47 @@ LDACBT_API int ldacBT_encode( HANDLE_LDAC_BT hLdacBT, void *p_pcm, int *pcm_used
 
     return LDACBT_S_OK;
 }
+
+/* LDAC encode proccess */
+LDAC_HOT_FUNC LDACBT_API int ldacBT_encode( HANDLE_LDAC_BT hLdacBT, void *p_pcm, int *pcm_used,
+                          unsigned char *p_stream, int *stream_sz, int *frame_num )
+{
+    return ldacBT_encode_core( hLdacBT, p_pcm, NULL, pcm_used, p_stream, stream_sz, frame_num );
+}
+
+/* LDAC encode proccess, reading interleaved 16bit pcm in place */
+LDAC_HOT_FUNC LDACBT_API int ldacBT_encode_s16_view( HANDLE_LDAC_BT hLdacBT, const short *p_pcm0, int nsmpl0,
+                          const short *p_pcm1, int nsmpl1, int gain, int *pcm_used,
+                          unsigned char *p_stream, int *stream_sz, int *frame_num )
+{
+    LDACBT_PCM_VIEW view;
+
+    if( hLdacBT == NULL ){
+        return LDACBT_E_FAIL;
+    }
+    if( (p_pcm0 == NULL) || (nsmpl0 < 0) || (nsmpl1 < 0) || ((p_pcm1 == NULL) && (nsmpl1 > 0)) ||
+        (gain < 0) || (gain > LDACBT_GAIN_UNITY) ){
+        hLdacBT->error_code_api = LDACBT_ERR_ILL_PARAM;
+        return LDACBT_E_FAIL;
+    }
+
+    view.ap_span[0] = p_pcm0;
+    view.ap_span[1] = p_pcm1;
+    view.a_nsmpl[0] = nsmpl0;
+    view.a_nsmpl[1] = nsmpl1;
+    view.gain = gain;
+    view.silent = 0;
+    return ldacBT_encode_core( hLdacBT, NULL, &view, pcm_used, p_stream, stream_sz, frame_num );
+}
+
+/* LDAC encode proccess, one frame of digital silence */
+LDAC_HOT_FUNC LDACBT_API int ldacBT_encode_silence( HANDLE_LDAC_BT hLdacBT, int *pcm_used,
+                          unsigned char *p_stream, int *stream_sz, int *frame_num )
+{
+    LDACBT_PCM_VIEW view;
+
+    clear_data_ldac( &view, sizeof(view) );
+    view.gain = LDACBT_GAIN_UNITY;
+    view.silent = 1;
+    return ldacBT_encode_core( hLdacBT, NULL, &view, pcm_used, p_stream, stream_sz, frame_num );
+}
@@ -21,9 +21,7 @@
 
 enum {
 /* undocumented settings. for internal use only */
-    LDACBT_EQMID_Q0 = LDACBT_EQMID_MQ + 1,
-    LDACBT_EQMID_Q1,
-    LDACBT_EQMID_Q2,
+    LDACBT_EQMID_Q2 = LDACBT_EQMID_Q1 + 1,
     LDACBT_EQMID_Q3,
     LDACBT_EQMID_Q4,
     LDACBT_EQMID_Q5,
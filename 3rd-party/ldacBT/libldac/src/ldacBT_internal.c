@@ -121,7 +121,7 @@ DECLFUNC void ldacBT_param_clear(HANDLE_LDAC_BT hLdacBT)
 }
 
 /* get ldaclib error code */
-DECLFUNC int ldacBT_check_ldaclib_error_code(HANDLE_LDAC_BT hLdacBT)
+LDAC_HOT_FUNC DECLFUNC int ldacBT_check_ldaclib_error_code(HANDLE_LDAC_BT hLdacBT)
 {
     HANDLE_LDAC hData;
     int error_code, internal_error_code;
@@ -217,7 +217,7 @@ DECLFUNC void ldacBT_set_eqmid_core( HANDLE_LDAC_BT hLdacBT, int eqmid )
 }
 
 /* Split LR interleaved PCM into buffer that for LDAC encode. */
-DECLFUNC void ldacBT_prepare_pcm_encode( void *pbuff, char **ap_pcm, int nsmpl, int nch,
+LDAC_HOT_FUNC DECLFUNC void ldacBT_prepare_pcm_encode( void *pbuff, char **ap_pcm, int nsmpl, int nch,
                      LDACBT_SMPL_FMT_T fmt )
 {
     int i;
@@ -49,6 +49,10 @@ extern "C" {
 #define LDACBT_PCM_WLEN_MAX 4
 /* The size of LDACBT_TRANSPORT_FRM_BUF's buffer. Unit:Byte  */
 #define LDACBT_ENC_STREAM_BUF_SZ 1024
+/* alignment of the handles placed in static memory */
+#define LDACBT_STATIC_ALIGN 8
+#define LDACBT_STATIC_HDL_SZ \
+    ((sizeof(STRUCT_LDACBT_HANDLE) + LDACBT_STATIC_ALIGN - 1) & ~(size_t)(LDACBT_STATIC_ALIGN - 1))
 /* The size of rtp header and so on. Unit:Byte */
 /*  = sizeof(struct rtp_header) + sizeof(struct rtp_payload) + 1 (scms-t). */
 #define LDACBT_TX_HEADER_SIZE 18
@@ -142,9 +146,18 @@ typedef struct _ldacbt_pcm_ring_buf {
     int nsmpl;
 } LDACBT_PCM_RING_BUF;
 
+/* A read view of interleaved 16bit pcm owned by the caller, in up to two spans. */
+typedef struct _st_ldacbt_pcm_view {
+    const short *ap_span[2];
+    int a_nsmpl[2]; /* samples per channel */
+    int gain;       /* Q15 */
+    int silent;     /* a frame of digital silence, the spans are not read */
+} LDACBT_PCM_VIEW;
+
 /* The LDACBT handle. */
 typedef struct _st_ldacbt_handle {
     HANDLE_LDAC hLDAC;
+    int flg_static; /* placed in caller memory by ldacBT_get_handle_static() */
     LDACBT_PROCMODE proc_mode;
     int error_code;
     int error_code_api;
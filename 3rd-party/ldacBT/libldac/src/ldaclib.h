@@ -56,6 +56,31 @@ typedef enum {
     LDAC_SMPL_FMT_MAX = 0x7fffffff
 } LDAC_SMPL_FMT_T;
 
+/* Helper for processing one channel on another core */
+typedef void (*LDAC_CHJOB)(void *);
+typedef void (*LDAC_CHJOB_START)(LDAC_CHJOB, void *, void *);
+typedef void (*LDAC_CHJOB_WAIT)(void *);
+
+/* Unity gain of the in place input, Q15 */
+#define LDAC_GAIN_UNITY 0x8000
+
+/* Encoder stage probes, active when built with LDAC_PROFILE */
+#define LDAC_PROF_MDCT     0
+#define LDAC_PROF_SIGANA   1
+#define LDAC_PROF_NORM     2
+#define LDAC_PROF_BITALLOC 3
+#define LDAC_PROF_QUANT    4
+#define LDAC_PROF_PACK     5
+#define LDAC_PROF_NUM      6
+typedef void (*LDAC_PROF_HOOK)(int, void *);
+
+/* Frame status analysis */
+#define LDAC_SIGANA_FULL 0
+#define LDAC_SIGANA_FAST 1
+
+/* Bound of ldaclib_get_static_memory_size() for any channel config, checked at compile time */
+#define LDAC_STATIC_MEMORY_SIZE_MAX (13*1024)
+
 /***************************************************************************************************
     Function Declarations
 ***************************************************************************************************/
@@ -74,6 +99,8 @@ DECLSPEC LDAC_RESULT ldaclib_get_channel_config_index(int, int *);
 DECLSPEC LDAC_RESULT ldaclib_check_nlnn_shift(int, int);
 
 DECLSPEC HANDLE_LDAC ldaclib_get_handle(void);
+DECLSPEC LDAC_RESULT ldaclib_get_static_memory_size(int, int *);
+DECLSPEC HANDLE_LDAC ldaclib_get_handle_static(void *, int);
 DECLSPEC LDAC_RESULT ldaclib_free_handle(HANDLE_LDAC);
 
 DECLSPEC LDAC_RESULT ldaclib_set_config_info(HANDLE_LDAC, int, int, int, int);
@@ -88,6 +115,11 @@ DECLSPEC LDAC_RESULT ldaclib_set_encode_info(HANDLE_LDAC, int, int, int, int, in
 DECLSPEC LDAC_RESULT ldaclib_init_encode(HANDLE_LDAC);
 DECLSPEC LDAC_RESULT ldaclib_free_encode(HANDLE_LDAC);
 DECLSPEC LDAC_RESULT ldaclib_encode(HANDLE_LDAC, char *[], LDAC_SMPL_FMT_T, unsigned char *, int *);
+DECLSPEC LDAC_RESULT ldaclib_encode_s16_view(HANDLE_LDAC, const short *[], const int *, int, unsigned char *, int *);
+DECLSPEC LDAC_RESULT ldaclib_encode_silence(HANDLE_LDAC, unsigned char *, int *);
+DECLSPEC LDAC_RESULT ldaclib_set_channel_parallel(HANDLE_LDAC, LDAC_CHJOB_START, LDAC_CHJOB_WAIT, void *);
+DECLSPEC LDAC_RESULT ldaclib_set_profile_hook(HANDLE_LDAC, LDAC_PROF_HOOK, LDAC_PROF_HOOK, void *);
+DECLSPEC LDAC_RESULT ldaclib_set_sigana_mode(HANDLE_LDAC, int);
 DECLSPEC LDAC_RESULT ldaclib_flush_encode(HANDLE_LDAC, LDAC_SMPL_FMT_T, unsigned char *, int *);
 
 
@@ -134,6 +166,7 @@ DECLSPEC LDAC_RESULT ldaclib_clear_internal_error_code(HANDLE_LDAC);
 
 #define LDAC_ERR_ILL_SYNCWORD             516
 #define LDAC_ERR_ILL_SMPL_FORMAT          517
+#define LDAC_ERR_ILL_PARAM                518
 
 #define LDAC_ERR_ASSERT_SAMPLING_RATE     530
 #define LDAC_ERR_ASSERT_SUP_SAMPLING_RATE 531
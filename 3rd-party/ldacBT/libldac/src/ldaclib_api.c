@@ -305,6 +305,54 @@ void)
     return hData;
 }
 
+/***************************************************************************************************
+    Get Static Memory Size
+***************************************************************************************************/
+/* Two channels in two blocks is the most any channel config takes. The sizes are those of the
+   build target, a target whose structures outgrow LDAC_STATIC_MEMORY_SIZE_MAX fails to compile. */
+typedef char ldac_static_memory_size_check[
+    (LDAC_ALIGN_SIZE(sizeof(HANDLE_LDAC_STRUCT))
+     + LDAC_PRCNCH * (LDAC_ALIGN_SIZE(sizeof(AC)) + LDAC_ALIGN_SIZE(sizeof(ACSUB)))
+     + LDAC_PRCNCH * LDAC_ALIGN_SIZE(sizeof(AB)) <= LDAC_STATIC_MEMORY_SIZE_MAX) ? 1 : -1];
+
+DECLSPEC LDAC_RESULT ldaclib_get_static_memory_size(
+int chconfig_id,
+int *p_size)
+{
+    if (!ldaclib_assert_channel_config_index(chconfig_id)) {
+        return LDAC_E_FAIL;
+    }
+
+    *p_size = (int)(align_ldac(sizeof(HANDLE_LDAC_STRUCT)) + get_encode_memory_size_ldac(chconfig_id));
+
+    return LDAC_S_OK;
+}
+
+/***************************************************************************************************
+    Get Handle in Static Memory
+***************************************************************************************************/
+DECLSPEC HANDLE_LDAC ldaclib_get_handle_static(
+void *p_mem,
+int size)
+{
+    HANDLE_LDAC hData;
+    char *p_tmp = (char *)p_mem;
+    size_t hdl_size = align_ldac(sizeof(HANDLE_LDAC_STRUCT));
+
+    if ((p_tmp == (char *)NULL) || (size < 0) || ((size_t)size < hdl_size)) {
+        return (HANDLE_LDAC)NULL;
+    }
+
+    hData = (HANDLE_LDAC)p_tmp;
+    clear_data_ldac(hData, sizeof(HANDLE_LDAC_STRUCT));
+    hData->sfinfo.p_membase = p_tmp + hdl_size;
+    hData->sfinfo.p_mempos = hData->sfinfo.p_membase;
+    hData->sfinfo.p_memend = p_tmp + size;
+    hData->error_code = LDAC_ERR_NONE;
+
+    return hData;
+}
+
 /***************************************************************************************************
     Free Handle
 ***************************************************************************************************/
@@ -640,6 +688,8 @@ HANDLE_LDAC hData)
 
     set_mdct_table_ldac(hData->nlnn);
 
+    hData->nsilent = 0;
+
     result = init_encode_ldac(p_sfinfo);
     if (result != LDAC_S_OK) {
         hData->error_code = LDAC_ERR_ENC_INIT_ALLOC;
@@ -663,38 +713,36 @@ HANDLE_LDAC hData)
 }
 
 /***************************************************************************************************
-    Encode
+    Subfunction: Encode the Frame Held in the Time Windows
 ***************************************************************************************************/
-DECLSPEC LDAC_RESULT ldaclib_encode(
+LDAC_HOT_FUNC static LDAC_RESULT ldaclib_encode_frame(
 HANDLE_LDAC hData,
-char *ap_pcm[],
-LDAC_SMPL_FMT_T sample_format,
 unsigned char *p_stream,
 int *p_nbytes_used)
 {
     SFINFO *p_sfinfo = &hData->sfinfo;
     int loc = 0;
     int error_code;
-    int frame_length;
-
+    int frame_length = p_sfinfo->cfg.frame_length;
 
-    if (!ldaclib_assert_sample_format(sample_format)) {
-        hData->error_code = LDAC_ERR_ILL_SMPL_FORMAT;
-        return LDAC_E_FAIL;
+    if (p_sfinfo->chjob_start != NULL) {
+        error_code = encode_parallel_ldac(p_sfinfo, hData->nlnn, hData->nbands, hData->grad_mode,
+                hData->grad_qu_l, hData->grad_qu_h, hData->grad_os_l, hData->grad_os_h,
+                hData->abc_status);
     }
+    else {
+        prof_begin_ldac(p_sfinfo, LDAC_PROF_MDCT);
+        proc_mdct_ldac(p_sfinfo, hData->nlnn);
+        prof_end_ldac(p_sfinfo, LDAC_PROF_MDCT);
 
-    frame_length = p_sfinfo->cfg.frame_length;
-    clear_data_ldac(p_stream, frame_length*sizeof(unsigned char));
-
-    set_input_pcm_ldac(p_sfinfo, ap_pcm, sample_format, hData->nlnn);
-
-    proc_mdct_ldac(p_sfinfo, hData->nlnn);
-
-    p_sfinfo->cfg.frame_status = ana_frame_status_ldac(p_sfinfo, hData->nlnn);
+        prof_begin_ldac(p_sfinfo, LDAC_PROF_SIGANA);
+        p_sfinfo->cfg.frame_status = ana_frame_status_ldac(p_sfinfo, hData->nlnn);
+        prof_end_ldac(p_sfinfo, LDAC_PROF_SIGANA);
 
-    error_code = encode_ldac(p_sfinfo, hData->nbands, hData->grad_mode,
-            hData->grad_qu_l, hData->grad_qu_h, hData->grad_os_l, hData->grad_os_h,
-            hData->abc_status);
+        error_code = encode_ldac(p_sfinfo, hData->nbands, hData->grad_mode,
+                hData->grad_qu_l, hData->grad_qu_h, hData->grad_os_l, hData->grad_os_h,
+                hData->abc_status);
+    }
     if (LDAC_ERROR(error_code) && !LDAC_FATAL_ERROR(error_code)) {
         int error_code2;
         error_code2 = pack_null_data_frame_ldac(p_sfinfo, (STREAM *)p_stream, &loc, p_nbytes_used);
@@ -707,7 +755,9 @@ int *p_nbytes_used)
         return LDAC_S_FALSE;
     }
 
+    prof_begin_ldac(p_sfinfo, LDAC_PROF_PACK);
     error_code = pack_raw_data_frame_ldac(p_sfinfo, (STREAM *)p_stream, &loc, p_nbytes_used);
+    prof_end_ldac(p_sfinfo, LDAC_PROF_PACK);
     if (LDAC_FATAL_ERROR(error_code)) {
         int error_code2;
         loc = 0;
@@ -725,6 +775,163 @@ int *p_nbytes_used)
     return LDAC_S_OK;
 }
 
+/***************************************************************************************************
+    Encode
+***************************************************************************************************/
+LDAC_HOT_FUNC DECLSPEC LDAC_RESULT ldaclib_encode(
+HANDLE_LDAC hData,
+char *ap_pcm[],
+LDAC_SMPL_FMT_T sample_format,
+unsigned char *p_stream,
+int *p_nbytes_used)
+{
+    SFINFO *p_sfinfo = &hData->sfinfo;
+
+    if (!ldaclib_assert_sample_format(sample_format)) {
+        hData->error_code = LDAC_ERR_ILL_SMPL_FORMAT;
+        return LDAC_E_FAIL;
+    }
+
+    clear_data_ldac(p_stream, p_sfinfo->cfg.frame_length*sizeof(unsigned char));
+
+    set_input_pcm_ldac(p_sfinfo, ap_pcm, sample_format, hData->nlnn);
+    hData->nsilent = 0;
+
+    return ldaclib_encode_frame(hData, p_stream, p_nbytes_used);
+}
+
+/***************************************************************************************************
+    Encode from Interleaved 16bit PCM in Place
+***************************************************************************************************/
+LDAC_HOT_FUNC DECLSPEC LDAC_RESULT ldaclib_encode_s16_view(
+HANDLE_LDAC hData,
+const short *ap_span[],
+const int *a_nsmpl,
+int gain,
+unsigned char *p_stream,
+int *p_nbytes_used)
+{
+    SFINFO *p_sfinfo = &hData->sfinfo;
+
+    if ((gain < 0) || (LDAC_GAIN_UNITY < gain)) {
+        hData->error_code = LDAC_ERR_ILL_PARAM;
+        return LDAC_E_FAIL;
+    }
+
+    if (a_nsmpl[0] + a_nsmpl[1] < npow2_ldac(hData->nlnn)) {
+        hData->error_code = LDAC_ERR_ILL_PARAM;
+        return LDAC_E_FAIL;
+    }
+
+    clear_data_ldac(p_stream, p_sfinfo->cfg.frame_length*sizeof(unsigned char));
+
+    set_input_pcm_view_ldac(p_sfinfo, ap_span, a_nsmpl, gain, hData->nlnn);
+    hData->nsilent = 0;
+
+    return ldaclib_encode_frame(hData, p_stream, p_nbytes_used);
+}
+
+/***************************************************************************************************
+    Encode a Frame of Digital Silence
+***************************************************************************************************/
+LDAC_HOT_FUNC DECLSPEC LDAC_RESULT ldaclib_encode_silence(
+HANDLE_LDAC hData,
+unsigned char *p_stream,
+int *p_nbytes_used)
+{
+    SFINFO *p_sfinfo = &hData->sfinfo;
+    AC *p_ac;
+    int ich;
+    int loc = 0;
+    int error_code;
+
+    clear_data_ldac(p_stream, p_sfinfo->cfg.frame_length*sizeof(unsigned char));
+
+    set_input_silence_ldac(p_sfinfo, hData->nlnn);
+
+    /* The window still holds the decay of the last sound */
+    if (++hData->nsilent < LDAC_NFRAME) {
+        return ldaclib_encode_frame(hData, p_stream, p_nbytes_used);
+    }
+    hData->nsilent = LDAC_NFRAME;
+
+    error_code = pack_null_data_frame_ldac(p_sfinfo, (STREAM *)p_stream, &loc, p_nbytes_used);
+    if (LDAC_FATAL_ERROR(error_code)) {
+        clear_data_ldac(p_stream, p_sfinfo->cfg.frame_length*sizeof(unsigned char));
+        hData->error_code = error_code;
+        return LDAC_E_FAIL;
+    }
+
+    /* Leave the frame analysis as a silent window would */
+    for (ich = 0; ich < p_sfinfo->cfg.ch; ich++) {
+        p_ac = p_sfinfo->ap_ac[ich];
+        p_ac->frmana_zcros = -1;
+        p_ac->frmana_status = LDAC_FRMSTAT_LEV_3;
+        p_ac->frmana_steady = 0;
+        p_ac->frmana_skip = 0;
+    }
+    p_sfinfo->cfg.frame_status = LDAC_FRMSTAT_LEV_3;
+
+    return LDAC_S_OK;
+}
+
+/***************************************************************************************************
+    Set Channel Parallel Processing
+***************************************************************************************************/
+DECLSPEC LDAC_RESULT ldaclib_set_channel_parallel(
+HANDLE_LDAC hData,
+LDAC_CHJOB_START chjob_start,
+LDAC_CHJOB_WAIT chjob_wait,
+void *p_user)
+{
+    hData->sfinfo.chjob_start = chjob_start;
+    hData->sfinfo.chjob_wait = chjob_wait;
+    hData->sfinfo.p_chjob_user = p_user;
+
+    return LDAC_S_OK;
+}
+
+/***************************************************************************************************
+    Set Profile Hook
+***************************************************************************************************/
+DECLSPEC LDAC_RESULT ldaclib_set_profile_hook(
+HANDLE_LDAC hData,
+LDAC_PROF_HOOK prof_begin,
+LDAC_PROF_HOOK prof_end,
+void *p_user)
+{
+#ifdef LDAC_PROFILE
+    hData->sfinfo.prof_begin = prof_begin;
+    hData->sfinfo.prof_end = prof_end;
+    hData->sfinfo.p_prof_user = p_user;
+
+    return LDAC_S_OK;
+#else /* LDAC_PROFILE */
+    (void)hData;
+    (void)prof_begin;
+    (void)prof_end;
+    (void)p_user;
+
+    return LDAC_E_FAIL;
+#endif /* LDAC_PROFILE */
+}
+
+/***************************************************************************************************
+    Set Frame Status Analysis Mode
+***************************************************************************************************/
+DECLSPEC LDAC_RESULT ldaclib_set_sigana_mode(
+HANDLE_LDAC hData,
+int sigana_mode)
+{
+    if ((sigana_mode != LDAC_SIGANA_FULL) && (sigana_mode != LDAC_SIGANA_FAST)) {
+        return LDAC_E_FAIL;
+    }
+
+    hData->sfinfo.sigana_mode = sigana_mode;
+
+    return LDAC_S_OK;
+}
+
 /***************************************************************************************************
     Flush Encode
 ***************************************************************************************************/
@@ -19,8 +19,9 @@
 /***************************************************************************************************
     Subfunction: Process MDCT Core
 ***************************************************************************************************/
-static void proc_mdct_core_ldac(
-INT32 *p_x,
+LDAC_HOT_FUNC static void proc_mdct_core_ldac(
+INT32 *p_x0,
+INT32 *p_x1,
 INT32 *p_y,
 int nlnn)
 {
@@ -32,6 +33,7 @@ int nlnn)
     const int *p_p;
     const INT32 *p_w, *p_c, *p_s;
     INT32 a_work[LDAC_MAXLSU];
+    INT32 absmax0, absmax1;
     INT32 g0, g1, g2, g3;
 
     i = nlnn - LDAC_1FSLNN;
@@ -41,7 +43,9 @@ int nlnn)
     p_p = gaa_perm_ldac[i];
 
     /* Block Floating */
-    shift = LDAC_C_BLKFLT - get_bit_length_ldac(get_absmax_ldac(p_x, nsmpl<<1)) - 1;
+    absmax0 = get_absmax_ldac(p_x0, nsmpl);
+    absmax1 = get_absmax_ldac(p_x1, nsmpl);
+    shift = LDAC_C_BLKFLT - get_bit_length_ldac(max_ldac(absmax0, absmax1)) - 1;
     if (shift < 0) {
         shift = 0;
     }
@@ -49,23 +53,23 @@ int nlnn)
     /* Windowing */
     if (LDAC_Q_MDCT_WIN-shift > 0){
         for (i = 0; i < nsmpl>>1; i++) {
-            g0 = mul_rsftrnd_ldac(-p_x[3*nsmpl/2-1-i], p_w[nsmpl/2+i], LDAC_Q_MDCT_WIN-shift);
-            g1 = mul_rsftrnd_ldac(-p_x[3*nsmpl/2+i], p_w[nsmpl/2-1-i], LDAC_Q_MDCT_WIN-shift);
+            g0 = mul_rsftrnd_ldac(-p_x1[nsmpl/2-1-i], p_w[nsmpl/2+i], LDAC_Q_MDCT_WIN-shift);
+            g1 = mul_rsftrnd_ldac(-p_x1[nsmpl/2+i], p_w[nsmpl/2-1-i], LDAC_Q_MDCT_WIN-shift);
             a_work[p_p[i]] = g0 + g1;
 
-            g0 = mul_rsftrnd_ldac(p_x[i], p_w[i], LDAC_Q_MDCT_WIN-shift);
-            g1 = mul_rsftrnd_ldac(-p_x[nsmpl-1-i], p_w[nsmpl-1-i], LDAC_Q_MDCT_WIN-shift);
+            g0 = mul_rsftrnd_ldac(p_x0[i], p_w[i], LDAC_Q_MDCT_WIN-shift);
+            g1 = mul_rsftrnd_ldac(-p_x0[nsmpl-1-i], p_w[nsmpl-1-i], LDAC_Q_MDCT_WIN-shift);
             a_work[p_p[nsmpl/2+i]] = g0 + g1;
         }
     }
     else{
         for (i = 0; i < nsmpl>>1; i++) {
-            g0 = mul_lsftrnd_ldac(-p_x[3*nsmpl/2-1-i], p_w[nsmpl/2+i], LDAC_Q_MDCT_WIN-shift);
-            g1 = mul_lsftrnd_ldac(-p_x[3*nsmpl/2+i], p_w[nsmpl/2-1-i], LDAC_Q_MDCT_WIN-shift);
+            g0 = mul_lsftrnd_ldac(-p_x1[nsmpl/2-1-i], p_w[nsmpl/2+i], LDAC_Q_MDCT_WIN-shift);
+            g1 = mul_lsftrnd_ldac(-p_x1[nsmpl/2+i], p_w[nsmpl/2-1-i], LDAC_Q_MDCT_WIN-shift);
             a_work[p_p[i]] = g0 + g1;
 
-            g0 = mul_lsftrnd_ldac(p_x[i], p_w[i], LDAC_Q_MDCT_WIN-shift);
-            g1 = mul_lsftrnd_ldac(-p_x[nsmpl-1-i], p_w[nsmpl-1-i], LDAC_Q_MDCT_WIN-shift);
+            g0 = mul_lsftrnd_ldac(p_x0[i], p_w[i], LDAC_Q_MDCT_WIN-shift);
+            g1 = mul_lsftrnd_ldac(-p_x0[nsmpl-1-i], p_w[nsmpl-1-i], LDAC_Q_MDCT_WIN-shift);
             a_work[p_p[nsmpl/2+i]] = g0 + g1;
         }
     }
@@ -126,20 +130,34 @@ int nlnn)
     return;
 }
 
+/***************************************************************************************************
+    Process MDCT for One Channel
+***************************************************************************************************/
+LDAC_HOT_FUNC DECLFUNC void proc_mdct_channel_ldac(
+AC *p_ac,
+int nlnn)
+{
+    ACSUB *p_acsub = p_ac->p_acsub;
+    int nsmpl = npow2_ldac(nlnn);
+
+    proc_mdct_core_ldac(get_time_old_ldac(p_acsub, nsmpl), get_time_new_ldac(p_acsub, nsmpl),
+            p_acsub->a_spec, nlnn);
+
+    return;
+}
+
 /***************************************************************************************************
     Process MDCT
 ***************************************************************************************************/
-DECLFUNC void proc_mdct_ldac(
+LDAC_HOT_FUNC DECLFUNC void proc_mdct_ldac(
 SFINFO *p_sfinfo,
 int nlnn)
 {
-    AC *p_ac;
     int ich;
     int nchs = p_sfinfo->cfg.ch;
 
     for (ich = 0; ich < nchs; ich++) {
-        p_ac = p_sfinfo->ap_ac[ich];
-        proc_mdct_core_ldac(p_ac->p_acsub->a_time, p_ac->p_acsub->a_spec, nlnn);
+        proc_mdct_channel_ldac(p_sfinfo->ap_ac[ich], nlnn);
     }
 
     return;
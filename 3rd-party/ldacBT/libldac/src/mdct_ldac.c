@@ -20,7 +20,8 @@
     Subfunction: Process MDCT Core
 ***************************************************************************************************/
 static void proc_mdct_core_ldac(
-SCALAR *p_x,
+SCALAR *p_x0,
+SCALAR *p_x1,
 SCALAR *p_y,
 int nlnn)
 {
@@ -43,9 +44,9 @@ int nlnn)
 
     /* Windowing */
     for (i = 0; i < nsmpl>>1; i++) {
-        p_work[p_p[i]] = -p_x[3*nsmpl/2-1-i] * p_w[nsmpl/2+i] - p_x[3*nsmpl/2+i] * p_w[nsmpl/2-1-i];
+        p_work[p_p[i]] = -p_x1[nsmpl/2-1-i] * p_w[nsmpl/2+i] - p_x1[nsmpl/2+i] * p_w[nsmpl/2-1-i];
 
-        p_work[p_p[nsmpl/2+i]] = p_x[i] * p_w[i] - p_x[nsmpl-1-i] * p_w[nsmpl-1-i];
+        p_work[p_p[nsmpl/2+i]] = p_x0[i] * p_w[i] - p_x0[nsmpl-1-i] * p_w[nsmpl-1-i];
     }
 
     /* Butterfly */
@@ -94,6 +95,22 @@ int nlnn)
     return;
 }
 
+/***************************************************************************************************
+    Process MDCT for One Channel
+***************************************************************************************************/
+DECLFUNC void proc_mdct_channel_ldac(
+AC *p_ac,
+int nlnn)
+{
+    ACSUB *p_acsub = p_ac->p_acsub;
+    int nsmpl = npow2_ldac(nlnn);
+
+    proc_mdct_core_ldac(get_time_old_ldac(p_acsub, nsmpl), get_time_new_ldac(p_acsub, nsmpl),
+            p_acsub->a_spec, nlnn);
+
+    return;
+}
+
 /***************************************************************************************************
     Process MDCT
 ***************************************************************************************************/
@@ -101,13 +118,11 @@ DECLFUNC void proc_mdct_ldac(
 SFINFO *p_sfinfo,
 int nlnn)
 {
-    AC *p_ac;
     int ich;
     int nchs = p_sfinfo->cfg.ch;
 
     for (ich = 0; ich < nchs; ich++) {
-        p_ac = p_sfinfo->ap_ac[ich];
-        proc_mdct_core_ldac(p_ac->p_acsub->a_time, p_ac->p_acsub->a_spec, nlnn);
+        proc_mdct_channel_ldac(p_sfinfo->ap_ac[ich], nlnn);
     }
 
     return;
@@ -21,11 +21,14 @@
 ***************************************************************************************************/
 #define LDAC_ALLOC_LINE 8
 
+/* align_ldac() as a constant expression */
+#define LDAC_ALIGN_SIZE(size) (((((size)-1)/LDAC_ALLOC_LINE)+1) * LDAC_ALLOC_LINE)
+
 DECLFUNC size_t align_ldac(
 size_t size)
 {
     if (LDAC_ALLOC_LINE != 0) {
-        size = (((size-1)/LDAC_ALLOC_LINE)+1) * LDAC_ALLOC_LINE;
+        size = LDAC_ALIGN_SIZE(size);
     }
 
     return size;
@@ -42,8 +45,14 @@ size_t size)
     char *p_tmp;
 
     if (p_sfinfo->p_mempos != (char *)NULL) {
+        size = nmemb * align_ldac(size);
+        if ((p_sfinfo->p_memend != (char *)NULL) &&
+                (size > (size_t)(p_sfinfo->p_memend - p_sfinfo->p_mempos))) {
+            return (void *)NULL;
+        }
         p_tmp = p_sfinfo->p_mempos;
-        p_sfinfo->p_mempos += nmemb * align_ldac(size);
+        p_sfinfo->p_mempos += size;
+        clear_data_ldac(p_tmp, size);
     }
     else {
         p_tmp = calloc(nmemb, size);
@@ -19,7 +19,7 @@
 /***************************************************************************************************
     Pack and Store from MSB
 ***************************************************************************************************/
-static void pack_store_ldac(
+LDAC_HOT_FUNC static void pack_store_ldac(
 int idata,
 int nbits,
 STREAM *p_block,
@@ -47,7 +47,7 @@ int *p_loc)
 /***************************************************************************************************
     Pack Frame Header
 ***************************************************************************************************/
-DECLFUNC void pack_frame_header_ldac(
+LDAC_HOT_FUNC DECLFUNC void pack_frame_header_ldac(
 int smplrate_id,
 int chconfig_id,
 int frame_length,
@@ -72,7 +72,7 @@ STREAM *p_stream)
 /***************************************************************************************************
     Pack Frame Alignment
 ***************************************************************************************************/
-static void pack_frame_alignment_ldac(
+LDAC_HOT_FUNC static void pack_frame_alignment_ldac(
 STREAM *p_stream,
 int *p_loc,
 int nbytes_frame)
@@ -94,7 +94,7 @@ int nbytes_frame)
 ***************************************************************************************************/
 #define pack_block_alignment_ldac(p_stream, p_loc) pack_byte_alignment_ldac((p_stream), (p_loc))
 
-static void pack_byte_alignment_ldac(
+LDAC_HOT_FUNC static void pack_byte_alignment_ldac(
 STREAM *p_stream,
 int *p_loc)
 {
@@ -112,7 +112,7 @@ int *p_loc)
 /***************************************************************************************************
     Pack Band Info
 ***************************************************************************************************/
-static void pack_band_info_ldac(
+LDAC_HOT_FUNC static void pack_band_info_ldac(
 AB *p_ab,
 STREAM *p_stream,
 int *p_loc)
@@ -127,7 +127,7 @@ int *p_loc)
 /***************************************************************************************************
     Pack Gradient Data
 ***************************************************************************************************/
-static void pack_gradient_ldac(
+LDAC_HOT_FUNC static void pack_gradient_ldac(
 AB *p_ab,
 STREAM *p_stream,
 int *p_loc)
@@ -157,7 +157,7 @@ int *p_loc)
 /***************************************************************************************************
     Subfunction: Pack Scale Factor Data - Mode 0
 ***************************************************************************************************/
-static void pack_scale_factor_0_ldac(
+LDAC_HOT_FUNC static void pack_scale_factor_0_ldac(
 AC *p_ac,
 STREAM *p_stream,
 int *p_loc)
@@ -193,7 +193,7 @@ int *p_loc)
 /***************************************************************************************************
     Subfunction: Pack Scale Factor Data - Mode 1
 ***************************************************************************************************/
-static void pack_scale_factor_1_ldac(
+LDAC_HOT_FUNC static void pack_scale_factor_1_ldac(
 AC *p_ac,
 STREAM *p_stream,
 int *p_loc)
@@ -226,7 +226,7 @@ int *p_loc)
 /***************************************************************************************************
     Subfunction: Pack Scale Factor Data - Mode 2
 ***************************************************************************************************/
-static void pack_scale_factor_2_ldac(
+LDAC_HOT_FUNC static void pack_scale_factor_2_ldac(
 AC *p_ac,
 STREAM *p_stream,
 int *p_loc)
@@ -250,7 +250,7 @@ int *p_loc)
 /***************************************************************************************************
     Pack Scale Factor Data
 ***************************************************************************************************/
-static void pack_scale_factor_ldac(
+LDAC_HOT_FUNC static void pack_scale_factor_ldac(
 AC *p_ac,
 STREAM *p_stream,
 int *p_loc)
@@ -282,7 +282,7 @@ int *p_loc)
 /***************************************************************************************************
     Pack Spectrum Data
 ***************************************************************************************************/
-static void pack_spectrum_ldac(
+LDAC_HOT_FUNC static void pack_spectrum_ldac(
 AC *p_ac,
 STREAM *p_stream,
 int *p_loc)
@@ -330,7 +330,7 @@ int *p_loc)
 /***************************************************************************************************
     Pack Residual Data
 ***************************************************************************************************/
-static void pack_residual_ldac(
+LDAC_HOT_FUNC static void pack_residual_ldac(
 AC *p_ac,
 STREAM *p_stream,
 int *p_loc)
@@ -360,7 +360,7 @@ int *p_loc)
 /***************************************************************************************************
     Pack Audio Block
 ***************************************************************************************************/
-static int pack_audio_block_ldac(
+LDAC_HOT_FUNC static int pack_audio_block_ldac(
 AB *p_ab,
 STREAM *p_stream,
 int *p_loc)
@@ -419,7 +419,7 @@ int *p_loc)
 /***************************************************************************************************
     Pack Raw Data Frame
 ***************************************************************************************************/
-DECLFUNC int pack_raw_data_frame_ldac(
+LDAC_HOT_FUNC DECLFUNC int pack_raw_data_frame_ldac(
 SFINFO *p_sfinfo,
 STREAM *p_stream,
 int *p_loc,
@@ -458,7 +458,7 @@ static const STREAM saa_null_data_ldac[2][15] = {
     {0x07, 0xa0, 0x0a, 0x00, 0x20, 0xad, 0x51, 0x41, 0x24, 0x93, 0x00, 0x28, 0xa0, 0x92, 0x49},
 };
 
-DECLFUNC int pack_null_data_frame_ldac(
+LDAC_HOT_FUNC DECLFUNC int pack_null_data_frame_ldac(
 SFINFO *p_sfinfo,
 STREAM *p_stream,
 int *p_loc,
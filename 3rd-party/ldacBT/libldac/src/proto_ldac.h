@@ -21,20 +21,26 @@
     Function Declarations
 ***************************************************************************************************/
 /* encode_ldac.c */
+DECLFUNC size_t get_encode_memory_size_ldac(int);
 DECLFUNC LDAC_RESULT init_encode_ldac(SFINFO *);
 DECLFUNC void calc_initial_bits_ldac(SFINFO *);
 DECLFUNC void free_encode_ldac(SFINFO *);
 DECLFUNC int encode_ldac(SFINFO *, int, int, int, int, int, int, int);
+DECLFUNC int encode_parallel_ldac(SFINFO *, int, int, int, int, int, int, int, int);
 
 
 /* setpcm_ldac.c */
 DECLFUNC void set_input_pcm_ldac(SFINFO *, char *[], LDAC_SMPL_FMT_T, int);
+DECLFUNC void set_input_pcm_view_ldac(SFINFO *, const short *[], const int *, int, int);
+DECLFUNC void set_input_silence_ldac(SFINFO *, int);
 
 /* mdct_ldac.c */
+DECLFUNC void proc_mdct_channel_ldac(AC *, int);
 DECLFUNC void proc_mdct_ldac(SFINFO *, int);
 
 
 /* sigana_ldac.c */
+DECLFUNC int ana_channel_status_ldac(AC *, int, int);
 DECLFUNC int ana_frame_status_ldac(SFINFO *, int);
 
 /* bitalloc_ldac.c */
@@ -19,30 +19,15 @@
 /***************************************************************************************************
     Subfunction: Get Scale Factor Index
 ***************************************************************************************************/
-__inline static int get_scale_factor_id_ldac(
+/* ga_sf_ldac[i] is 1<<i below its last entry, so the index is the bit length of val, capped */
+LDAC_HOT_FUNC __inline static int get_scale_factor_id_ldac(
 INT32 val)
 {
-    int i;
-    int id, step;
+    int id;
 
-    if (ga_sf_ldac[0] > val) {
-        return 0;
-    }
-
-    id = LDAC_NIDSF >> 1;
-    step = LDAC_NIDSF >> 2;
-    for (i = 0; i < LDAC_IDSFBITS-1; i++) {
-        if (ga_sf_ldac[id] > val) {
-            id -= step;
-        }
-        else {
-            id += step;
-        }
-        step >>= 1;
-    }
-
-    if ((ga_sf_ldac[id] <= val) && (id < LDAC_NIDSF-1)) {
-        id++;
+    id = get_bit_length_ldac(val);
+    if (id > LDAC_NIDSF-1) {
+        id = LDAC_NIDSF-1;
     }
 
     return id;
@@ -51,33 +36,32 @@ INT32 val)
 /***************************************************************************************************
     Normalize Spectrum
 ***************************************************************************************************/
-static INT32 sa_val_ldac[LDAC_MAXNSPS] = { /* Q31 */
+LDAC_HOT_TABLE static const INT32 sa_val_ldac[LDAC_MAXNSPS] = { /* Q31 */
     0xa0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
     0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
 };
 
-DECLFUNC void norm_spectrum_ldac(
+LDAC_HOT_FUNC DECLFUNC void norm_spectrum_ldac(
 AC *p_ac)
 {
     int iqu, isp;
     int lsp, hsp;
     int nqus = p_ac->p_ab->nqus;
     int idsf;
-    INT32 maxspec, tmp;
+    INT32 absor;
     INT32 *p_spec = p_ac->p_acsub->a_spec;
 
     for (iqu = 0; iqu < nqus; iqu++) {
         lsp = ga_isp_ldac[iqu];
         hsp = ga_isp_ldac[iqu+1];
 
-        maxspec = abs(p_spec[lsp]);
-        for (isp = lsp+1; isp < hsp; isp++) {
-            tmp = abs(p_spec[isp]);
-            if (maxspec < tmp) {
-                maxspec = tmp;
-            }
+        /* The OR of the absolute values has the bit length of their maximum, without a branch */
+        /* per line. abs() of INT32_MIN is masked, the maximum never picks it either. */
+        absor = 0;
+        for (isp = lsp; isp < hsp; isp++) {
+            absor |= abs(p_spec[isp]);
         }
-        idsf = get_scale_factor_id_ldac(maxspec);
+        idsf = get_scale_factor_id_ldac(absor & 0x7fffffff);
 
         if (idsf > 0) {
             for (isp = lsp; isp < hsp; isp++) {
@@ -99,7 +83,7 @@ AC *p_ac)
 /***************************************************************************************************
     Subfunction: Quantize Spectrum Core
 ***************************************************************************************************/
-__inline static void quant_spectrum_core_ldac(
+LDAC_HOT_FUNC __inline static void quant_spectrum_core_ldac(
 AC *p_ac,
 int iqu)
 {
@@ -121,7 +105,7 @@ int iqu)
 /***************************************************************************************************
     Quantize Spectrum
 ***************************************************************************************************/
-DECLFUNC void quant_spectrum_ldac(
+LDAC_HOT_FUNC DECLFUNC void quant_spectrum_ldac(
 AC *p_ac)
 {
     int iqu;
@@ -137,7 +121,7 @@ AC *p_ac)
 /***************************************************************************************************
     Subfunction: Quantize Residual Spectrum Core
 ***************************************************************************************************/
-__inline static void quant_residual_core_ldac(
+LDAC_HOT_FUNC __inline static void quant_residual_core_ldac(
 AC *p_ac,
 int iqu)
 {
@@ -167,7 +151,7 @@ int iqu)
 /***************************************************************************************************
     Quantize Residual Spectrum
 ***************************************************************************************************/
-DECLFUNC void quant_residual_ldac(
+LDAC_HOT_FUNC DECLFUNC void quant_residual_ldac(
 AC *p_ac)
 {
     int iqu;
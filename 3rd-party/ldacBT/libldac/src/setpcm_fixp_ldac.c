@@ -19,7 +19,7 @@
 /***************************************************************************************************
     Subfunction: Convert from 16bit Signed Integer PCM
 ***************************************************************************************************/
-__inline static void byte_data_to_int_s16_ldac(
+LDAC_HOT_FUNC __inline static void byte_data_to_int_s16_ldac(
 char *p_in,
 INT32 *p_out,
 int nsmpl)
@@ -38,7 +38,7 @@ int nsmpl)
 /***************************************************************************************************
     Subfunction: Convert from 24bit Signed Integer PCM
 ***************************************************************************************************/
-__inline static void byte_data_to_int_s24_ldac(
+LDAC_HOT_FUNC __inline static void byte_data_to_int_s24_ldac(
 char *p_in,
 INT32 *p_out,
 int nsmpl)
@@ -66,7 +66,7 @@ int nsmpl)
 /***************************************************************************************************
     Subfunction: Convert from 32bit Signed Integer PCM
 ***************************************************************************************************/
-__inline static void byte_data_to_int_s32_ldac(
+LDAC_HOT_FUNC __inline static void byte_data_to_int_s32_ldac(
 char *p_in,
 INT32 *p_out,
 int nsmpl)
@@ -85,43 +85,99 @@ int nsmpl)
 /***************************************************************************************************
     Set Input PCM
 ***************************************************************************************************/
-DECLFUNC void set_input_pcm_ldac(
+LDAC_HOT_FUNC DECLFUNC void set_input_pcm_ldac(
 SFINFO *p_sfinfo,
 char *pp_pcm[],
 LDAC_SMPL_FMT_T format,
 int nlnn)
 {
-    int ich, isp;
+    int ich;
     int nchs = p_sfinfo->cfg.ch;
     int nsmpl = npow2_ldac(nlnn);
-    INT32 *p_time;
+    ACSUB *p_acsub;
 
     if (format == LDAC_SMPL_FMT_S16) {
         for (ich = 0; ich < nchs; ich++) {
-            p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
-            for (isp = 0; isp < nsmpl; isp++) {
-                p_time[isp] = p_time[nsmpl+isp];
-            }
-            byte_data_to_int_s16_ldac(pp_pcm[ich], p_time+nsmpl, nsmpl);
+            p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+            p_acsub->time_new ^= 1;
+            byte_data_to_int_s16_ldac(pp_pcm[ich], get_time_new_ldac(p_acsub, nsmpl), nsmpl);
         }
     }
     else if (format == LDAC_SMPL_FMT_S24) {
         for (ich = 0; ich < nchs; ich++) {
-            p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
-            for (isp = 0; isp < nsmpl; isp++) {
-                p_time[isp] = p_time[nsmpl+isp];
-            }
-            byte_data_to_int_s24_ldac(pp_pcm[ich], p_time+nsmpl, nsmpl);
+            p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+            p_acsub->time_new ^= 1;
+            byte_data_to_int_s24_ldac(pp_pcm[ich], get_time_new_ldac(p_acsub, nsmpl), nsmpl);
         }
     }
     else if (format == LDAC_SMPL_FMT_S32) {
         for (ich = 0; ich < nchs; ich++) {
-            p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
-            for (isp = 0; isp < nsmpl; isp++) {
-                p_time[isp] = p_time[nsmpl+isp];
+            p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+            p_acsub->time_new ^= 1;
+            byte_data_to_int_s32_ldac(pp_pcm[ich], get_time_new_ldac(p_acsub, nsmpl), nsmpl);
+        }
+    }
+
+    return;
+}
+
+/***************************************************************************************************
+    Set Input PCM from Interleaved 16bit PCM in Place
+***************************************************************************************************/
+LDAC_HOT_FUNC DECLFUNC void set_input_pcm_view_ldac(
+SFINFO *p_sfinfo,
+const short *ap_span[],
+const int *a_nsmpl,
+int gain,
+int nlnn)
+{
+    int ich, isp, ispan, nsmpl_span;
+    int nchs = p_sfinfo->cfg.ch;
+    int nsmpl = npow2_ldac(nlnn);
+    int nleft = nsmpl;
+    INT32 *ap_time[LDAC_MAXNCH];
+    const short *p_s;
+    ACSUB *p_acsub;
+
+    /* The older half of the window becomes the newer one, no history shift is needed */
+    for (ich = 0; ich < nchs; ich++) {
+        p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+        p_acsub->time_new ^= 1;
+        ap_time[ich] = get_time_new_ldac(p_acsub, nsmpl);
+    }
+
+    /* One pass over the interleaved input, split and scaled into all channels at once */
+    for (ispan = 0; (ispan < 2) && (nleft > 0); ispan++) {
+        nsmpl_span = min_ldac(a_nsmpl[ispan], nleft);
+        p_s = ap_span[ispan];
+        for (isp = 0; isp < nsmpl_span; isp++) {
+            for (ich = 0; ich < nchs; ich++) {
+                *ap_time[ich]++ = lsft_ldac((INT32)p_s[ich] * gain, LDAC_Q_SETPCM-LDAC_Q_GAIN);
             }
-            byte_data_to_int_s32_ldac(pp_pcm[ich], p_time+nsmpl, nsmpl);
+            p_s += nchs;
         }
+        nleft -= nsmpl_span;
+    }
+
+    return;
+}
+
+/***************************************************************************************************
+    Set Input PCM of Digital Silence
+***************************************************************************************************/
+DECLFUNC void set_input_silence_ldac(
+SFINFO *p_sfinfo,
+int nlnn)
+{
+    int ich;
+    int nchs = p_sfinfo->cfg.ch;
+    int nsmpl = npow2_ldac(nlnn);
+    ACSUB *p_acsub;
+
+    for (ich = 0; ich < nchs; ich++) {
+        p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+        p_acsub->time_new ^= 1;
+        clear_data_ldac(get_time_new_ldac(p_acsub, nsmpl), nsmpl*sizeof(INT32));
     }
 
     return;
@@ -113,46 +113,101 @@ char *pp_pcm[],
 LDAC_SMPL_FMT_T format,
 int nlnn)
 {
-    int ich, isp;
+    int ich;
     int nchs = p_sfinfo->cfg.ch;
     int nsmpl = npow2_ldac(nlnn);
-    SCALAR *p_time;
+    ACSUB *p_acsub;
 
     if (format == LDAC_SMPL_FMT_S16) {
         for (ich = 0; ich < nchs; ich++) {
-            p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
-            for (isp = 0; isp < nsmpl; isp++) {
-                p_time[isp] = p_time[nsmpl+isp];
-            }
-            byte_data_to_scalar_s16_ldac(pp_pcm[ich], p_time+nsmpl, nsmpl);
+            p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+            p_acsub->time_new ^= 1;
+            byte_data_to_scalar_s16_ldac(pp_pcm[ich], get_time_new_ldac(p_acsub, nsmpl), nsmpl);
         }
     }
     else if (format == LDAC_SMPL_FMT_S24) {
         for (ich = 0; ich < nchs; ich++) {
-            p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
-            for (isp = 0; isp < nsmpl; isp++) {
-                p_time[isp] = p_time[nsmpl+isp];
-            }
-            byte_data_to_scalar_s24_ldac(pp_pcm[ich], p_time+nsmpl, nsmpl);
+            p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+            p_acsub->time_new ^= 1;
+            byte_data_to_scalar_s24_ldac(pp_pcm[ich], get_time_new_ldac(p_acsub, nsmpl), nsmpl);
         }
     }
     else if (format == LDAC_SMPL_FMT_S32) {
         for (ich = 0; ich < nchs; ich++) {
-            p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
-            for (isp = 0; isp < nsmpl; isp++) {
-                p_time[isp] = p_time[nsmpl+isp];
-            }
-            byte_data_to_scalar_s32_ldac(pp_pcm[ich], p_time+nsmpl, nsmpl);
+            p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+            p_acsub->time_new ^= 1;
+            byte_data_to_scalar_s32_ldac(pp_pcm[ich], get_time_new_ldac(p_acsub, nsmpl), nsmpl);
         }
     }
     else if (format == LDAC_SMPL_FMT_F32) {
         for (ich = 0; ich < nchs; ich++) {
-            p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
-            for (isp = 0; isp < nsmpl; isp++) {
-                p_time[isp] = p_time[nsmpl+isp];
+            p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+            p_acsub->time_new ^= 1;
+            byte_data_to_scalar_f32_ldac(pp_pcm[ich], get_time_new_ldac(p_acsub, nsmpl), nsmpl);
+        }
+    }
+
+    return;
+}
+
+/***************************************************************************************************
+    Set Input PCM from Interleaved 16bit PCM in Place
+***************************************************************************************************/
+DECLFUNC void set_input_pcm_view_ldac(
+SFINFO *p_sfinfo,
+const short *ap_span[],
+const int *a_nsmpl,
+int gain,
+int nlnn)
+{
+    int ich, isp, ispan, nsmpl_span;
+    int nchs = p_sfinfo->cfg.ch;
+    int nsmpl = npow2_ldac(nlnn);
+    int nleft = nsmpl;
+    SCALAR scale = (SCALAR)gain / (SCALAR)LDAC_GAIN_UNITY;
+    SCALAR *ap_time[LDAC_MAXNCH];
+    const short *p_s;
+    ACSUB *p_acsub;
+
+    /* The older half of the window becomes the newer one, no history shift is needed */
+    for (ich = 0; ich < nchs; ich++) {
+        p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+        p_acsub->time_new ^= 1;
+        ap_time[ich] = get_time_new_ldac(p_acsub, nsmpl);
+    }
+
+    /* One pass over the interleaved input, split and scaled into all channels at once */
+    for (ispan = 0; (ispan < 2) && (nleft > 0); ispan++) {
+        nsmpl_span = min_ldac(a_nsmpl[ispan], nleft);
+        p_s = ap_span[ispan];
+        for (isp = 0; isp < nsmpl_span; isp++) {
+            for (ich = 0; ich < nchs; ich++) {
+                *ap_time[ich]++ = scale * (SCALAR)p_s[ich];
             }
-            byte_data_to_scalar_f32_ldac(pp_pcm[ich], p_time+nsmpl, nsmpl);
+            p_s += nchs;
         }
+        nleft -= nsmpl_span;
+    }
+
+    return;
+}
+
+/***************************************************************************************************
+    Set Input PCM of Digital Silence
+***************************************************************************************************/
+DECLFUNC void set_input_silence_ldac(
+SFINFO *p_sfinfo,
+int nlnn)
+{
+    int ich;
+    int nchs = p_sfinfo->cfg.ch;
+    int nsmpl = npow2_ldac(nlnn);
+    ACSUB *p_acsub;
+
+    for (ich = 0; ich < nchs; ich++) {
+        p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+        p_acsub->time_new ^= 1;
+        clear_data_ldac(get_time_new_ldac(p_acsub, nsmpl), nsmpl*sizeof(SCALAR));
     }
 
     return;
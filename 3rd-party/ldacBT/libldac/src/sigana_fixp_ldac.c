@@ -29,7 +29,7 @@
 /***************************************************************************************************
     Lookup Table for Calculating Square Root Value
 ***************************************************************************************************/
-static INT16 sa_sqrt_ldac[97] = { /* Q14 */
+LDAC_HOT_TABLE static const INT16 sa_sqrt_ldac[97] = { /* Q14 */
     0x2d41, 0x2df4, 0x2ea5, 0x2f54, 0x3000, 0x30a9, 0x3150, 0x31f5,
     0x3298, 0x3339, 0x33d8, 0x3475, 0x3510, 0x35aa, 0x3642, 0x36d8,
     0x376c, 0x3800, 0x3891, 0x3921, 0x39b0, 0x3a3d, 0x3ac9, 0x3b54,
@@ -48,7 +48,7 @@ static INT16 sa_sqrt_ldac[97] = { /* Q14 */
 /***************************************************************************************************
     Subfunction: Multiply
 ***************************************************************************************************/
-__inline static INT32 mul_ldac(
+LDAC_HOT_FUNC __inline static INT32 mul_ldac(
 INT32 in1,
 INT32 in2)
 {
@@ -75,7 +75,7 @@ INT32 in2)
 /***************************************************************************************************
     Subfunction: Subtract
 ***************************************************************************************************/
-__inline static INT32 sub_ldac(
+LDAC_HOT_FUNC __inline static INT32 sub_ldac(
 INT32 in1,
 INT32 in2)
 {
@@ -89,7 +89,7 @@ INT32 in2)
 /***************************************************************************************************
     Subfunction: Add
 ***************************************************************************************************/
-__inline static INT32 add_ldac(
+LDAC_HOT_FUNC __inline static INT32 add_ldac(
 INT32 in1,
 INT32 in2)
 {
@@ -103,7 +103,7 @@ INT32 in2)
 /***************************************************************************************************
     Subfunction: Multiply and Add
 ***************************************************************************************************/
-__inline static INT32 mad_ldac(
+LDAC_HOT_FUNC __inline static INT32 mad_ldac(
 INT32 in1,
 INT32 in2,
 INT32 in3)
@@ -119,24 +119,41 @@ INT32 in3)
 /***************************************************************************************************
     Subfunction: Normalize
 ***************************************************************************************************/
-__inline static INT16 norm_ldac(
+LDAC_HOT_FUNC __inline static INT16 norm_ldac(
 UINT32 val)
 {
     INT16 len;
 
+    /* Bit length, halving the range at each step */
     len = 0;
-    while (val > 0) {
+    if (val >= 0x10000) {
+        val >>= 16;
+        len += 16;
+    }
+    if (val >= 0x100) {
+        val >>= 8;
+        len += 8;
+    }
+    if (val >= 0x10) {
+        val >>= 4;
+        len += 4;
+    }
+    if (val >= 0x4) {
+        val >>= 2;
+        len += 2;
+    }
+    if (val >= 0x2) {
         val >>= 1;
-        len++;
+        len += 1;
     }
 
-    return len;
+    return len + (INT16)val;
 }
 
 /***************************************************************************************************
     Subfunction: Calculate Exponential
 ***************************************************************************************************/
-__inline static INT16 calc_exp_ldac(
+LDAC_HOT_FUNC __inline static INT16 calc_exp_ldac(
 INT32 in_h,
 UINT32 in_l)
 {
@@ -156,7 +173,7 @@ UINT32 in_l)
 /***************************************************************************************************
     Subfunction: Calculate Square Root
 ***************************************************************************************************/
-__inline static INT32 calc_sqrt_ldac(
+LDAC_HOT_FUNC __inline static INT32 calc_sqrt_ldac(
 INT32 in,
 INT16 e)
 {
@@ -181,9 +198,43 @@ INT16 e)
 }
 
 /***************************************************************************************************
-    Calculate Pseudo Spectrum and Low Band Energy
+    Calculate Low Band Energy
 ***************************************************************************************************/
-static INT32 calc_mdct_pseudo_spectrum_ldac(
+LDAC_HOT_FUNC static INT32 calc_mdct_low_energy_ldac(
+INT32 *p_spec)
+{
+    UINT32 isp;
+    INT32 y0, y1, y2;
+    INT64 low_energy;
+    INT64 acc1, acc2;
+
+    y1 = p_spec[0];
+    y2 = p_spec[1];
+    acc1 = (INT64)y1 * (INT64)y1;
+    acc2 = (INT64)y2 * (INT64)y2;
+    low_energy = (acc1 + acc2) >> LDAC_Q_ADD_LOWENERGY; /* Q26 <- (Q15 * Q15) >> 4 */
+
+    for (isp = 1; isp < LDAC_NSP_LOWENERGY; isp++) {
+        y0 = y1;
+        y1 = y2;
+        y2 = p_spec[isp+1];
+        acc1 = (INT64)y1 * (INT64)y1;
+        acc2 = (INT64)(y0-y2) * (INT64)(y0-y2);
+        low_energy += (acc1 + acc2) >> LDAC_Q_ADD_LOWENERGY; /* Q26 <- (Q15 * Q15) >> 4 */
+    }
+
+    low_energy >>= LDAC_Q_LOWENERGY; /* Q15 <- Q26 >> 11 */
+    if (low_energy > LDAC_MAX_32BIT) {
+        low_energy = LDAC_MAX_32BIT;
+    }
+
+    return (INT32)low_energy;
+}
+
+/***************************************************************************************************
+    Calculate Pseudo Spectrum
+***************************************************************************************************/
+LDAC_HOT_FUNC static void calc_mdct_pseudo_spectrum_ldac(
 INT32 *p_spec,
 INT32 *p_psd,
 UINT32 nsp)
@@ -192,7 +243,6 @@ UINT32 nsp)
     INT16 e;
     INT32 y0, y1, y2;
     INT32 tmp;
-    INT64 low_energy;
     INT64 acc1, acc2;
 
     {
@@ -201,26 +251,12 @@ UINT32 nsp)
         acc1 = (INT64)y1 * (INT64)y1;
         acc2 = (INT64)y2 * (INT64)y2;
         acc1 = acc1 + acc2;
-        low_energy = acc1 >> LDAC_Q_ADD_LOWENERGY; /* Q26 <- (Q15 * Q15) >> 4 */
-        e = calc_exp_ldac((INT32)(acc1>>32), (UINT32)(acc1&0xffffffff));
-        tmp = (INT32)((acc1 << e) >> 32);
-        *p_psd++ = calc_sqrt_ldac(tmp, e);
-    }
-
-    for (isp = 1; isp < LDAC_NSP_LOWENERGY; isp++) {
-        y0 = y1;
-        y1 = y2;
-        y2 = p_spec[isp+1];
-        acc1 = (INT64)y1 * (INT64)y1;
-        acc2 = (INT64)(y0-y2) * (INT64)(y0-y2);
-        acc1 = acc1 + acc2;
-        low_energy += acc1 >> LDAC_Q_ADD_LOWENERGY; /* Q26 <- (Q15 * Q15) >> 4 */
         e = calc_exp_ldac((INT32)(acc1>>32), (UINT32)(acc1&0xffffffff));
         tmp = (INT32)((acc1 << e) >> 32);
         *p_psd++ = calc_sqrt_ldac(tmp, e);
     }
 
-    for (isp = LDAC_NSP_LOWENERGY; isp < nsp-1; isp++) {
+    for (isp = 1; isp < nsp-1; isp++) {
         y0 = y1;
         y1 = y2;
         y2 = p_spec[isp+1];
@@ -241,18 +277,13 @@ UINT32 nsp)
         *p_psd++ = calc_sqrt_ldac(tmp, e);
     }
 
-    low_energy >>= LDAC_Q_LOWENERGY; /* Q15 <- Q26 >> 11 */
-    if (low_energy > LDAC_MAX_32BIT) {
-        low_energy = LDAC_MAX_32BIT;
-    }
-
-    return (INT32)low_energy;
+    return;
 }
 
 /***************************************************************************************************
     Calculate Pseudo Spectrum Centroid
 ***************************************************************************************************/
-static INT32 calc_spectral_centroid_ldac(
+LDAC_HOT_FUNC static INT32 calc_spectral_centroid_ldac(
 INT32 *p_spec,
 UINT32 nsp)
 {
@@ -276,15 +307,16 @@ UINT32 nsp)
 /***************************************************************************************************
     Calculate Number of Zero Cross
 ***************************************************************************************************/
-static UINT32 calc_zero_cross_number_ldac(
+LDAC_HOT_FUNC static UINT32 calc_zero_cross_number_ldac(
+INT32 prev,
 INT32 *p_time,
 UINT32 n)
 {
     UINT32 i;
     UINT32 zero_cross = 0;
-    INT32 prev, tmp;
+    INT32 tmp;
 
-    prev = 0;
+    /* A zero sample neither starts nor ends a cross */
     for (i = 0; i < n; i++) {
         if ((prev == 0) || (*p_time == 0)) {
             tmp = 0;
@@ -303,62 +335,107 @@ UINT32 n)
 }
 
 /***************************************************************************************************
-    Analyze Frame Status
+    Analyze Channel Status
 ***************************************************************************************************/
-DECLSPEC int ana_frame_status_ldac(
-SFINFO *p_sfinfo,
-int nlnn)
+LDAC_HOT_FUNC DECLFUNC int ana_channel_status_ldac(
+AC *p_ac,
+int nlnn,
+int sigana_mode)
 {
-    AC *p_ac;
-    int ich;
-    int nchs = p_sfinfo->cfg.ch;
-    int nsmpl = npow2_ldac(nlnn+1);
-    int cnt;
-    int a_status[LDAC_PRCNCH];
-    UINT32 zero_cross;
+    int nsmpl = npow2_ldac(nlnn);
+    int cnt, status;
+    UINT32 zero_cross, zero_cross_new;
     INT32 low_energy, centroid;
+    INT32 *p_time_old, *p_time_new;
     INT32 a_psd_spec[LDAC_NSP_PSEUDOANA];
 
+    /* Fast mode reuses a steady status for a few frames */
+    if ((sigana_mode == LDAC_SIGANA_FAST) && (p_ac->frmana_skip > 0)) {
+        p_ac->frmana_skip--;
+        p_ac->frmana_zcros = -1;
+        return p_ac->frmana_status;
+    }
 
-    for (ich = 0; ich < nchs; ich++) {
-        p_ac = p_sfinfo->ap_ac[ich];
+    low_energy = calc_mdct_low_energy_ldac(p_ac->p_acsub->a_spec);
 
-        low_energy = calc_mdct_pseudo_spectrum_ldac(p_ac->p_acsub->a_spec, a_psd_spec, LDAC_NSP_PSEUDOANA);
+    status = LDAC_FRMSTAT_LEV_0;
+    if (low_energy < LDAC_TH_LOWENERGY_L) {
+        status = LDAC_FRMSTAT_LEV_3;
+        p_ac->frmana_zcros = -1;
+    }
+    else {
+        if (low_energy < LDAC_TH_LOWENERGY_M) {
+            status = LDAC_FRMSTAT_LEV_2;
+        }
+        else if (low_energy < LDAC_TH_LOWENERGY_H) {
+            status = LDAC_FRMSTAT_LEV_1;
+        }
 
-        centroid = calc_spectral_centroid_ldac(a_psd_spec, LDAC_NSP_PSEUDOANA);
+        /* The older half of the window was the newer one of the frame before, */
+        /* its count is kept unless that frame skipped it */
+        p_time_old = get_time_old_ldac(p_ac->p_acsub, nsmpl);
+        p_time_new = get_time_new_ldac(p_ac->p_acsub, nsmpl);
+        if (p_ac->frmana_zcros < 0) {
+            p_ac->frmana_zcros = (int)calc_zero_cross_number_ldac(0, p_time_old, nsmpl);
+        }
+        zero_cross_new = calc_zero_cross_number_ldac(0, p_time_new, nsmpl);
+        zero_cross = (UINT32)p_ac->frmana_zcros + zero_cross_new
+                + calc_zero_cross_number_ldac(p_time_old[nsmpl-1], p_time_new, 1);
+        p_ac->frmana_zcros = (int)zero_cross_new;
+
+        /* The pseudo spectrum centroid only matters with enough zero crosses */
+        centroid = 0;
+        if (zero_cross >= LDAC_TH_ZCROSNUM) {
+            calc_mdct_pseudo_spectrum_ldac(p_ac->p_acsub->a_spec, a_psd_spec, LDAC_NSP_PSEUDOANA);
+            centroid = calc_spectral_centroid_ldac(a_psd_spec, LDAC_NSP_PSEUDOANA);
+        }
 
-        zero_cross = calc_zero_cross_number_ldac(p_ac->p_acsub->a_time, nsmpl);
+        cnt = p_ac->frmana_cnt;
+        if ((centroid > LDAC_TH_CENTROID) && (zero_cross >= LDAC_TH_ZCROSNUM)) {
+            cnt++;
 
-        a_status[ich] = LDAC_FRMSTAT_LEV_0;
-        if (low_energy < LDAC_TH_LOWENERGY_L) {
-            a_status[ich] = LDAC_FRMSTAT_LEV_3;
-        }
-        else {
-            if (low_energy < LDAC_TH_LOWENERGY_M) {
-                a_status[ich] = LDAC_FRMSTAT_LEV_2;
+            if (cnt >= LDAC_MAXCNT_FRMANA) {
+                cnt = LDAC_MAXCNT_FRMANA;
+                status = LDAC_FRMSTAT_LEV_2;
             }
-            else if (low_energy < LDAC_TH_LOWENERGY_H) {
-                a_status[ich] = LDAC_FRMSTAT_LEV_1;
+            else if (status <= LDAC_FRMSTAT_LEV_1) {
+                status++;
             }
+        }
+        else {
+            cnt = 0;
+        }
+        p_ac->frmana_cnt = cnt;
+    }
 
-            cnt = p_ac->frmana_cnt;
-            if ((centroid > LDAC_TH_CENTROID) && (zero_cross >= LDAC_TH_ZCROSNUM)) {
-                cnt++;
-
-                if (cnt >= LDAC_MAXCNT_FRMANA) {
-                    cnt = LDAC_MAXCNT_FRMANA;
-                    a_status[ich] = LDAC_FRMSTAT_LEV_2;
-                }
-                else if (a_status[ich] <= LDAC_FRMSTAT_LEV_1) {
-                    a_status[ich]++;
-                }
-            }
-            else {
-                cnt = 0;
-            }
-            p_ac->frmana_cnt = cnt;
+    if (status == p_ac->frmana_status) {
+        if (++p_ac->frmana_steady >= LDAC_FRMANA_STEADY) {
+            p_ac->frmana_steady = 0;
+            p_ac->frmana_skip = LDAC_FRMANA_SKIP;
         }
     }
+    else {
+        p_ac->frmana_status = status;
+        p_ac->frmana_steady = 0;
+    }
+
+    return status;
+}
+
+/***************************************************************************************************
+    Analyze Frame Status
+***************************************************************************************************/
+LDAC_HOT_FUNC DECLSPEC int ana_frame_status_ldac(
+SFINFO *p_sfinfo,
+int nlnn)
+{
+    int ich;
+    int nchs = p_sfinfo->cfg.ch;
+    int a_status[LDAC_PRCNCH];
+
+    for (ich = 0; ich < nchs; ich++) {
+        a_status[ich] = ana_channel_status_ldac(p_sfinfo->ap_ac[ich], nlnn, p_sfinfo->sigana_mode);
+    }
 
     if (nchs == LDAC_CHANNEL_1CH) {
         return a_status[0];
@@ -366,4 +443,3 @@ int nlnn)
         return min_ldac(a_status[0], a_status[1]);
     }
 }
-
@@ -25,35 +25,49 @@
 #define LDAC_TH_ZERODIV     _scalar(1.0e-6)
 
 /***************************************************************************************************
-    Calculate Pseudo Spectrum and Low Band Energy
+    Calculate Low Band Energy
 ***************************************************************************************************/
-static SCALAR calc_mdct_pseudo_spectrum_ldac(
+static SCALAR calc_mdct_low_energy_ldac(
+SCALAR *p_spec)
+{
+    int isp;
+    SCALAR low_energy;
+    SCALAR y0, y1, y2;
+
+    y1 = p_spec[0];
+    y2 = p_spec[1];
+    low_energy = y1 * y1 + y2 * y2;
+
+    for (isp = 1; isp < LDAC_NSP_LOWENERGY; isp++) {
+        y0 = y1;
+        y1 = y2;
+        y2 = p_spec[isp+1];
+        low_energy += y1 * y1 + (y0-y2) * (y0-y2);
+    }
+
+    return low_energy;
+}
+
+/***************************************************************************************************
+    Calculate Pseudo Spectrum
+***************************************************************************************************/
+static void calc_mdct_pseudo_spectrum_ldac(
 SCALAR *p_spec,
 SCALAR *p_psd,
 int n)
 {
     int isp;
-    SCALAR low_energy, tmp;
+    SCALAR tmp;
     SCALAR y0, y1, y2;
 
     {
         y1 = p_spec[0];
         y2 = p_spec[1];
         tmp = y1 * y1 + y2 * y2;
-        low_energy = tmp;
         p_psd[0] = sqrt(tmp);
     }
 
-    for (isp = 1; isp < LDAC_NSP_LOWENERGY; isp++) {
-        y0 = y1;
-        y1 = y2;
-        y2 = p_spec[isp+1];
-        tmp = y1 * y1 + (y0-y2) * (y0-y2);
-        low_energy += tmp;
-        p_psd[isp] = sqrt(tmp);
-    }
-
-    for (isp = LDAC_NSP_LOWENERGY; isp < n-1; isp++) {
+    for (isp = 1; isp < n-1; isp++) {
         y0 = y1;
         y1 = y2;
         y2 = p_spec[isp+1];
@@ -66,7 +80,7 @@ int n)
         p_psd[n-1] = sqrt(tmp);
     }
 
-    return low_energy;
+    return;
 }
 
 /***************************************************************************************************
@@ -100,14 +114,14 @@ int nsp)
     Calculate Number of Zero Cross
 ***************************************************************************************************/
 static int calc_zero_cross_number_ldac(
+SCALAR prev,
 SCALAR *p_time,
 int n)
 {
     int i;
     int zero_cross = 0;
-    SCALAR prev;
 
-    prev = _scalar(0.0);
+    /* A zero sample neither starts nor ends a cross */
     for (i = 0; i < n; i++) {
         if (prev * *p_time < _scalar(0.0)) {
             zero_cross++;
@@ -119,59 +133,106 @@ int n)
 }
 
 /***************************************************************************************************
-    Analyze Frame Status
+    Analyze Channel Status
 ***************************************************************************************************/
-DECLSPEC int ana_frame_status_ldac(
-SFINFO *p_sfinfo,
-int nlnn)
+DECLFUNC int ana_channel_status_ldac(
+AC *p_ac,
+int nlnn,
+int sigana_mode)
 {
-    AC *p_ac;
-    int ich;
-    int nchs = p_sfinfo->cfg.ch;
-    int nsmpl = npow2_ldac(nlnn+1);
-    int cnt, zero_cross;
-    int a_status[LDAC_PRCNCH];
+    int nsmpl = npow2_ldac(nlnn);
+    int cnt, status;
+    int zero_cross, zero_cross_new;
     SCALAR low_energy, centroid;
+    SCALAR *p_time_old, *p_time_new;
     SCALAR a_psd_spec[LDAC_NSP_PSEUDOANA];
 
-    for (ich = 0; ich < nchs; ich++) {
-        p_ac = p_sfinfo->ap_ac[ich];
+    /* Fast mode reuses a steady status for a few frames */
+    if ((sigana_mode == LDAC_SIGANA_FAST) && (p_ac->frmana_skip > 0)) {
+        p_ac->frmana_skip--;
+        p_ac->frmana_zcros = -1;
+        return p_ac->frmana_status;
+    }
 
-        low_energy = calc_mdct_pseudo_spectrum_ldac(p_ac->p_acsub->a_spec, a_psd_spec, LDAC_NSP_PSEUDOANA);
+    low_energy = calc_mdct_low_energy_ldac(p_ac->p_acsub->a_spec);
 
-        centroid = calc_spectral_centroid_ldac(a_psd_spec, LDAC_NSP_PSEUDOANA);
+    status = LDAC_FRMSTAT_LEV_0;
+    if (low_energy < LDAC_TH_LOWENERGY_L) {
+        status = LDAC_FRMSTAT_LEV_3;
+        p_ac->frmana_zcros = -1;
+    }
+    else {
+        if (low_energy < LDAC_TH_LOWENERGY_M) {
+            status = LDAC_FRMSTAT_LEV_2;
+        }
+        else if (low_energy < LDAC_TH_LOWENERGY_H) {
+            status = LDAC_FRMSTAT_LEV_1;
+        }
 
-        zero_cross = calc_zero_cross_number_ldac(p_ac->p_acsub->a_time, nsmpl);
+        /* The older half of the window was the newer one of the frame before, */
+        /* its count is kept unless that frame skipped it */
+        p_time_old = get_time_old_ldac(p_ac->p_acsub, nsmpl);
+        p_time_new = get_time_new_ldac(p_ac->p_acsub, nsmpl);
+        if (p_ac->frmana_zcros < 0) {
+            p_ac->frmana_zcros = calc_zero_cross_number_ldac(_scalar(0.0), p_time_old, nsmpl);
+        }
+        zero_cross_new = calc_zero_cross_number_ldac(_scalar(0.0), p_time_new, nsmpl);
+        zero_cross = p_ac->frmana_zcros + zero_cross_new
+                + calc_zero_cross_number_ldac(p_time_old[nsmpl-1], p_time_new, 1);
+        p_ac->frmana_zcros = zero_cross_new;
 
-        a_status[ich] = LDAC_FRMSTAT_LEV_0;
-        if (low_energy < LDAC_TH_LOWENERGY_L) { 
-            a_status[ich] = LDAC_FRMSTAT_LEV_3;
+        /* The pseudo spectrum centroid only matters with enough zero crosses */
+        centroid = _scalar(0.0);
+        if (zero_cross >= LDAC_TH_ZCROSNUM) {
+            calc_mdct_pseudo_spectrum_ldac(p_ac->p_acsub->a_spec, a_psd_spec, LDAC_NSP_PSEUDOANA);
+            centroid = calc_spectral_centroid_ldac(a_psd_spec, LDAC_NSP_PSEUDOANA);
         }
-        else {
-            if (low_energy < LDAC_TH_LOWENERGY_M) {
-                a_status[ich] = LDAC_FRMSTAT_LEV_2;
-            }
-            else if (low_energy < LDAC_TH_LOWENERGY_H) {
-                a_status[ich] = LDAC_FRMSTAT_LEV_1;
-            }
 
-            cnt = p_ac->frmana_cnt;
-            if ((centroid > LDAC_TH_CENTROID) && (zero_cross >= LDAC_TH_ZCROSNUM)) {
-                cnt++;
-
-                if (cnt >= LDAC_MAXCNT_FRMANA) {
-                    cnt = LDAC_MAXCNT_FRMANA;
-                    a_status[ich] = LDAC_FRMSTAT_LEV_2;
-                }
-                else if (a_status[ich] <= LDAC_FRMSTAT_LEV_1) {
-                    a_status[ich]++;
-                }
+        cnt = p_ac->frmana_cnt;
+        if ((centroid > LDAC_TH_CENTROID) && (zero_cross >= LDAC_TH_ZCROSNUM)) {
+            cnt++;
+
+            if (cnt >= LDAC_MAXCNT_FRMANA) {
+                cnt = LDAC_MAXCNT_FRMANA;
+                status = LDAC_FRMSTAT_LEV_2;
             }
-            else {
-                cnt = 0;
+            else if (status <= LDAC_FRMSTAT_LEV_1) {
+                status++;
             }
-            p_ac->frmana_cnt = cnt;
         }
+        else {
+            cnt = 0;
+        }
+        p_ac->frmana_cnt = cnt;
+    }
+
+    if (status == p_ac->frmana_status) {
+        if (++p_ac->frmana_steady >= LDAC_FRMANA_STEADY) {
+            p_ac->frmana_steady = 0;
+            p_ac->frmana_skip = LDAC_FRMANA_SKIP;
+        }
+    }
+    else {
+        p_ac->frmana_status = status;
+        p_ac->frmana_steady = 0;
+    }
+
+    return status;
+}
+
+/***************************************************************************************************
+    Analyze Frame Status
+***************************************************************************************************/
+DECLSPEC int ana_frame_status_ldac(
+SFINFO *p_sfinfo,
+int nlnn)
+{
+    int ich;
+    int nchs = p_sfinfo->cfg.ch;
+    int a_status[LDAC_PRCNCH];
+
+    for (ich = 0; ich < nchs; ich++) {
+        a_status[ich] = ana_channel_status_ldac(p_sfinfo->ap_ac[ich], nlnn, p_sfinfo->sigana_mode);
     }
 
     if (nchs == LDAC_CHANNEL_1CH) {
@@ -181,4 +242,3 @@ int nlnn)
         return min_ldac(a_status[0], a_status[1]);
     }
 }
-
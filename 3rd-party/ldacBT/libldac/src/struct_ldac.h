@@ -29,6 +29,17 @@
 #define DECLFUNC static
 #define UNUSED_ATTR __attribute__((unused))
 
+/* Placement of the code and constant tables used for every frame. Targets that execute in place
+   from flash can define LDAC_HOT_IN_RAM to put them into .time_critical sections, which the
+   pico-sdk startup copies to RAM together with .data. */
+#ifdef LDAC_HOT_IN_RAM
+#define LDAC_HOT_FUNC __attribute__((section(".time_critical.ldac")))
+#define LDAC_HOT_TABLE __attribute__((section(".time_critical.ldac_tables")))
+#else /* LDAC_HOT_IN_RAM */
+#define LDAC_HOT_FUNC
+#define LDAC_HOT_TABLE
+#endif /* LDAC_HOT_IN_RAM */
+
 #ifndef PI
 #ifdef M_PI
 #define PI M_PI
@@ -53,7 +53,7 @@ DECLFUNC const unsigned char ga_chconfig_id_ldac[LDAC_MAXNCH+1] = {
     0, LDAC_CHCONFIGID_MN, LDAC_CHCONFIGID_ST
 };
 
-DECLFUNC const char gaa_block_setting_ldac[LDAC_NCHCONFIGID][LDAC_MAXNCH+2]=
+LDAC_HOT_TABLE DECLFUNC const char gaa_block_setting_ldac[LDAC_NCHCONFIGID][LDAC_MAXNCH+2]=
 {
     {LDAC_CHANNEL_1CH, 1, LDAC_BLKID_MONO},
     {LDAC_CHANNEL_2CH, 2, LDAC_BLKID_MONO, LDAC_BLKID_MONO},
@@ -82,7 +82,7 @@ int blk_type)
 /***************************************************************************************************
     Tables related to Quantization Units
 ***************************************************************************************************/
-DECLFUNC const unsigned char ga_idsp_ldac[LDAC_MAXNQUS] = {
+LDAC_HOT_TABLE DECLFUNC const unsigned char ga_idsp_ldac[LDAC_MAXNQUS] = {
       0,  0,  0,  0,  0,  0,  0,  0,
       1,  1,  1,  1,
       1,  1,  1,  1,
@@ -96,7 +96,7 @@ DECLFUNC const unsigned char ga_idsp_ldac[LDAC_MAXNQUS] = {
       3,  3,
 };
 
-DECLFUNC const unsigned char ga_nsps_ldac[LDAC_MAXNQUS] = {
+LDAC_HOT_TABLE DECLFUNC const unsigned char ga_nsps_ldac[LDAC_MAXNQUS] = {
       2,  2,  2,  2,  2,  2,  2,  2,
       4,  4,  4,  4,
       4,  4,  4,  4,
@@ -110,7 +110,7 @@ DECLFUNC const unsigned char ga_nsps_ldac[LDAC_MAXNQUS] = {
      16, 16,
 };
 
-DECLFUNC const unsigned short ga_isp_ldac[LDAC_MAXNQUS+1] = {
+LDAC_HOT_TABLE DECLFUNC const unsigned short ga_isp_ldac[LDAC_MAXNQUS+1] = {
       0,  2,  4,  6,  8, 10, 12, 14,
      16, 20, 24, 28,
      32, 36, 40, 44,
@@ -125,29 +125,29 @@ DECLFUNC const unsigned short ga_isp_ldac[LDAC_MAXNQUS+1] = {
     256,
 };
 
-DECLFUNC const unsigned char ga_nqus_ldac[LDAC_MAXNBANDS+1] = {
+LDAC_HOT_TABLE DECLFUNC const unsigned char ga_nqus_ldac[LDAC_MAXNBANDS+1] = {
     0,  4,  8, 10, 12, 14, 16, 18, 20, 22, 24, 25, 26, 28, 30, 32, 34,
 };
 
 /***************************************************************************************************
     Encoding/Decoding Tables for Spectrum Data
 ***************************************************************************************************/
-DECLFUNC const unsigned char ga_wl_ldac[LDAC_NIDWL] = {
+LDAC_HOT_TABLE DECLFUNC const unsigned char ga_wl_ldac[LDAC_NIDWL] = {
     0,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16,
 };
 
-DECLFUNC const short gaa_ndim_wls_ldac[4][LDAC_NIDWL] = {
+LDAC_HOT_TABLE DECLFUNC const short gaa_ndim_wls_ldac[4][LDAC_NIDWL] = {
     {0,  3,  6,  8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30, 32},
     {0,  7, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60, 64},
     {0, 14, 24, 32, 40, 48, 56, 64, 72, 80, 88, 96,104,112,120,128},
     {0, 28, 48, 64, 80, 96,112,128,144,160,176,192,208,224,240,256},
 };
 
-DECLFUNC const int ga_2dimenc_spec_ldac[LDAC_N2DIMSPECENCTBL] = {
+LDAC_HOT_TABLE DECLFUNC const int ga_2dimenc_spec_ldac[LDAC_N2DIMSPECENCTBL] = {
     0,  1,  2,  0,  3,  0,  4,  0,  5,  6,  7,  0,  0,  0,  0,  0,
 };
 
-DECLFUNC const int ga_4dimenc_spec_ldac[LDAC_N4DIMSPECENCTBL] = {
+LDAC_HOT_TABLE DECLFUNC const int ga_4dimenc_spec_ldac[LDAC_N4DIMSPECENCTBL] = {
      0,  1,  2,  0,  3,  4,  5,  0,  6,  7,  8,  0,  0,  0,  0,  0,
      9, 10, 11,  0, 12, 13, 14,  0, 15, 16, 17,  0,  0,  0,  0,  0,
     18, 19, 20,  0, 21, 22, 23,  0, 24, 25, 26,  0,  0,  0,  0,  0,
@@ -170,7 +170,7 @@ DECLFUNC const int ga_4dimenc_spec_ldac[LDAC_N4DIMSPECENCTBL] = {
 /***************************************************************************************************
     Resampled Gradient Table
 ***************************************************************************************************/
-DECLFUNC const unsigned char gaa_resamp_grad_ldac[LDAC_MAXGRADQU][LDAC_MAXGRADQU] = {
+LDAC_HOT_TABLE DECLFUNC const unsigned char gaa_resamp_grad_ldac[LDAC_MAXGRADQU][LDAC_MAXGRADQU] = {
 {
 128,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
 255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
@@ -376,7 +376,7 @@ DECLFUNC const unsigned char gaa_resamp_grad_ldac[LDAC_MAXGRADQU][LDAC_MAXGRADQU
 /***************************************************************************************************
     Weighting Tables for Scale Factor Data
 ***************************************************************************************************/
-DECLFUNC const unsigned char gaa_sfcwgt_ldac[LDAC_NSFCWTBL][LDAC_MAXNQUS] = {
+LDAC_HOT_TABLE DECLFUNC const unsigned char gaa_sfcwgt_ldac[LDAC_NSFCWTBL][LDAC_MAXNQUS] = {
 {
      1,  0,  0,  1,  1,  1,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,
      3,  3,  3,  3,  3,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,  8,  8,  8,
@@ -414,19 +414,19 @@ DECLFUNC const unsigned char gaa_sfcwgt_ldac[LDAC_NSFCWTBL][LDAC_MAXNQUS] = {
 /***************************************************************************************************
     Huffman Codewords for Scale Factor Data
 ***************************************************************************************************/
-static const HC sa_hc_sf0_blen3_ldac[8] = {
+LDAC_HOT_TABLE static const HC sa_hc_sf0_blen3_ldac[8] = {
     {  0, 2}, {  1, 2}, { 14, 4}, { 62, 6},
     { 63, 6}, { 30, 5}, {  6, 3}, {  2, 2},
 };
 
-static const HC sa_hc_sf0_blen4_ldac[16] = {
+LDAC_HOT_TABLE static const HC sa_hc_sf0_blen4_ldac[16] = {
     {  1, 2}, {  2, 2}, {  0, 4}, {  6, 5},
     { 15, 6}, { 19, 7}, { 35, 8}, { 36, 8},
     { 37, 8}, { 34, 8}, { 33, 8}, { 32, 8},
     { 14, 6}, {  5, 5}, {  1, 4}, {  3, 2},
 };
 
-static const HC sa_hc_sf0_blen5_ldac[32] = {
+LDAC_HOT_TABLE static const HC sa_hc_sf0_blen5_ldac[32] = {
     {  2, 2}, {  1, 3}, {  7, 3}, { 13, 4},
     { 12, 5}, { 24, 5}, { 27, 6}, { 33, 7},
     { 63, 7}, {106, 8}, {107, 8}, {104, 8},
@@ -437,7 +437,7 @@ static const HC sa_hc_sf0_blen5_ldac[32] = {
     { 25, 5}, {  9, 5}, {  5, 4}, {  0, 3},
 };
 
-static const HC sa_hc_sf0_blen6_ldac[64] = {
+LDAC_HOT_TABLE static const HC sa_hc_sf0_blen6_ldac[64] = {
     {  0, 3}, {  1, 3}, {  4, 4}, {  5, 4},
     { 18, 5}, { 19, 5}, { 46, 6}, { 47, 6},
     { 48, 6}, {102, 7}, {103, 7}, {214, 8},
@@ -456,23 +456,23 @@ static const HC sa_hc_sf0_blen6_ldac[64] = {
     { 22, 5}, {  6, 4}, {  7, 4}, {  8, 4},
 };
 
-static const HC sa_hc_sf1_blen2_ldac[4] = {
+LDAC_HOT_TABLE static const HC sa_hc_sf1_blen2_ldac[4] = {
     {  0, 1}, {  3, 2}, {  0, 0}, { 2,  2},
 };
 
-static const HC sa_hc_sf1_blen3_ldac[8] = {
+LDAC_HOT_TABLE static const HC sa_hc_sf1_blen3_ldac[8] = {
     {  1, 1}, {  0, 3}, {  4, 5}, { 11, 6},
     {  0, 0}, { 10, 6}, {  3, 4}, {  1, 2},
 };
 
-static const HC sa_hc_sf1_blen4_ldac[16] = {
+LDAC_HOT_TABLE static const HC sa_hc_sf1_blen4_ldac[16] = {
     {  1, 1}, {  1, 3}, {  4, 4}, { 14, 5},
     { 15, 5}, { 44, 7}, { 90, 8}, { 93, 8},
     {  0, 0}, { 92, 8}, { 91, 8}, { 47, 7},
     { 21, 6}, { 20, 6}, {  6, 4}, {  0, 3},
 };
 
-static const HC sa_hc_sf1_blen5_ldac[32] = {
+LDAC_HOT_TABLE static const HC sa_hc_sf1_blen5_ldac[32] = {
     {  0, 3}, {  5, 3}, {  7, 4}, { 12, 4},
     {  4, 4}, {  2, 4}, {  3, 4}, {  5, 4},
     {  9, 4}, { 16, 5}, { 35, 6}, { 51, 7},
@@ -20,7 +20,7 @@
     Window Tables
 ***************************************************************************************************/
 DECLFUNC const INT32 *gaa_fwin_ldac[LDAC_NUMLNN];
-static const INT32 sa_fwin_1fs_ldac[LDAC_1FSLSU] = { /* Q30 */
+LDAC_HOT_TABLE static const INT32 sa_fwin_1fs_ldac[LDAC_1FSLSU] = { /* Q30 */
     0x00009de9, 0x00058d10, 0x000f6a9a, 0x001e3503, 0x0031ea03, 0x004a868e, 0x006806db, 0x008a665c,
     0x00b19fc5, 0x00ddad09, 0x010e875c, 0x01442737, 0x017e8455, 0x01bd95b5, 0x0201519e, 0x0249ad9e,
     0x02969e8c, 0x02e8188c, 0x033e0f0c, 0x039874cb, 0x03f73bda, 0x045a5599, 0x04c1b2c1, 0x052d4362,
@@ -38,7 +38,7 @@ static const INT32 sa_fwin_1fs_ldac[LDAC_1FSLSU] = { /* Q30 */
     0x3db65262, 0x3dfeae62, 0x3e426a4b, 0x3e817bab, 0x3ebbd8c9, 0x3ef178a4, 0x3f2252f7, 0x3f4e603b,
     0x3f7599a4, 0x3f97f925, 0x3fb57972, 0x3fce15fd, 0x3fe1cafd, 0x3ff09566, 0x3ffa72f0, 0x3fff6217,
 };
-static const INT32 sa_fwin_2fs_ldac[LDAC_2FSLSU] = { /* Q30 */
+LDAC_HOT_TABLE static const INT32 sa_fwin_2fs_ldac[LDAC_2FSLSU] = { /* Q30 */
     0x0000277a, 0x0001634c, 0x0003dae2, 0x00078e25, 0x000c7cf0, 0x0012a713, 0x001a0c51, 0x0022ac60,
     0x002c86ec, 0x00379b93, 0x0043e9e8, 0x00517172, 0x006031aa, 0x00702a00, 0x008159d6, 0x0093c082,
     0x00a75d4f, 0x00bc2f7a, 0x00d23637, 0x00e970ac, 0x0101ddf4, 0x011b7d1e, 0x01364d2c, 0x01524d17,
@@ -77,7 +77,7 @@ static const INT32 sa_fwin_2fs_ldac[LDAC_2FSLSU] = { /* Q30 */
     MDCT/IMDCT Tables
 ***************************************************************************************************/
 DECLFUNC const INT32 *gaa_wcos_ldac[LDAC_NUMLNN];
-static const INT32 sa_wcos_1fs_ldac[LDAC_1FSLSU] = { /* Q31 */
+LDAC_HOT_TABLE static const INT32 sa_wcos_1fs_ldac[LDAC_1FSLSU] = { /* Q31 */
     0x5a82799a, 0x7641af3d, 0xcf043ab3, 0x7d8a5f40, 0x471cece7, 0xe70747c4, 0x9592675c, 0x7f62368f,
     0x70e2cbc6, 0x5133cc94, 0x25280c5e, 0xf3742ca2, 0xc3a94590, 0x9d0dfe54, 0x8582faa5, 0x7fd8878e,
     0x7c29fbee, 0x73b5ebd1, 0x66cf8120, 0x55f5a4d2, 0x41ce1e65, 0x2b1f34eb, 0x12c8106f, 0xf9b82684,
@@ -95,7 +95,7 @@ static const INT32 sa_wcos_1fs_ldac[LDAC_1FSLSU] = { /* Q31 */
     0x2d553afc, 0x2a61b101, 0x27679df4, 0x24677758, 0x2161b3a0, 0x1e56ca1e, 0x1b4732ef, 0x183366e9,
     0x151bdf86, 0x120116d5, 0x0ee38766, 0x0bc3ac35, 0x08a2009a, 0x057f0035, 0x025b26d7, 0x00000000,
 };
-static const INT32 sa_wcos_2fs_ldac[LDAC_2FSLSU] = { /* Q31 */
+LDAC_HOT_TABLE static const INT32 sa_wcos_2fs_ldac[LDAC_2FSLSU] = { /* Q31 */
     0x5a82799a, 0x7641af3d, 0xcf043ab3, 0x7d8a5f40, 0x471cece7, 0xe70747c4, 0x9592675c, 0x7f62368f,
     0x70e2cbc6, 0x5133cc94, 0x25280c5e, 0xf3742ca2, 0xc3a94590, 0x9d0dfe54, 0x8582faa5, 0x7fd8878e,
     0x7c29fbee, 0x73b5ebd1, 0x66cf8120, 0x55f5a4d2, 0x41ce1e65, 0x2b1f34eb, 0x12c8106f, 0xf9b82684,
@@ -131,7 +131,7 @@ static const INT32 sa_wcos_2fs_ldac[LDAC_2FSLSU] = { /* Q31 */
 };
 
 DECLFUNC const INT32 *gaa_wsin_ldac[LDAC_NUMLNN];
-static const INT32 sa_wsin_1fs_ldac[LDAC_1FSLSU] = { /* Q31 */
+LDAC_HOT_TABLE static const INT32 sa_wsin_1fs_ldac[LDAC_1FSLSU] = { /* Q31 */
     0x5a82799a, 0x30fbc54d, 0x7641af3d, 0x18f8b83c, 0x6a6d98a4, 0x7d8a5f40, 0x471cece7, 0x0c8bd35e,
     0x3c56ba70, 0x62f201ac, 0x7a7d055b, 0x7f62368f, 0x70e2cbc6, 0x5133cc94, 0x25280c5e, 0x0647d97c,
     0x1f19f97b, 0x36ba2014, 0x4c3fdff4, 0x5ed77c8a, 0x6dca0d14, 0x78848414, 0x7e9d55fc, 0x7fd8878e,
@@ -149,7 +149,7 @@ static const INT32 sa_wsin_1fs_ldac[LDAC_1FSLSU] = { /* Q31 */
     0x77b417df, 0x78c7aba2, 0x79c89f6e, 0x7ab6cba4, 0x7b920b89, 0x7c5a3d50, 0x7d0f4218, 0x7db0fdf8,
     0x7e3f57ff, 0x7eba3a39, 0x7f2191b4, 0x7f754e80, 0x7fb563b3, 0x7fe1c76b, 0x7ffa72d1, 0x00000000,
 };
-static const INT32 sa_wsin_2fs_ldac[LDAC_2FSLSU] = { /* Q31 */
+LDAC_HOT_TABLE static const INT32 sa_wsin_2fs_ldac[LDAC_2FSLSU] = { /* Q31 */
     0x5a82799a, 0x30fbc54d, 0x7641af3d, 0x18f8b83c, 0x6a6d98a4, 0x7d8a5f40, 0x471cece7, 0x0c8bd35e,
     0x3c56ba70, 0x62f201ac, 0x7a7d055b, 0x7f62368f, 0x70e2cbc6, 0x5133cc94, 0x25280c5e, 0x0647d97c,
     0x1f19f97b, 0x36ba2014, 0x4c3fdff4, 0x5ed77c8a, 0x6dca0d14, 0x78848414, 0x7e9d55fc, 0x7fd8878e,
@@ -185,7 +185,7 @@ static const INT32 sa_wsin_2fs_ldac[LDAC_2FSLSU] = { /* Q31 */
 };
 
 DECLFUNC const int *gaa_perm_ldac[LDAC_NUMLNN];
-static const int sa_perm_1fs_ldac[LDAC_1FSLSU] = {
+LDAC_HOT_TABLE static const int sa_perm_1fs_ldac[LDAC_1FSLSU] = {
       0,  64,  96,  32,  48, 112,  80,  16,  24,  88, 120,  56,  40, 104,  72,   8,
      12,  76, 108,  44,  60, 124,  92,  28,  20,  84, 116,  52,  36, 100,  68,   4,
       6,  70, 102,  38,  54, 118,  86,  22,  30,  94, 126,  62,  46, 110,  78,  14,
@@ -195,7 +195,7 @@ static const int sa_perm_1fs_ldac[LDAC_1FSLSU] = {
       5,  69, 101,  37,  53, 117,  85,  21,  29,  93, 125,  61,  45, 109,  77,  13,
       9,  73, 105,  41,  57, 121,  89,  25,  17,  81, 113,  49,  33,  97,  65,   1,
 };
-static const int sa_perm_2fs_ldac[LDAC_2FSLSU] = {
+LDAC_HOT_TABLE static const int sa_perm_2fs_ldac[LDAC_2FSLSU] = {
       0, 128, 192,  64,  96, 224, 160,  32,  48, 176, 240, 112,  80, 208, 144,  16,
      24, 152, 216,  88, 120, 248, 184,  56,  40, 168, 232, 104,  72, 200, 136,   8,
      12, 140, 204,  76, 108, 236, 172,  44,  60, 188, 252, 124,  92, 220, 156,  28,
@@ -233,7 +233,7 @@ DECLFUNC const INT32 ga_sf_ldac[LDAC_NIDSF] = { /* Q15 */
     Quantization Tables
 ***************************************************************************************************/
 /* Quantize Factor for Spectrum/Residual Quantization */
-DECLFUNC const INT32 ga_qf_ldac[LDAC_NIDWL] = { /* Q16 */
+LDAC_HOT_TABLE DECLFUNC const INT32 ga_qf_ldac[LDAC_NIDWL] = { /* Q16 */
     0x00008000, 0x00018000, 0x00038000, 0x00078000,
     0x000f8000, 0x001f8000, 0x003f8000, 0x007f8000,
     0x00ff8000, 0x01ff8000, 0x03ff8000, 0x07ff8000,
@@ -241,7 +241,7 @@ DECLFUNC const INT32 ga_qf_ldac[LDAC_NIDWL] = { /* Q16 */
 };
 
 /* Inverse of Quantize Factor for Spectrum/Residual Quantization */
-DECLFUNC const INT32 ga_iqf_ldac[LDAC_NIDWL] = { /* Q31 */
+LDAC_HOT_TABLE DECLFUNC const INT32 ga_iqf_ldac[LDAC_NIDWL] = { /* Q31 */
     0x80000000, 0x55555555, 0x24924925, 0x11111111,
     0x08421084, 0x04104104, 0x02040810, 0x01010101,
     0x00804020, 0x00401004, 0x00200401, 0x00100100,
@@ -249,7 +249,7 @@ DECLFUNC const INT32 ga_iqf_ldac[LDAC_NIDWL] = { /* Q31 */
 };
 
 /* Inverse of Scale Factor for Residual Normalization */
-DECLFUNC const INT32 ga_irsf_ldac[LDAC_NIDWL] = { /* Q15 */
+LDAC_HOT_TABLE DECLFUNC const INT32 ga_irsf_ldac[LDAC_NIDWL] = { /* Q15 */
     0x00007f80, 0x00017e80, 0x00037c80, 0x00077880,
     0x000f7080, 0x001f6080, 0x003f4080, 0x007f0080,
     0x00fe8080, 0x01fd8080, 0x03fb8080, 0x07f78080,
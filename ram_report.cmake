@@ -0,0 +1,123 @@
+# Prints the static RAM per module, the object file or library its input sections come from, and
+# with HOT_PATHS the RAM taken by the encoder code and tables that CODEC_HOT_PATHS_IN_RAM moves out
+# of flash. Run after the link with the linker map of the firmware:
+#   cmake -DMAP_FILE=<firmware>.elf.map [-DHOT_PATHS=ON] -P ram_report.cmake
+#
+# An input section counts as RAM when it is placed in SRAM: data, bss, scratch and code copied to
+# RAM. Heap and stacks are reserved by the linker script and not part of any module.
+# The hot paths come from the .time_critical.* input sections of the app and libldac. Their names
+# say which codec they belong to, code and tables shared by all codecs (packet queue, PCM ring) are
+# reported separately.
+
+# RP2040 SRAM, striped banks and the two scratch banks
+set(RAM_START 0x20000000)
+set(RAM_END 0x20042000)
+
+if (NOT EXISTS "${MAP_FILE}")
+    message(FATAL_ERROR "ram_report: no linker map at '${MAP_FILE}'")
+endif ()
+
+file(READ "${MAP_FILE}" map)
+
+# skip the discarded input sections listed at the top of the map
+string(FIND "${map}" "Linker script and memory map" start)
+if (start GREATER -1)
+    string(SUBSTRING "${map}" ${start} -1 map)
+endif ()
+
+# long section names wrap, the address and size follow on the next line
+string(REGEX MATCHALL "\n (\\.[A-Za-z0-9_.$]+|COMMON)[ \t\n]+0x[0-9a-f]+[ \t]+0x[0-9a-f]+[ \t]+[^\n]+"
+        sections "${map}")
+set(modules "")
+set(module_sizes "")
+foreach (section IN LISTS sections)
+    string(REGEX MATCH "(0x[0-9a-f]+)[ \t]+(0x[0-9a-f]+)[ \t]+([^\n]+)$" unused "${section}")
+    math(EXPR address "${CMAKE_MATCH_1}")
+    math(EXPR size "${CMAKE_MATCH_2}")
+    set(object "${CMAKE_MATCH_3}")
+    if (size EQUAL 0 OR address LESS RAM_START OR NOT address LESS RAM_END)
+        continue()
+    endif ()
+
+    # a library by its archive, an object of the firmware by its source file
+    if (object MATCHES "([^/]+\\.a)\\(")
+        set(module "${CMAKE_MATCH_1}")
+    else ()
+        get_filename_component(module "${object}" NAME)
+        string(REGEX REPLACE "\\.(obj|o)$" "" module "${module}")
+    endif ()
+    list(FIND modules "${module}" index)
+    if (index EQUAL -1)
+        list(APPEND modules "${module}")
+        list(APPEND module_sizes ${size})
+    else ()
+        list(GET module_sizes ${index} sum)
+        math(EXPR sum "${sum} + ${size}")
+        list(REMOVE_AT module_sizes ${index})
+        list(INSERT module_sizes ${index} ${sum})
+    endif ()
+endforeach ()
+
+# largest first, sorted on the zero padded size
+set(report "")
+set(total 0)
+foreach (module size IN ZIP_LISTS modules module_sizes)
+    math(EXPR total "${total} + ${size}")
+    string(LENGTH "${size}" digits)
+    math(EXPR padding "8 - ${digits}")
+    string(REPEAT "0" ${padding} zeros)
+    list(APPEND report "${zeros}${size} ${module}")
+endforeach ()
+list(SORT report ORDER DESCENDING)
+message(STATUS "Static RAM per module:")
+foreach (line IN LISTS report)
+    string(REGEX MATCH "^0*([0-9]+) (.+)$" unused "${line}")
+    message(STATUS "  ${CMAKE_MATCH_1} bytes ${CMAKE_MATCH_2}")
+endforeach ()
+message(STATUS "  total: ${total} bytes")
+
+if (NOT HOT_PATHS)
+    return()
+endif ()
+
+foreach (codec LDAC SBC shared)
+    set(code_${codec} 0)
+    set(tables_${codec} 0)
+endforeach ()
+
+# long section names wrap, the address and size follow on the next line
+string(REGEX MATCHALL "\n \\.time_critical\\.[A-Za-z0-9_]+[ \t\n]+0x[0-9a-f]+[ \t]+0x[0-9a-f]+[ \t]+[^\n]+"
+        entries "${map}")
+foreach (entry IN LISTS entries)
+    string(REGEX MATCH "\\.time_critical\\.([A-Za-z0-9_]+)[ \t\n]+0x[0-9a-f]+[ \t]+(0x[0-9a-f]+)[ \t]+([^\n]+)"
+            unused "${entry}")
+    set(name "${CMAKE_MATCH_1}")
+    set(size "${CMAKE_MATCH_2}")
+    set(object "${CMAKE_MATCH_3}")
+    if (NOT object MATCHES "ldacBT|btstack_avdtp_source|audio_ring")
+        continue()
+    endif ()
+
+    if (name MATCHES "ldac")
+        set(codec LDAC)
+    elseif (name MATCHES "sbc")
+        set(codec SBC)
+    else ()
+        set(codec shared)
+    endif ()
+    if (name MATCHES "_tables$")
+        set(kind tables)
+    else ()
+        set(kind code)
+    endif ()
+    math(EXPR ${kind}_${codec} "${${kind}_${codec}} + ${size}")
+endforeach ()
+
+set(total 0)
+message(STATUS "Encoder hot paths in RAM:")
+foreach (codec LDAC SBC shared)
+    math(EXPR sum "${code_${codec}} + ${tables_${codec}}")
+    math(EXPR total "${total} + ${sum}")
+    message(STATUS "  ${codec}: ${sum} bytes (code ${code_${codec}}, tables ${tables_${codec}})")
+endforeach ()
+message(STATUS "  total: ${total} bytes")
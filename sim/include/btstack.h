@@ -0,0 +1,454 @@
+//
+// Stand-in for the parts of BTstack the app uses, for the host simulation only.
+//
+// Types and constants carry the BTstack names so src/btstack compiles unchanged. AVDTP events
+// are built by the simulated sink in sim_avdtp.c, their layout is our own and only has to agree
+// with the getters below:
+//
+//   [0] HCI_EVENT_AVDTP_META  [1] length  [2] subevent  [3..4] avdtp_cid  [5..] subevent fields
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_BTSTACK_H
+#define PICOW_USB_BT_AUDIO_SIM_BTSTACK_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// on the Pico the BTstack port pulls this in
+#include "pico/stdlib.h"
+
+#define UNUSED(x) (void)(x)
+#define btstack_assert(condition) assert(condition)
+
+typedef uint8_t bd_addr_t[6];
+typedef uint16_t hci_con_handle_t;
+#define HCI_CON_HANDLE_INVALID 0xffff
+
+typedef void (*btstack_packet_handler_t)(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+// run loop
+typedef struct btstack_timer_source {
+    void (*process)(struct btstack_timer_source *ts);
+    void *context;
+    uint32_t timeout;   // absolute, ms
+} btstack_timer_source_t;
+
+typedef struct {
+    void (*callback)(void *context);
+    void *context;
+} btstack_context_callback_registration_t;
+
+void btstack_run_loop_set_timer(btstack_timer_source_t *ts, uint32_t timeout_in_ms);
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *ts));
+void btstack_run_loop_set_timer_context(btstack_timer_source_t *ts, void *context);
+void *btstack_run_loop_get_timer_context(btstack_timer_source_t *ts);
+void btstack_run_loop_add_timer(btstack_timer_source_t *ts);
+int btstack_run_loop_remove_timer(btstack_timer_source_t *ts);
+uint32_t btstack_run_loop_get_time_ms(void);
+void btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t *callback_registration);
+
+typedef enum {
+    DATA_SOURCE_CALLBACK_POLL  = 1 << 0,
+    DATA_SOURCE_CALLBACK_READ  = 1 << 1,
+    DATA_SOURCE_CALLBACK_WRITE = 1 << 2,
+} btstack_data_source_callback_type_t;
+
+// only polled data sources, polled when an interrupt asks for it
+typedef struct btstack_data_source {
+    struct btstack_data_source *next;
+    void (*process)(struct btstack_data_source *ds, btstack_data_source_callback_type_t callback_type);
+    uint16_t flags;
+} btstack_data_source_t;
+
+void btstack_run_loop_set_data_source_handler(btstack_data_source_t *ds,
+                                              void (*process)(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type));
+void btstack_run_loop_enable_data_source_callbacks(btstack_data_source_t *ds, uint16_t callbacks);
+void btstack_run_loop_add_data_source(btstack_data_source_t *ds);
+void btstack_run_loop_poll_data_sources_from_irq(void);
+
+// hci
+enum {
+    HCI_EVENT_PACKET = 0x04,
+    HCI_EVENT_AVDTP_META = 0xee,
+    ERROR_CODE_SUCCESS = 0x00,
+    ERROR_CODE_COMMAND_DISALLOWED = 0x0c,
+};
+
+typedef enum {
+    HCI_POWER_OFF = 0,
+    HCI_POWER_ON,
+} HCI_POWER_MODE;
+
+int hci_power_control(HCI_POWER_MODE mode);
+uint16_t hci_number_free_acl_slots_for_handle(hci_con_handle_t con_handle);
+void l2cap_init(void);
+void gap_local_bd_addr(bd_addr_t address_buffer);
+void gap_delete_all_link_keys(void);
+char *bd_addr_to_str(const bd_addr_t addr);
+
+static inline uint8_t hci_event_packet_get_type(const uint8_t *event){
+    return event[0];
+}
+
+static inline uint16_t little_endian_read_16(const uint8_t *buffer, int position){
+    return (uint16_t) (buffer[position] | (buffer[position + 1] << 8));
+}
+
+static inline uint32_t btstack_min(uint32_t a, uint32_t b){
+    return a < b ? a : b;
+}
+
+static inline uint32_t btstack_max(uint32_t a, uint32_t b){
+    return a > b ? a : b;
+}
+
+static inline uint16_t store_bit16(uint16_t bitmap, int position, uint8_t value){
+    if (value){
+        bitmap |= 1 << position;
+    } else {
+        bitmap &= ~(1 << position);
+    }
+    return bitmap;
+}
+
+// sdp
+void sdp_init(void);
+uint8_t sdp_register_service(const uint8_t *record);
+
+// avdtp
+typedef enum {
+    AVDTP_AUDIO = 0,
+    AVDTP_VIDEO,
+    AVDTP_MULTIMEDIA,
+} avdtp_media_type_t;
+
+typedef enum {
+    AVDTP_SOURCE = 0,
+    AVDTP_SINK,
+} avdtp_sep_type_t;
+
+typedef enum {
+    AVDTP_CODEC_SBC = 0x00,
+    AVDTP_CODEC_MPEG_1_2_AUDIO = 0x01,
+    AVDTP_CODEC_MPEG_2_4_AAC = 0x02,
+    AVDTP_CODEC_ATRAC_FAMILY = 0x04,
+    AVDTP_CODEC_NON_A2DP = 0xff,
+} avdtp_media_codec_type_t;
+
+typedef enum {
+    AVDTP_SERVICE_CATEGORY_INVALID_0 = 0,
+    AVDTP_MEDIA_TRANSPORT,
+    AVDTP_REPORTING,
+    AVDTP_RECOVERY,
+    AVDTP_CONTENT_PROTECTION,
+    AVDTP_HEADER_COMPRESSION,
+    AVDTP_MULTIPLEXING,
+    AVDTP_MEDIA_CODEC,
+    AVDTP_DELAY_REPORTING,
+} avdtp_service_category_t;
+
+typedef enum {
+    AVDTP_SI_NONE = 0,
+    AVDTP_SI_DISCOVER,
+    AVDTP_SI_GET_CAPABILITIES,
+    AVDTP_SI_SET_CONFIGURATION,
+    AVDTP_SI_GET_CONFIGURATION,
+    AVDTP_SI_RECONFIGURE,
+    AVDTP_SI_OPEN,
+    AVDTP_SI_START,
+    AVDTP_SI_CLOSE,
+    AVDTP_SI_SUSPEND,
+    AVDTP_SI_ABORT,
+    AVDTP_SI_SECURITY_CONTROL,
+    AVDTP_SI_GET_ALL_CAPABILITIES,
+    AVDTP_SI_DELAY_REPORT,
+} avdtp_signal_identifier_t;
+
+// sbc capability bitmaps as on the air
+enum {
+    AVDTP_SBC_48000 = 1,
+    AVDTP_SBC_44100 = 2,
+    AVDTP_SBC_32000 = 4,
+    AVDTP_SBC_16000 = 8,
+};
+
+enum {
+    AVDTP_SBC_JOINT_STEREO = 1,
+    AVDTP_SBC_STEREO = 2,
+    AVDTP_SBC_DUAL_CHANNEL = 4,
+    AVDTP_SBC_MONO = 8,
+};
+
+typedef enum {
+    AVDTP_CHANNEL_MODE_JOINT_STEREO = 1,
+    AVDTP_CHANNEL_MODE_STEREO = 2,
+    AVDTP_CHANNEL_MODE_DUAL_CHANNEL = 4,
+    AVDTP_CHANNEL_MODE_MONO = 8,
+} avdtp_channel_mode_t;
+
+typedef enum {
+    AVDTP_SBC_ALLOCATION_METHOD_LOUDNESS = 1,
+    AVDTP_SBC_ALLOCATION_METHOD_SNR = 2,
+} avdtp_sbc_allocation_method_t;
+
+enum {
+    AVDTP_AAC_MPEG2_LC = 0x80,
+    AVDTP_AAC_MPEG4_LC = 0x40,
+    AVDTP_AAC_MPEG4_LTP = 0x20,
+    AVDTP_AAC_MPEG4_SCALABLE = 0x10,
+};
+
+#define AVDTP_SOURCE_FEATURE_MASK_PLAYER 0x0001u
+#define AVDTP_MEDIA_PAYLOAD_HEADER_SIZE 12
+
+typedef struct {
+    avdtp_media_type_t media_type;
+    avdtp_media_codec_type_t media_codec_type;
+    uint16_t media_codec_information_len;
+    uint8_t *media_codec_information;
+} adtvp_media_codec_capabilities_t;
+
+typedef struct {
+    adtvp_media_codec_capabilities_t media_codec;
+} avdtp_capabilities_t;
+
+typedef struct {
+    uint8_t seid;
+    uint8_t in_use;
+    avdtp_media_type_t media_type;
+    avdtp_sep_type_t type;
+    avdtp_capabilities_t capabilities;
+} avdtp_sep_t;
+
+typedef struct {
+    avdtp_sep_t sep;
+    avdtp_media_codec_type_t media_codec_type;
+    uint8_t *media_codec_configuration_info;
+    uint16_t media_codec_configuration_len;
+    uint16_t remote_configuration_bitmap;
+    avdtp_capabilities_t remote_configuration;
+    // sim: preferences of the local endpoint
+    uint32_t preferred_sampling_frequency;
+    uint8_t preferred_channel_mode;
+} avdtp_stream_endpoint_t;
+
+typedef struct {
+    uint16_t sampling_frequency;
+    avdtp_channel_mode_t channel_mode;
+    uint8_t block_length;
+    uint8_t subbands;
+    avdtp_sbc_allocation_method_t allocation_method;
+    uint8_t min_bitpool_value;
+    uint8_t max_bitpool_value;
+} avdtp_configuration_sbc_t;
+
+typedef struct {
+    uint8_t object_type;
+    uint32_t sampling_frequency;
+    uint8_t channels;
+    uint32_t bit_rate;
+    uint8_t vbr;
+} avdtp_configuration_mpeg_aac_t;
+
+void avdtp_source_init(void);
+void avdtp_source_register_packet_handler(btstack_packet_handler_t callback);
+uint8_t avdtp_source_connect(bd_addr_t remote, uint16_t *avdtp_cid);
+uint8_t avdtp_source_discover_stream_endpoints(uint16_t avdtp_cid);
+uint8_t avdtp_source_get_all_capabilities(uint16_t avdtp_cid, uint8_t remote_seid);
+uint8_t avdtp_source_set_configuration(uint16_t avdtp_cid, uint8_t local_seid, uint8_t remote_seid,
+                                       uint16_t configured_services_bitmap, avdtp_capabilities_t configuration);
+uint8_t avdtp_source_open_stream(uint16_t avdtp_cid, uint8_t local_seid, uint8_t remote_seid);
+uint8_t avdtp_source_start_stream(uint16_t avdtp_cid, uint8_t local_seid);
+uint8_t avdtp_source_suspend(uint16_t avdtp_cid, uint8_t local_seid);
+uint8_t avdtp_source_stop_stream(uint16_t avdtp_cid, uint8_t local_seid);
+uint8_t avdtp_source_abort_stream(uint16_t avdtp_cid, uint8_t local_seid);
+uint8_t avdtp_source_register_delay_reporting_category(uint8_t seid);
+uint8_t avdtp_local_seid(const avdtp_stream_endpoint_t *stream_endpoint);
+void avdtp_set_preferred_sampling_frequency(avdtp_stream_endpoint_t *stream_endpoint, uint32_t sampling_frequency);
+void avdtp_set_preferred_channel_mode(avdtp_stream_endpoint_t *stream_endpoint, uint8_t channel_mode);
+const char *avdtp_si2str(uint16_t index);
+
+uint16_t avdtp_choose_sbc_sampling_frequency(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_sampling_frequency_bitmap);
+avdtp_channel_mode_t avdtp_choose_sbc_channel_mode(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_channel_mode_bitmap);
+uint8_t avdtp_choose_sbc_block_length(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_block_length_bitmap);
+uint8_t avdtp_choose_sbc_subbands(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_subbands_bitmap);
+avdtp_sbc_allocation_method_t avdtp_choose_sbc_allocation_method(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_allocation_method_bitmap);
+uint8_t avdtp_choose_sbc_max_bitpool_value(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_max_bitpool_value);
+uint8_t avdtp_choose_sbc_min_bitpool_value(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_min_bitpool_value);
+void avdtp_config_sbc_store(uint8_t *config, const avdtp_configuration_sbc_t *configuration);
+void avdtp_config_mpeg_aac_store(uint8_t *config, const avdtp_configuration_mpeg_aac_t *configuration);
+
+// a2dp / avrcp
+avdtp_stream_endpoint_t *a2dp_source_create_stream_endpoint(avdtp_media_type_t media_type, avdtp_media_codec_type_t media_codec_type,
+                                                            const uint8_t *codec_capabilities, uint16_t codec_capabilities_len,
+                                                            uint8_t *codec_configuration, uint16_t codec_configuration_len);
+void a2dp_source_create_sdp_record(uint8_t *service, uint32_t service_record_handle, uint16_t supported_features,
+                                   const char *service_name, const char *service_provider_name);
+uint8_t a2dp_source_disconnect(uint16_t a2dp_cid);
+int a2dp_max_media_payload_size(uint16_t avdtp_cid, uint8_t local_seid);
+uint8_t a2dp_source_stream_endpoint_request_can_send_now(uint16_t avdtp_cid, uint8_t local_seid);
+uint8_t a2dp_source_stream_send_media_payload_rtp(uint16_t a2dp_cid, uint8_t local_seid, uint8_t marker, uint32_t timestamp,
+                                                  uint8_t *payload, uint16_t payload_size);
+int a2dp_source_stream_send_media_packet(uint16_t a2dp_cid, uint8_t local_seid, const uint8_t *packet, uint16_t size);
+uint8_t avrcp_disconnect(uint16_t avrcp_cid);
+
+// sbc encoder
+typedef enum {
+    SBC_MODE_STANDARD = 0,
+    SBC_MODE_mSBC,
+} btstack_sbc_mode_t;
+
+typedef enum {
+    SBC_CHANNEL_MODE_MONO = 0,
+    SBC_CHANNEL_MODE_DUAL_CHANNEL,
+    SBC_CHANNEL_MODE_STEREO,
+    SBC_CHANNEL_MODE_JOINT_STEREO,
+} btstack_sbc_channel_mode_t;
+
+typedef enum {
+    SBC_LOUDNESS = 0,
+    SBC_SNR,
+} btstack_sbc_allocation_method_t;
+
+typedef struct {
+    void *context;
+} btstack_sbc_encoder_state_t;
+
+void btstack_sbc_encoder_init(btstack_sbc_encoder_state_t *state, btstack_sbc_mode_t mode, int blocks, int subbands,
+                              btstack_sbc_allocation_method_t allocation_method, int sample_rate, int bitpool,
+                              btstack_sbc_channel_mode_t channel_mode);
+void btstack_sbc_encoder_process_data(int16_t *input_buffer);
+uint8_t *btstack_sbc_encoder_sbc_buffer(void);
+uint16_t btstack_sbc_encoder_sbc_buffer_length(void);
+int btstack_sbc_encoder_num_audio_frames(void);
+
+// avdtp subevents, the order carries no meaning here
+enum {
+    AVDTP_SUBEVENT_SIGNALING_ACCEPT = 0x01,
+    AVDTP_SUBEVENT_SIGNALING_REJECT,
+    AVDTP_SUBEVENT_SIGNALING_GENERAL_REJECT,
+    AVDTP_SUBEVENT_SIGNALING_CONNECTION_ESTABLISHED,
+    AVDTP_SUBEVENT_SIGNALING_CONNECTION_RELEASED,
+    AVDTP_SUBEVENT_SIGNALING_SEP_FOUND,
+    AVDTP_SUBEVENT_SIGNALING_SEP_DICOVERY_DONE,
+    AVDTP_SUBEVENT_SIGNALING_CAPABILITIES_DONE,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_TRANSPORT_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_REPORTING_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_RECOVERY_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_CONTENT_PROTECTION_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_MULTIPLEXING_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_DELAY_REPORTING_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_DELAY_REPORT,
+    AVDTP_SUBEVENT_SIGNALING_HEADER_COMPRESSION_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_MPEG_AUDIO_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_MPEG_AAC_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_ATRAC_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_OTHER_CAPABILITY,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CONFIGURATION,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_MPEG_AUDIO_CONFIGURATION,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_MPEG_AAC_CONFIGURATION,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_ATRAC_CONFIGURATION,
+    AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_OTHER_CONFIGURATION,
+    AVDTP_SUBEVENT_STREAMING_CONNECTION_ESTABLISHED,
+    AVDTP_SUBEVENT_STREAMING_CONNECTION_RELEASED,
+    AVDTP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW,
+};
+
+// fields of the subevents the simulated sink sends
+#define AVDTP_SIM_EVENT_CID               3
+#define AVDTP_SIM_EVENT_FIELDS            5
+
+#define AVDTP_SIM_GETTER_8(name, offset) \
+    static inline uint8_t name(const uint8_t *event){ return event[AVDTP_SIM_EVENT_FIELDS + (offset)]; }
+#define AVDTP_SIM_GETTER_16(name, offset) \
+    static inline uint16_t name(const uint8_t *event){ return little_endian_read_16(event, AVDTP_SIM_EVENT_FIELDS + (offset)); }
+#define AVDTP_SIM_GETTER_CID(name) \
+    static inline uint16_t name(const uint8_t *event){ return little_endian_read_16(event, AVDTP_SIM_EVENT_CID); }
+
+AVDTP_SIM_GETTER_CID(avdtp_subevent_signaling_connection_established_get_avdtp_cid)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_connection_established_get_status, 0)
+AVDTP_SIM_GETTER_16(avdtp_subevent_signaling_connection_established_get_con_handle, 1)
+
+AVDTP_SIM_GETTER_CID(avdtp_subevent_streaming_connection_established_get_avdtp_cid)
+AVDTP_SIM_GETTER_8(avdtp_subevent_streaming_connection_established_get_status, 0)
+AVDTP_SIM_GETTER_8(avdtp_subevent_streaming_connection_established_get_local_seid, 1)
+AVDTP_SIM_GETTER_8(avdtp_subevent_streaming_connection_established_get_remote_seid, 2)
+
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_sep_found_get_remote_seid, 0)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_sep_found_get_in_use, 1)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_sep_found_get_media_type, 2)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_sep_found_get_sep_type, 3)
+
+// every media codec capability starts with the remote seid and the media type
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_capability_get_remote_seid, 0)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_capability_get_sampling_frequency_bitmap, 2)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_capability_get_channel_mode_bitmap, 3)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_capability_get_block_length_bitmap, 4)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_capability_get_subbands_bitmap, 5)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_capability_get_allocation_method_bitmap, 6)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_capability_get_min_bitpool_value, 7)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_capability_get_max_bitpool_value, 8)
+
+AVDTP_SIM_GETTER_8(a2dp_subevent_signaling_media_codec_mpeg_aac_capability_get_object_type_bitmap, 2)
+AVDTP_SIM_GETTER_16(a2dp_subevent_signaling_media_codec_mpeg_aac_capability_get_sampling_frequency_bitmap, 3)
+AVDTP_SIM_GETTER_8(a2dp_subevent_signaling_media_codec_mpeg_aac_capability_get_channels_bitmap, 5)
+AVDTP_SIM_GETTER_16(a2dp_subevent_signaling_media_codec_mpeg_aac_capability_get_bit_rate, 6)
+AVDTP_SIM_GETTER_8(a2dp_subevent_signaling_media_codec_mpeg_aac_capability_get_vbr, 8)
+
+AVDTP_SIM_GETTER_16(avdtp_subevent_signaling_media_codec_other_capability_get_media_codec_information_len, 3)
+static inline const uint8_t *avdtp_subevent_signaling_media_codec_other_capability_get_media_codec_information(const uint8_t *event){
+    return &event[AVDTP_SIM_EVENT_FIELDS + 5];
+}
+static inline const uint8_t *a2dp_subevent_signaling_media_codec_other_capability_get_media_codec_information(const uint8_t *event){
+    return avdtp_subevent_signaling_media_codec_other_capability_get_media_codec_information(event);
+}
+
+// configurations: local seid, remote seid, reconfigure, media type, then the codec fields
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_configuration_get_reconfigure, 2)
+AVDTP_SIM_GETTER_16(avdtp_subevent_signaling_media_codec_sbc_configuration_get_sampling_frequency, 4)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_configuration_get_channel_mode, 6)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_configuration_get_num_channels, 7)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_configuration_get_block_length, 8)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_configuration_get_subbands, 9)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_configuration_get_allocation_method, 10)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_configuration_get_min_bitpool_value, 11)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_media_codec_sbc_configuration_get_max_bitpool_value, 12)
+
+AVDTP_SIM_GETTER_8(a2dp_subevent_signaling_media_codec_other_configuration_get_reconfigure, 2)
+AVDTP_SIM_GETTER_16(a2dp_subevent_signaling_media_codec_other_configuration_get_media_codec_information_len, 4)
+static inline const uint8_t *a2dp_subevent_signaling_media_codec_other_configuration_get_media_codec_information(const uint8_t *event){
+    return &event[AVDTP_SIM_EVENT_FIELDS + 6];
+}
+
+// local seid, is initiator, signal identifier
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_accept_get_signal_identifier, 2)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_reject_get_signal_identifier, 2)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_general_reject_get_signal_identifier, 2)
+
+// never sent by the simulated sink, only here so the app compiles
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_recovery_capability_get_recovery_type, 0)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_recovery_capability_get_maximum_recovery_window_size, 1)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_recovery_capability_get_maximum_number_media_packets, 2)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_content_protection_capability_get_cp_type, 0)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_content_protection_capability_get_cp_type_value_len, 1)
+static inline const char *avdtp_subevent_signaling_content_protection_capability_get_cp_type_value(const uint8_t *event){
+    return (const char *) &event[AVDTP_SIM_EVENT_FIELDS + 2];
+}
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_multiplexing_capability_get_fragmentation, 0)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_multiplexing_capability_get_transport_identifiers_num, 1)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_multiplexing_capability_get_transport_session_identifier_1, 2)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_multiplexing_capability_get_transport_session_identifier_2, 3)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_multiplexing_capability_get_transport_session_identifier_3, 4)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_multiplexing_capability_get_tcid_1, 5)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_multiplexing_capability_get_tcid_2, 6)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_multiplexing_capability_get_tcid_3, 7)
+AVDTP_SIM_GETTER_16(avdtp_subevent_signaling_delay_report_get_delay_100us, 0)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_delay_report_get_local_seid, 2)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_header_compression_capability_get_back_ch, 0)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_header_compression_capability_get_media, 1)
+AVDTP_SIM_GETTER_8(avdtp_subevent_signaling_header_compression_capability_get_recovery, 2)
+
+#endif //PICOW_USB_BT_AUDIO_SIM_BTSTACK_H
@@ -0,0 +1,20 @@
+//
+// Stand-in for hardware/clocks.h, host simulation only
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_HARDWARE_CLOCKS_H
+#define PICOW_USB_BT_AUDIO_SIM_HARDWARE_CLOCKS_H
+
+#include "pico/platform.h"
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+// main.c runs the system clock at 230 MHz
+static inline uint32_t clock_get_hz(enum clock_index clk_index){
+    (void) clk_index;
+    return 230000000u;
+}
+
+#endif //PICOW_USB_BT_AUDIO_SIM_HARDWARE_CLOCKS_H
@@ -0,0 +1,32 @@
+//
+// Stand-in for hardware/sync.h, host simulation only
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_HARDWARE_SYNC_H
+#define PICOW_USB_BT_AUDIO_SIM_HARDWARE_SYNC_H
+
+#include "pico/platform.h"
+
+static inline void __mem_fence_acquire(void){
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static inline void __mem_fence_release(void){
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void tight_loop_contents(void){
+}
+
+// core 0 ringing the doorbell runs core 1 until it waits again, see sim_platform.c
+void __sev(void);
+void __wfe(void);
+
+typedef volatile uint32_t spin_lock_t;
+
+spin_lock_t *spin_lock_instance(uint lock_num);
+int spin_lock_claim_unused(bool required);
+uint32_t spin_lock_blocking(spin_lock_t *lock);
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq);
+
+#endif //PICOW_USB_BT_AUDIO_SIM_HARDWARE_SYNC_H
@@ -0,0 +1,14 @@
+//
+// Stand-in for pico/flash.h, host simulation only
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_PICO_FLASH_H
+#define PICOW_USB_BT_AUDIO_SIM_PICO_FLASH_H
+
+#include <stdbool.h>
+
+static inline bool flash_safe_execute_core_init(void){
+    return true;
+}
+
+#endif //PICOW_USB_BT_AUDIO_SIM_PICO_FLASH_H
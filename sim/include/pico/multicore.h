@@ -0,0 +1,13 @@
+//
+// Stand-in for pico/multicore.h, host simulation only
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_PICO_MULTICORE_H
+#define PICOW_USB_BT_AUDIO_SIM_PICO_MULTICORE_H
+
+#include "pico/platform.h"
+
+// core 1 is a thread that runs in lockstep with core 0, see sim_platform.c
+void multicore_launch_core1(void (*entry)(void));
+
+#endif //PICOW_USB_BT_AUDIO_SIM_PICO_MULTICORE_H
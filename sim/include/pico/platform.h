@@ -0,0 +1,32 @@
+//
+// Stand-in for pico/platform.h, host simulation only
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_PICO_PLATFORM_H
+#define PICOW_USB_BT_AUDIO_SIM_PICO_PLATFORM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define NUM_CORES 2
+
+#ifndef __packed
+#define __packed __attribute__((packed))
+#endif
+#ifndef __unused
+#define __unused __attribute__((unused))
+#endif
+
+// everything runs from host memory
+#define __not_in_flash_func(func_name) func_name
+#define __no_inline_not_in_flash_func(func_name) __attribute__((noinline)) func_name
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+// 0 for the run loop thread, 1 for the encoder thread started by multicore_launch_core1
+uint get_core_num(void);
+
+#endif //PICOW_USB_BT_AUDIO_SIM_PICO_PLATFORM_H
@@ -0,0 +1,24 @@
+//
+// Stand-in for pico/stdlib.h, host simulation only
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_PICO_STDLIB_H
+#define PICOW_USB_BT_AUDIO_SIM_PICO_STDLIB_H
+
+#include <assert.h>
+
+#include "pico/platform.h"
+
+// advances the simulated clock, USB keeps interrupting meanwhile
+void sleep_ms(uint32_t ms);
+
+// simulated time, on core 1 it includes its current job so far, scaled like its run time
+uint32_t time_us_32(void);
+
+// no debug pins on the host
+#define CU_REGISTER_DEBUG_PINS(...)
+#define CU_SELECT_DEBUG_PINS(...)
+#define DEBUG_PINS_SET(p, v) ((void) 0)
+#define DEBUG_PINS_CLR(p, v) ((void) 0)
+
+#endif //PICOW_USB_BT_AUDIO_SIM_PICO_STDLIB_H
@@ -0,0 +1,138 @@
+//
+// Stand-in for the pico-extras usb_device library, host simulation only.
+//
+// Only what usb_sound.c touches is here. The simulated host in pipeline_sim.c fills the buffer
+// returned by usb_current_out_packet_buffer() and calls the endpoint's packet handler directly.
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_PICO_USB_DEVICE_H
+#define PICOW_USB_BT_AUDIO_SIM_PICO_USB_DEVICE_H
+
+#include <stdio.h>
+
+#include "pico/platform.h"
+
+#define USB_REQ_TYPE_TYPE_MASK          0x60u
+#define USB_REQ_TYPE_TYPE_CLASS         0x20u
+#define USB_REQ_TYPE_RECIPIENT_MASK     0x1fu
+#define USB_REQ_TYPE_RECIPIENT_INTERFACE 0x01u
+#define USB_REQ_TYPE_RECIPIENT_ENDPOINT 0x02u
+
+struct __packed usb_setup_packet {
+    uint8_t bmRequestType;
+    uint8_t bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+};
+
+struct __packed usb_device_descriptor {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint16_t bcdUSB;
+    uint8_t bDeviceClass;
+    uint8_t bDeviceSubClass;
+    uint8_t bDeviceProtocol;
+    uint8_t bMaxPacketSize0;
+    uint16_t idVendor;
+    uint16_t idProduct;
+    uint16_t bcdDevice;
+    uint8_t iManufacturer;
+    uint8_t iProduct;
+    uint8_t iSerialNumber;
+    uint8_t bNumConfigurations;
+};
+
+struct __packed usb_configuration_descriptor {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint16_t wTotalLength;
+    uint8_t bNumInterfaces;
+    uint8_t bConfigurationValue;
+    uint8_t iConfiguration;
+    uint8_t bmAttributes;
+    uint8_t bMaxPower;
+};
+
+struct __packed usb_interface_descriptor {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bInterfaceNumber;
+    uint8_t bAlternateSetting;
+    uint8_t bNumEndpoints;
+    uint8_t bInterfaceClass;
+    uint8_t bInterfaceSubClass;
+    uint8_t bInterfaceProtocol;
+    uint8_t iInterface;
+};
+
+struct __packed usb_endpoint_descriptor_long {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bEndpointAddress;
+    uint8_t bmAttributes;
+    uint16_t wMaxPacketSize;
+    uint8_t bInterval;
+    uint8_t bRefresh;
+    uint8_t bSyncAddr;
+};
+
+struct usb_buffer {
+    uint8_t *data;
+    uint16_t data_len;
+    uint16_t data_max;
+};
+
+struct usb_endpoint;
+struct usb_interface;
+
+struct usb_transfer_type {
+    void (*on_packet)(struct usb_endpoint *ep);
+    uint8_t initial_packet_count;
+};
+
+struct usb_transfer {
+    const struct usb_transfer_type *type;
+    uint32_t remaining_packets_to_submit;
+};
+
+struct usb_endpoint {
+    struct usb_transfer *default_transfer;
+    struct usb_transfer *current_transfer;
+    bool (*setup_request_handler)(struct usb_endpoint *ep, struct usb_setup_packet *setup);
+};
+
+struct usb_interface {
+    const struct usb_interface_descriptor *descriptor;
+    struct usb_endpoint *const *endpoints;
+    uint8_t endpoint_count;
+    bool (*setup_request_handler)(struct usb_interface *interface, struct usb_setup_packet *setup);
+    bool (*set_alternate_handler)(struct usb_interface *interface, uint alt);
+};
+
+struct usb_device {
+    const struct usb_device_descriptor *device_descriptor;
+    const struct usb_configuration_descriptor *config_descriptor;
+};
+
+struct usb_interface *usb_interface_init(struct usb_interface *interface, const struct usb_interface_descriptor *descriptor,
+                                         struct usb_endpoint *const *endpoints, uint endpoint_count,
+                                         bool double_buffered);
+struct usb_device *usb_device_init(const struct usb_device_descriptor *descriptor,
+                                   const struct usb_configuration_descriptor *config_desc,
+                                   struct usb_interface *const *interfaces, uint interface_count,
+                                   const char *(*get_descriptor_string)(uint index));
+void usb_device_start(void);
+void usb_set_default_transfer(struct usb_endpoint *ep, struct usb_transfer *transfer);
+struct usb_buffer *usb_current_out_packet_buffer(struct usb_endpoint *ep);
+struct usb_buffer *usb_current_in_packet_buffer(struct usb_endpoint *ep);
+void usb_grow_transfer(struct usb_transfer *transfer, uint packet_count);
+void usb_packet_done(struct usb_endpoint *ep);
+void usb_start_control_out_transfer(const struct usb_transfer_type *type);
+void usb_start_empty_control_in_transfer_null_completion(void);
+void usb_start_tiny_control_in_transfer(uint32_t data, uint8_t len);
+
+#define usb_debug(format, ...) ((void) 0)
+#define usb_warn(format, ...) printf(format, ##__VA_ARGS__)
+
+#endif //PICOW_USB_BT_AUDIO_SIM_PICO_USB_DEVICE_H
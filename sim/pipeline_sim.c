@@ -0,0 +1,454 @@
+//
+// Host simulation of the USB -> encoder -> A2DP pipeline, see sim.h
+//
+// Plays WAV files (or a 1 kHz tone) into the USB audio interface the way a host does: one
+// isochronous packet per 1 ms USB frame, sized by the device's feedback, on a host clock that may
+// drift against the Pico's. The app connects to a simulated sink, and the report at the end shows
+// what the sink got.
+//
+//   pipeline_sim [options] [file.wav ...]
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "btstack.h"
+#include "btstack/btstack_avdtp_source.h"
+#include "usb_sound.h"
+
+#include "sim.h"
+
+#define SIM_SAMPLE_RATE             44100u
+// UAC1 SET_CUR of the sampling frequency control of the streaming endpoint
+#define SIM_AUDIO_REQ_SET_CUR       0x01u
+#define SIM_SAMPLING_FREQ_CONTROL   0x01u
+#define SIM_TONE_HZ                 1000.0
+#define SIM_TONE_AMPLITUDE          16384.0
+#define SIM_RECONNECT_AT_US         10000u
+// the sync endpoint is polled every 2^bRefresh frames
+#define SIM_FEEDBACK_PERIOD_FRAMES  4u
+#define SIM_MAX_PACKET_FRAMES       64u
+
+typedef struct {
+    int16_t * samples;      // interleaved stereo
+    uint32_t frames;
+    uint32_t position;
+    bool tone;
+    double tone_phase;
+} sim_input_t;
+
+static sim_input_t input;
+
+static struct {
+    uint32_t sample_rate;
+    double frame_period_us;     // USB frame length on the Pico's clock
+    double next_frame_us;
+    bool ignore_feedback;
+    uint32_t feedback;          // 10.14 samples per frame
+    uint32_t fraction;          // 14 bit sample remainder carried over
+    uint32_t frames;
+    uint64_t samples;
+    uint32_t feedback_min;
+    uint32_t feedback_max;
+    struct usb_interface * streaming_interface;
+    struct usb_endpoint * ep_out;
+    struct usb_endpoint * ep_sync;
+    bool input_done;
+    // host closes the streaming interface for a while, e.g. paused playback
+    uint64_t idle_at_us;
+    uint64_t idle_us;
+    // host switches the sample rate, e.g. another app opens the device
+    uint64_t rate_switch_at_us;
+    uint32_t rate_switch;
+    // ring statistics when the stream started, the ring overruns while the sink connects
+    bool streaming;
+    uint32_t overrun_base;
+    uint32_t underrun_base;
+} host;
+
+static int16_t usb_packet[SIM_MAX_PACKET_FRAMES * 2];
+static uint8_t usb_sync_packet[4];
+
+static uint16_t read_le16(const uint8_t * data){
+    return (uint16_t) (data[0] | (data[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t * data){
+    return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+// appends a 16 bit PCM WAV file, mono is duplicated to both channels
+static bool input_add_wav(const char * path){
+    FILE * file = fopen(path, "rb");
+    if (file == NULL){
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    uint8_t header[12];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(&header[8], "WAVE", 4) != 0){
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        fclose(file);
+        return false;
+    }
+    uint16_t channels = 0;
+    uint16_t bits = 0;
+    uint32_t rate = 0;
+    bool ok = false;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, sizeof(chunk), file) == sizeof(chunk)){
+        uint32_t size = read_le32(&chunk[4]);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16){
+            uint8_t fmt[16];
+            if (fread(fmt, 1, sizeof(fmt), file) != sizeof(fmt)) break;
+            if (read_le16(&fmt[0]) != 1){
+                fprintf(stderr, "%s: only PCM is supported\n", path);
+                break;
+            }
+            channels = read_le16(&fmt[2]);
+            rate = read_le32(&fmt[4]);
+            bits = read_le16(&fmt[14]);
+            fseek(file, (long) (size - sizeof(fmt) + (size & 1)), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0){
+            if (bits != 16 || (channels != 1 && channels != 2)){
+                fprintf(stderr, "%s: only 16 bit mono or stereo is supported\n", path);
+                break;
+            }
+            if (rate != host.sample_rate){
+                fprintf(stderr, "%s: %u Hz played as %u Hz\n", path, (unsigned) rate, (unsigned) host.sample_rate);
+            }
+            uint32_t frames = size / (2u * channels);
+            int16_t * samples = realloc(input.samples, (size_t) (input.frames + frames) * 2 * sizeof(int16_t));
+            if (samples == NULL){
+                fprintf(stderr, "%s: out of memory\n", path);
+                break;
+            }
+            input.samples = samples;
+            int16_t * out = &input.samples[input.frames * 2];
+            uint8_t raw[4];
+            uint32_t read = 0;
+            for (; read < frames; read++){
+                if (fread(raw, 2, channels, file) != channels) break;
+                out[2 * read] = (int16_t) read_le16(&raw[0]);
+                out[2 * read + 1] = (int16_t) read_le16(&raw[channels == 2 ? 2 : 0]);
+            }
+            input.frames += read;
+            ok = true;
+            break;
+        } else {
+            fseek(file, (long) (size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fclose(file);
+    if (!ok && bits == 0){
+        fprintf(stderr, "%s: no PCM data\n", path);
+    }
+    return ok;
+}
+
+static uint32_t input_read(int16_t * out, uint32_t frames){
+    if (input.tone){
+        for (uint32_t i = 0; i < frames; i++){
+            int16_t sample = (int16_t) (SIM_TONE_AMPLITUDE * sin(input.tone_phase));
+            out[2 * i] = sample;
+            out[2 * i + 1] = sample;
+            input.tone_phase += 2.0 * M_PI * SIM_TONE_HZ / host.sample_rate;
+            if (input.tone_phase > 2.0 * M_PI){
+                input.tone_phase -= 2.0 * M_PI;
+            }
+        }
+        return frames;
+    }
+    uint32_t left = input.frames - input.position;
+    if (frames > left){
+        frames = left;
+    }
+    memcpy(out, &input.samples[input.position * 2], frames * 2 * sizeof(int16_t));
+    input.position += frames;
+    return frames;
+}
+
+// USB host
+
+static void usb_poll_feedback(void){
+    sim_usb_in_buffer.data = usb_sync_packet;
+    sim_usb_in_buffer.data_max = sizeof(usb_sync_packet);
+    sim_usb_in_buffer.data_len = 0;
+    host.ep_sync->current_transfer->type->on_packet(host.ep_sync);
+    if (sim_usb_in_buffer.data_len < 3) return;
+
+    uint32_t value = usb_sync_packet[0] | (usb_sync_packet[1] << 8) | (usb_sync_packet[2] << 16);
+    if (host.feedback_min == 0 || value < host.feedback_min) host.feedback_min = value;
+    if (value > host.feedback_max) host.feedback_max = value;
+    if (!host.ignore_feedback){
+        host.feedback = value;
+    }
+}
+
+static void usb_set_alternate(uint alt){
+    if (host.streaming_interface->set_alternate_handler != NULL){
+        host.streaming_interface->set_alternate_handler(host.streaming_interface, alt);
+    }
+}
+
+static void usb_set_sample_rate(uint32_t sample_rate){
+    struct usb_setup_packet setup = {
+            .bmRequestType = USB_REQ_TYPE_TYPE_CLASS | USB_REQ_TYPE_RECIPIENT_ENDPOINT,
+            .bRequest = SIM_AUDIO_REQ_SET_CUR,
+            .wValue = SIM_SAMPLING_FREQ_CONTROL << 8,
+            .wLength = 3,
+    };
+    uint8_t data[4] = {sample_rate & 0xff, (sample_rate >> 8) & 0xff, (sample_rate >> 16) & 0xff, 0};
+    if (!sim_usb_control_out(host.ep_out, &setup, data, 3)){
+        fprintf(stderr, "sim: device stalled the sample rate request\n");
+        exit(EXIT_FAILURE);
+    }
+    host.sample_rate = sample_rate;
+    host.feedback = (sample_rate << 14) / 1000u;
+}
+
+static void usb_frame(void * arg);
+
+static void usb_host_resume(void * arg){
+    (void) arg;
+    usb_set_alternate(1);
+    sim_sink_host_resumed();
+    host.next_frame_us = (double) sim_time_us() + host.frame_period_us;
+    sim_call_at((uint64_t) host.next_frame_us, &usb_frame, NULL, true);
+}
+
+static void usb_frame(void * arg){
+    (void) arg;
+    if (host.idle_us != 0 && sim_time_us() >= host.idle_at_us){
+        // no more packets until the host selects alternate setting 1 again
+        usb_set_alternate(0);
+        sim_call_at(sim_time_us() + host.idle_us, &usb_host_resume, NULL, true);
+        host.idle_us = 0;
+        return;
+    }
+    if (host.rate_switch != 0 && sim_time_us() >= host.rate_switch_at_us){
+        // like a host does it: close the stream, set the rate, open it again
+        usb_set_alternate(0);
+        usb_set_sample_rate(host.rate_switch);
+        usb_set_alternate(1);
+        sim_sink_host_resumed();
+        host.rate_switch = 0;
+    }
+    if (!host.streaming && sim_sink_streaming() && sim_audio_ring != NULL){
+        host.streaming = true;
+        host.overrun_base = sim_audio_ring->overrun_frames;
+        host.underrun_base = sim_audio_ring->underrun_frames;
+    }
+    if (host.frames % SIM_FEEDBACK_PERIOD_FRAMES == 0){
+        usb_poll_feedback();
+    }
+
+    uint32_t samples = host.fraction + host.feedback;
+    uint32_t frames = samples >> 14;
+    host.fraction = samples & 0x3fffu;
+    if (frames > SIM_MAX_PACKET_FRAMES){
+        frames = SIM_MAX_PACKET_FRAMES;
+    }
+    frames = input_read(usb_packet, frames);
+    if (frames == 0){
+        host.input_done = true;
+        return;
+    }
+
+    sim_usb_out_buffer.data = (uint8_t *) usb_packet;
+    sim_usb_out_buffer.data_max = sizeof(usb_packet);
+    sim_usb_out_buffer.data_len = frames * 2 * sizeof(int16_t);
+    host.ep_out->current_transfer->type->on_packet(host.ep_out);
+    host.frames++;
+    host.samples += frames;
+
+    host.next_frame_us += host.frame_period_us;
+    sim_call_at((uint64_t) host.next_frame_us, &usb_frame, NULL, true);
+}
+
+static void usb_host_start(double drift_ppm, bool ignore_feedback){
+    if (sim_usb_device.interface_count < 2 || sim_usb_device.interfaces[1]->endpoint_count < 2){
+        fprintf(stderr, "sim: USB audio streaming interface missing\n");
+        exit(EXIT_FAILURE);
+    }
+    host.streaming_interface = sim_usb_device.interfaces[1];
+    host.ep_out = host.streaming_interface->endpoints[0];
+    host.ep_sync = host.streaming_interface->endpoints[1];
+    usb_set_alternate(1);
+    usb_set_sample_rate(host.sample_rate);
+
+    // a fast host clock sends its frames early on ours
+    host.frame_period_us = 1000.0 / (1.0 + drift_ppm * 1e-6);
+    host.ignore_feedback = ignore_feedback;
+    host.next_frame_us = (double) sim_time_us() + host.frame_period_us;
+    sim_call_at((uint64_t) host.next_frame_us, &usb_frame, NULL, true);
+}
+
+static void reconnect(void * arg){
+    (void) arg;
+    a2dp_source_reconnect();
+}
+
+static void usage(const char * name){
+    fprintf(stderr,
+            "usage: %s [options] [file.wav ...]\n"
+            "  -c ldac|sbc      best codec the sink offers (ldac)\n"
+            "  -4               that codec takes 44.1 kHz only\n"
+            "  -t seconds       length of the run, and of the tone without files (10)\n"
+            "  -d ppm           host clock drift against the Pico, positive is fast (0)\n"
+            "  -F               host ignores the feedback endpoint\n"
+            "  -i at:length     host closes the streaming interface for length ms at at ms\n"
+            "  -R hz            host sample rate, 44100 or 48000 (44100)\n"
+            "  -x at:hz         host switches to another sample rate at at ms\n"
+            "  -l us            can send now latency (500)\n"
+            "  -j us            can send now jitter on top of the latency (500)\n"
+            "  -r kbps          air rate of the media channel (1400)\n"
+            "  -b buffers       controller ACL buffers (4)\n"
+            "  -m bytes         media channel MTU (895)\n"
+            "  -s period:stall  radio stalls of stall ms every period ms\n"
+            "  -p ms            sink prebuffer (100)\n"
+            "  -k factor        simulated us per host us of encoding (1)\n"
+            "  -o file          write the RTP stream, each packet preceded by its 32 bit LE length\n"
+            "  -S seed          seed of the jitter (1)\n"
+            "  -q quality       fail unless LDAC ABR ends the run at this quality, HQ SQ Q0 Q1 or MQ\n",
+            name);
+}
+
+int main(int argc, char * argv[]){
+    sim_sink_config_t sink = {
+            .codec = SIM_CODEC_LDAC,
+            .media_mtu = 895,
+            .link_kbps = 1400,
+            .acl_buffers = 4,
+            .can_send_latency_us = 500,
+            .can_send_jitter_us = 500,
+            .prebuffer_ms = 100,
+    };
+    double seconds = 10.0;
+    host.sample_rate = SIM_SAMPLE_RATE;
+    double drift_ppm = 0.0;
+    double encoder_cost = 1.0;
+    bool ignore_feedback = false;
+    unsigned seed = 1;
+    const char * expect_quality = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:4t:d:Fi:R:x:l:j:r:b:m:s:p:k:o:S:q:h")) != -1){
+        switch (opt){
+            case 'c':
+                if (strcmp(optarg, "ldac") == 0){
+                    sink.codec = SIM_CODEC_LDAC;
+                } else if (strcmp(optarg, "sbc") == 0){
+                    sink.codec = SIM_CODEC_SBC;
+                } else {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case '4': sink.codec_44k_only = true; break;
+            case 't': seconds = atof(optarg); break;
+            case 'd': drift_ppm = atof(optarg); break;
+            case 'F': ignore_feedback = true; break;
+            case 'i': {
+                unsigned idle_at_ms;
+                unsigned idle_ms;
+                if (sscanf(optarg, "%u:%u", &idle_at_ms, &idle_ms) != 2){
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                host.idle_at_us = (uint64_t) idle_at_ms * 1000u;
+                host.idle_us = (uint64_t) idle_ms * 1000u;
+                break;
+            }
+            case 'R': host.sample_rate = (uint32_t) atoi(optarg); break;
+            case 'x': {
+                unsigned switch_at_ms;
+                unsigned switch_rate;
+                if (sscanf(optarg, "%u:%u", &switch_at_ms, &switch_rate) != 2){
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                host.rate_switch_at_us = (uint64_t) switch_at_ms * 1000u;
+                host.rate_switch = switch_rate;
+                break;
+            }
+            case 'l': sink.can_send_latency_us = (uint32_t) atoi(optarg); break;
+            case 'j': sink.can_send_jitter_us = (uint32_t) atoi(optarg); break;
+            case 'r': sink.link_kbps = (uint32_t) atoi(optarg); break;
+            case 'b': sink.acl_buffers = (uint8_t) atoi(optarg); break;
+            case 'm': sink.media_mtu = (uint16_t) atoi(optarg); break;
+            case 's':
+                if (sscanf(optarg, "%u:%u", &sink.stall_period_ms, &sink.stall_ms) != 2){
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p': sink.prebuffer_ms = (uint32_t) atoi(optarg); break;
+            case 'k': encoder_cost = atof(optarg); break;
+            case 'o':
+                sink.rtp_dump = fopen(optarg, "wb");
+                if (sink.rtp_dump == NULL){
+                    fprintf(stderr, "%s: cannot create\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'S': seed = (unsigned) atoi(optarg); break;
+            case 'q': expect_quality = optarg; break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for (int i = optind; i < argc; i++){
+        if (!input_add_wav(argv[i])) return EXIT_FAILURE;
+    }
+    input.tone = optind == argc;
+
+    srand(seed);
+    sim_sink_init(&sink);
+    sim_set_encoder_cost(encoder_cost);
+
+    usb_audio_main();
+    btstack_main(0, NULL);
+    usb_host_start(drift_ppm, ignore_feedback);
+    sim_call_at(SIM_RECONNECT_AT_US, &reconnect, NULL, false);
+
+    uint64_t end_us = (uint64_t) (seconds * 1e6);
+    while (sim_time_us() < end_us && !host.input_done){
+        sim_run_until(sim_time_us() + 1000u);
+    }
+
+    printf("\n--- usb ---\n");
+    printf("host              %u Hz, %.0f ppm, %s feedback, %u frames, %llu samples\n", (unsigned) host.sample_rate, drift_ppm,
+           ignore_feedback ? "ignoring" : "following", (unsigned) host.frames, (unsigned long long) host.samples);
+    printf("feedback          %.3f .. %.3f samples per frame\n",
+           host.feedback_min / 16384.0, host.feedback_max / 16384.0);
+    if (sim_audio_ring != NULL){
+        printf("ring              %u overrun frames, %u underrun frames while streaming\n",
+               (unsigned) (sim_audio_ring->overrun_frames - host.overrun_base),
+               (unsigned) (sim_audio_ring->underrun_frames - host.underrun_base));
+    }
+    printf("core 1            busy %.1f%% of the run\n", 100.0 * (double) sim_core1_busy_us() / (double) sim_time_us());
+    sim_sink_report();
+    if (sink.codec == SIM_CODEC_LDAC){
+        printf("\n--- ldac ---\n");
+        a2dp_ldac_governor_dump();
+    }
+
+    if (sink.rtp_dump != NULL){
+        fclose(sink.rtp_dump);
+    }
+    if (expect_quality != NULL){
+        const char * quality = a2dp_ldac_link_quality();
+        if (quality == NULL || strcmp(quality, expect_quality) != 0){
+            printf("\nFAIL: LDAC link at %s, expected %s\n", quality != NULL ? quality : "none", expect_quality);
+            return EXIT_FAILURE;
+        }
+        printf("\nLDAC link at %s as expected\n", quality);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+//
+// Host simulation of the USB -> encoder -> A2DP pipeline.
+//
+// src/ is compiled unchanged against the stand-in headers in sim/include. Everything runs on a
+// simulated clock: sim_platform.c provides the run loop and the pico bits, sim_avdtp.c the remote
+// sink, the radio and the RTP recorder, pipeline_sim.c the USB host and the command line.
+//
+
+#ifndef PICOW_USB_BT_AUDIO_SIM_H
+#define PICOW_USB_BT_AUDIO_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "pico/usb_device.h"
+#include "audio_ring.h"
+
+// clock and scheduler
+
+uint64_t sim_time_us(void);
+
+// runs fn(arg) on core 0 at the given time. Interrupts (USB) also run while core 0 sleeps.
+void sim_call_at(uint64_t at_us, void (*fn)(void *arg), void *arg, bool interrupt);
+
+// runs everything due up to until_us, then advances the clock to it
+void sim_run_until(uint64_t until_us);
+
+// simulated time charged per host microsecond core 1 spends encoding, 0 makes encoding free
+void sim_set_encoder_cost(double factor);
+// simulated time core 1 spent on its jobs so far
+uint64_t sim_core1_busy_us(void);
+
+// USB device side, as registered by usb_sound.c
+
+typedef struct {
+    struct usb_interface *interfaces[4];
+    uint interface_count;
+} sim_usb_device_t;
+
+extern sim_usb_device_t sim_usb_device;
+// buffers handed to the endpoint handlers
+extern struct usb_buffer sim_usb_out_buffer;
+extern struct usb_buffer sim_usb_in_buffer;
+
+// class request to an endpoint with its data stage, false if the device stalls it
+bool sim_usb_control_out(struct usb_endpoint *ep, struct usb_setup_packet *setup, uint8_t *data, uint16_t len);
+
+// the PCM ring usb_sound.c shares with the encoder, for its statistics
+extern audio_ring_t * sim_audio_ring;
+
+// remote sink and radio
+
+typedef enum {
+    SIM_CODEC_LDAC = 0,
+    SIM_CODEC_SBC,
+} sim_codec_t;
+
+typedef struct {
+    sim_codec_t codec;          // best codec the sink offers, SBC is always there
+    bool codec_44k_only;        // and that codec takes 44.1 kHz only
+    uint16_t media_mtu;         // L2CAP MTU of the media channel
+    uint32_t link_kbps;         // air rate available to the media channel
+    uint8_t  acl_buffers;       // controller ACL packet buffers
+    uint32_t can_send_latency_us;
+    uint32_t can_send_jitter_us;    // uniformly distributed on top of the latency
+    uint32_t stall_period_ms;   // radio pauses, e.g. for WiFi coexistence, 0 for none
+    uint32_t stall_ms;
+    uint32_t prebuffer_ms;      // sink jitter buffer before playback (re)starts
+    FILE *   rtp_dump;          // emitted RTP stream, NULL for none
+} sim_sink_config_t;
+
+void sim_sink_init(const sim_sink_config_t * config);
+// media is flowing: the stream is started and the first packet was sent
+bool sim_sink_streaming(void);
+// host selected the streaming interface again, the report shows how long until it is heard
+void sim_sink_host_resumed(void);
+void sim_sink_report(void);
+
+#endif //PICOW_USB_BT_AUDIO_SIM_H
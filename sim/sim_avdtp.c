@@ -0,0 +1,892 @@
+//
+// Simulated remote A2DP sink, radio and RTP recorder, see sim.h
+//
+// The sink answers the app's AVDTP commands with the events BTstack would deliver, a few ms
+// later. Media packets go through a FIFO radio with a fixed air rate, a limited number of
+// controller ACL buffers and optional stalls. Can send now is granted after a configurable,
+// jittered latency and only once an ACL buffer is free. Packets that made it over the air fill
+// the sink's jitter buffer, which plays out at the nominal rate and records every underrun.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack.h"
+#include <ldacBT.h>
+
+#include "sim.h"
+
+// AVDTP signaling round trip
+#define SIM_SIGNALING_DELAY_US      2000u
+// baseband, L2CAP and AVDTP headers on top of each media payload
+#define SIM_MEDIA_OVERHEAD_BYTES    (4 + 4 + AVDTP_MEDIA_PAYLOAD_HEADER_SIZE)
+#define SIM_MAX_ACL_BUFFERS         16
+#define SIM_MAX_LOCAL_SEPS          16
+#define SIM_AVDTP_CID               0x0001
+#define SIM_CON_HANDLE              0x000b
+#define SIM_EVENT_SIZE              64
+
+#define SIM_SEID_SBC                1
+#define SIM_SEID_LDAC               2
+
+static sim_sink_config_t config;
+static btstack_packet_handler_t packet_handler;
+
+static avdtp_stream_endpoint_t local_seps[SIM_MAX_LOCAL_SEPS];
+static uint8_t local_sep_configuration[SIM_MAX_LOCAL_SEPS][16];
+static uint8_t num_local_seps;
+
+static bool signaling_connected;
+static bool stream_open;
+static bool stream_started;
+static uint8_t stream_local_seid;
+static uint8_t stream_remote_seid;
+
+// sink side of the stream configuration
+static uint32_t stream_sample_rate;
+static uint32_t stream_frame_samples;     // per SBC frame, per LDAC frame
+static bool stream_ldac;
+
+// radio
+static uint64_t radio_busy_until_us;
+static uint64_t acl_done_us[SIM_MAX_ACL_BUFFERS];
+static uint8_t acl_used;
+
+// jitter buffer of the sink, in samples
+static double sink_level;
+static bool sink_playing;
+static bool sink_started;
+static uint64_t sink_last_us;
+
+static struct {
+    uint32_t packets;
+    uint64_t payload_bytes;
+    uint64_t first_send_us;
+    uint64_t last_send_us;
+    double interval_sum_ms;
+    double interval_sum_sq_ms;
+    double interval_max_ms;
+    // RFC 3550 interarrival jitter
+    double jitter_ms;
+    uint64_t last_arrival_us;
+    uint32_t last_timestamp;
+    uint32_t expected_timestamp;
+    uint32_t timestamp_gaps;
+    // can send now
+    uint32_t grants;
+    uint64_t grant_wait_sum_us;
+    uint64_t grant_wait_max_us;
+    // sink
+    uint32_t sink_underruns;
+    double sink_silent_ms;
+    // stream signaling, and the latest time the host came back from idle
+    uint32_t starts;
+    uint32_t suspends;
+    uint64_t resume_us;
+    uint64_t resume_first_send_us;
+    uint64_t resume_playing_us;
+} stats;
+
+// first packet after a START, its interval and transit do not continue the previous ones
+static bool stream_restarted;
+
+static void sink_stop(void);
+
+static uint16_t rtp_sequence;
+static uint64_t can_send_requested_us;
+
+// SBC frames of the stand-in encoder, length and header as on the air but silent
+static struct {
+    int blocks;
+    int subbands;
+    int bitpool;
+    int channel_mode;
+    int sample_rate;
+    int allocation_method;
+    uint16_t frame_length;
+    uint8_t frame[512];
+} sbc;
+
+static const uint8_t sink_sbc_capabilities[] = {
+    0xff,   // 16/32/44.1/48 kHz, all channel modes
+    0xff,   // 4..16 blocks, 4/8 subbands, SNR and loudness
+    2, 53
+};
+
+static const uint8_t sink_ldac_capabilities[] = {
+    0x2d, 0x01, 0x00, 0x00,     // Sony
+    0xaa, 0x00,                 // LDAC
+    0x3c,                       // 44.1/48/88.2/96 kHz
+    0x07,                       // stereo, dual channel, mono
+};
+
+// events
+
+typedef struct {
+    uint16_t size;
+    uint8_t data[SIM_EVENT_SIZE];
+} sim_avdtp_event_t;
+
+static void deliver_event(void * arg){
+    sim_avdtp_event_t * event = (sim_avdtp_event_t *) arg;
+    if (packet_handler != NULL){
+        (*packet_handler)(HCI_EVENT_PACKET, 0, event->data, event->size);
+    }
+    free(event);
+}
+
+static void send_event_at(uint64_t at_us, uint8_t subevent, const uint8_t * fields, uint16_t fields_len){
+    sim_avdtp_event_t * event = calloc(1, sizeof(sim_avdtp_event_t));
+    btstack_assert(event != NULL);
+    btstack_assert(AVDTP_SIM_EVENT_FIELDS + fields_len <= SIM_EVENT_SIZE);
+    event->data[0] = HCI_EVENT_AVDTP_META;
+    event->data[1] = (uint8_t) (AVDTP_SIM_EVENT_FIELDS - 2 + fields_len);
+    event->data[2] = subevent;
+    event->data[AVDTP_SIM_EVENT_CID] = SIM_AVDTP_CID & 0xff;
+    event->data[AVDTP_SIM_EVENT_CID + 1] = SIM_AVDTP_CID >> 8;
+    if (fields_len){
+        memcpy(&event->data[AVDTP_SIM_EVENT_FIELDS], fields, fields_len);
+    }
+    event->size = AVDTP_SIM_EVENT_FIELDS + fields_len;
+    sim_call_at(at_us, &deliver_event, event, false);
+}
+
+// signaling replies come in the order they were asked for
+static uint64_t signaling_reply_us(void){
+    static uint64_t last_reply_us;
+    uint64_t at_us = sim_time_us() + SIM_SIGNALING_DELAY_US;
+    if (at_us <= last_reply_us){
+        at_us = last_reply_us + 1;
+    }
+    last_reply_us = at_us;
+    return at_us;
+}
+
+static void send_event(uint8_t subevent, const uint8_t * fields, uint16_t fields_len){
+    send_event_at(signaling_reply_us(), subevent, fields, fields_len);
+}
+
+static void send_accept(uint8_t local_seid, uint8_t signal_identifier){
+    uint8_t fields[] = {local_seid, 1, signal_identifier};
+    send_event(AVDTP_SUBEVENT_SIGNALING_ACCEPT, fields, sizeof(fields));
+}
+
+static avdtp_stream_endpoint_t * find_local_sep(uint8_t seid){
+    if (seid == 0 || seid > num_local_seps) return NULL;
+    return &local_seps[seid - 1];
+}
+
+static bool sink_has_ldac(void){
+    return config.codec == SIM_CODEC_LDAC;
+}
+
+// sampling frequency bits the sink takes
+static uint8_t sink_sbc_sampling_frequencies(void){
+    bool only_44k = config.codec_44k_only && config.codec == SIM_CODEC_SBC;
+    return only_44k ? AVDTP_SBC_44100 : sink_sbc_capabilities[0] >> 4;
+}
+
+static uint8_t sink_ldac_sampling_frequencies(void){
+    return config.codec_44k_only ? 1 << 5 : sink_ldac_capabilities[6];
+}
+
+// AVDTP source API
+
+void avdtp_source_init(void){
+}
+
+void avdtp_source_register_packet_handler(btstack_packet_handler_t callback){
+    packet_handler = callback;
+}
+
+uint8_t avdtp_source_connect(bd_addr_t remote, uint16_t *avdtp_cid){
+    (void) remote;
+    *avdtp_cid = SIM_AVDTP_CID;
+    if (signaling_connected) return ERROR_CODE_COMMAND_DISALLOWED;
+    signaling_connected = true;
+    uint8_t fields[] = {ERROR_CODE_SUCCESS, SIM_CON_HANDLE & 0xff, SIM_CON_HANDLE >> 8};
+    send_event(AVDTP_SUBEVENT_SIGNALING_CONNECTION_ESTABLISHED, fields, sizeof(fields));
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_discover_stream_endpoints(uint16_t avdtp_cid){
+    (void) avdtp_cid;
+    uint8_t sbc_sep[] = {SIM_SEID_SBC, 0, AVDTP_AUDIO, AVDTP_SINK};
+    send_event(AVDTP_SUBEVENT_SIGNALING_SEP_FOUND, sbc_sep, sizeof(sbc_sep));
+    if (sink_has_ldac()){
+        uint8_t ldac_sep[] = {SIM_SEID_LDAC, 0, AVDTP_AUDIO, AVDTP_SINK};
+        send_event(AVDTP_SUBEVENT_SIGNALING_SEP_FOUND, ldac_sep, sizeof(ldac_sep));
+    }
+    send_event(AVDTP_SUBEVENT_SIGNALING_SEP_DICOVERY_DONE, NULL, 0);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_get_all_capabilities(uint16_t avdtp_cid, uint8_t remote_seid){
+    (void) avdtp_cid;
+    if (remote_seid == SIM_SEID_SBC){
+        uint8_t fields[2 + 7] = {remote_seid, AVDTP_AUDIO,
+                                 sink_sbc_sampling_frequencies(), sink_sbc_capabilities[0] & 0x0f,
+                                 sink_sbc_capabilities[1] >> 4, (sink_sbc_capabilities[1] >> 2) & 0x03,
+                                 sink_sbc_capabilities[1] & 0x03,
+                                 sink_sbc_capabilities[2], sink_sbc_capabilities[3]};
+        send_event(AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CAPABILITY, fields, sizeof(fields));
+    } else if (remote_seid == SIM_SEID_LDAC && sink_has_ldac()){
+        uint8_t fields[5 + sizeof(sink_ldac_capabilities)] = {remote_seid, AVDTP_AUDIO, AVDTP_CODEC_NON_A2DP,
+                                                             sizeof(sink_ldac_capabilities), 0};
+        memcpy(&fields[5], sink_ldac_capabilities, sizeof(sink_ldac_capabilities));
+        fields[5 + 6] = sink_ldac_sampling_frequencies();
+        send_event(AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_OTHER_CAPABILITY, fields, sizeof(fields));
+    } else {
+        uint8_t fields[] = {0, 0, AVDTP_SI_GET_ALL_CAPABILITIES};
+        send_event(AVDTP_SUBEVENT_SIGNALING_REJECT, fields, sizeof(fields));
+    }
+    send_event(AVDTP_SUBEVENT_SIGNALING_CAPABILITIES_DONE, NULL, 0);
+    return ERROR_CODE_SUCCESS;
+}
+
+static uint32_t sbc_sampling_frequency(uint8_t bitmap){
+    switch (bitmap){
+        case AVDTP_SBC_48000: return 48000;
+        case AVDTP_SBC_44100: return 44100;
+        case AVDTP_SBC_32000: return 32000;
+        case AVDTP_SBC_16000: return 16000;
+        default:              return 0;
+    }
+}
+
+static uint32_t ldac_sampling_frequency(uint8_t bitmap){
+    switch (bitmap){
+        case 1 << 2: return 96000;
+        case 1 << 3: return 88200;
+        case 1 << 4: return 48000;
+        case 1 << 5: return 44100;
+        default:     return 0;
+    }
+}
+
+uint8_t avdtp_source_set_configuration(uint16_t avdtp_cid, uint8_t local_seid, uint8_t remote_seid,
+                                       uint16_t configured_services_bitmap, avdtp_capabilities_t configuration){
+    (void) avdtp_cid;
+    (void) configured_services_bitmap;
+    avdtp_stream_endpoint_t * sep = find_local_sep(local_seid);
+    if (sep == NULL || stream_open) return ERROR_CODE_COMMAND_DISALLOWED;
+
+    const uint8_t * info = configuration.media_codec.media_codec_information;
+    uint16_t info_len = configuration.media_codec.media_codec_information_len;
+    if (info_len > sizeof(local_sep_configuration[0])) return ERROR_CODE_COMMAND_DISALLOWED;
+    memcpy(local_sep_configuration[local_seid - 1], info, info_len);
+    sep->remote_configuration = configuration;
+    sep->remote_configuration.media_codec.media_codec_information = local_sep_configuration[local_seid - 1];
+    sep->remote_configuration_bitmap = store_bit16(sep->remote_configuration_bitmap, AVDTP_MEDIA_CODEC, 1);
+
+    if (remote_seid == SIM_SEID_SBC && configuration.media_codec.media_codec_type == AVDTP_CODEC_SBC &&
+        (info[0] >> 4) & sink_sbc_sampling_frequencies()){
+        static const uint8_t block_lengths[] = {0, 16, 12, 0, 8, 0, 0, 0, 4};
+        static const uint8_t subbands[] = {0, 8, 4, 0};
+        uint8_t channel_mode = info[0] & 0x0f;
+        uint16_t sampling_frequency = (uint16_t) sbc_sampling_frequency(info[0] >> 4);
+        uint8_t block_length = block_lengths[(info[1] >> 4) & 0x0f];
+        uint8_t num_subbands = subbands[(info[1] >> 2) & 0x03];
+        uint8_t fields[] = {local_seid, remote_seid, 0, AVDTP_AUDIO,
+                            sampling_frequency & 0xff, sampling_frequency >> 8,
+                            channel_mode, channel_mode == AVDTP_CHANNEL_MODE_MONO ? 1 : 2,
+                            block_length, num_subbands, info[1] & 0x03, info[2], info[3]};
+        stream_sample_rate = sampling_frequency;
+        stream_frame_samples = (uint32_t) block_length * num_subbands;
+        stream_ldac = false;
+        send_event(AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CONFIGURATION, fields, sizeof(fields));
+    } else if (remote_seid == SIM_SEID_LDAC && sink_has_ldac() &&
+               configuration.media_codec.media_codec_type == AVDTP_CODEC_NON_A2DP &&
+               (info[6] & sink_ldac_sampling_frequencies())){
+        uint8_t fields[6 + sizeof(local_sep_configuration[0])] = {local_seid, remote_seid, 0, AVDTP_AUDIO,
+                                                                  info_len & 0xff, info_len >> 8};
+        memcpy(&fields[6], info, info_len);
+        stream_sample_rate = ldac_sampling_frequency(info[6]);
+        stream_frame_samples = stream_sample_rate > 48000 ? 2 * LDACBT_ENC_LSU : LDACBT_ENC_LSU;
+        stream_ldac = true;
+        send_event(AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_OTHER_CONFIGURATION, fields, (uint16_t) (6 + info_len));
+    } else {
+        uint8_t fields[] = {local_seid, 1, AVDTP_SI_SET_CONFIGURATION};
+        send_event(AVDTP_SUBEVENT_SIGNALING_REJECT, fields, sizeof(fields));
+        return ERROR_CODE_SUCCESS;
+    }
+    send_accept(local_seid, AVDTP_SI_SET_CONFIGURATION);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_open_stream(uint16_t avdtp_cid, uint8_t local_seid, uint8_t remote_seid){
+    (void) avdtp_cid;
+    if (!signaling_connected || stream_open || find_local_sep(local_seid) == NULL) return ERROR_CODE_COMMAND_DISALLOWED;
+    stream_open = true;
+    stream_local_seid = local_seid;
+    stream_remote_seid = remote_seid;
+    send_accept(local_seid, AVDTP_SI_OPEN);
+    uint8_t fields[] = {ERROR_CODE_SUCCESS, local_seid, remote_seid};
+    send_event(AVDTP_SUBEVENT_STREAMING_CONNECTION_ESTABLISHED, fields, sizeof(fields));
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_start_stream(uint16_t avdtp_cid, uint8_t local_seid){
+    (void) avdtp_cid;
+    if (!stream_open || local_seid != stream_local_seid) return ERROR_CODE_COMMAND_DISALLOWED;
+    stream_started = true;
+    stream_restarted = stats.packets > 0;
+    stats.starts++;
+    send_accept(local_seid, AVDTP_SI_START);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_suspend(uint16_t avdtp_cid, uint8_t local_seid){
+    (void) avdtp_cid;
+    if (!stream_started || local_seid != stream_local_seid) return ERROR_CODE_COMMAND_DISALLOWED;
+    stream_started = false;
+    stats.suspends++;
+    sink_stop();
+    send_accept(local_seid, AVDTP_SI_SUSPEND);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_stop_stream(uint16_t avdtp_cid, uint8_t local_seid){
+    (void) avdtp_cid;
+    if (!stream_open || local_seid != stream_local_seid) return ERROR_CODE_COMMAND_DISALLOWED;
+    stream_open = false;
+    stream_started = false;
+    sink_stop();
+    send_accept(local_seid, AVDTP_SI_CLOSE);
+    send_event(AVDTP_SUBEVENT_STREAMING_CONNECTION_RELEASED, NULL, 0);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_abort_stream(uint16_t avdtp_cid, uint8_t local_seid){
+    (void) avdtp_cid;
+    if (find_local_sep(local_seid) == NULL) return ERROR_CODE_COMMAND_DISALLOWED;
+    send_accept(local_seid, AVDTP_SI_ABORT);
+    if (stream_open){
+        stream_open = false;
+        stream_started = false;
+        sink_stop();
+        send_event(AVDTP_SUBEVENT_STREAMING_CONNECTION_RELEASED, NULL, 0);
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t a2dp_source_disconnect(uint16_t a2dp_cid){
+    (void) a2dp_cid;
+    if (!signaling_connected) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (stream_open){
+        stream_open = false;
+        stream_started = false;
+        send_event(AVDTP_SUBEVENT_STREAMING_CONNECTION_RELEASED, NULL, 0);
+    }
+    signaling_connected = false;
+    send_event(AVDTP_SUBEVENT_SIGNALING_CONNECTION_RELEASED, NULL, 0);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avrcp_disconnect(uint16_t avrcp_cid){
+    (void) avrcp_cid;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_source_register_delay_reporting_category(uint8_t seid){
+    (void) seid;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_local_seid(const avdtp_stream_endpoint_t *stream_endpoint){
+    return stream_endpoint->sep.seid;
+}
+
+void avdtp_set_preferred_sampling_frequency(avdtp_stream_endpoint_t *stream_endpoint, uint32_t sampling_frequency){
+    stream_endpoint->preferred_sampling_frequency = sampling_frequency;
+}
+
+void avdtp_set_preferred_channel_mode(avdtp_stream_endpoint_t *stream_endpoint, uint8_t channel_mode){
+    stream_endpoint->preferred_channel_mode = channel_mode;
+}
+
+const char *avdtp_si2str(uint16_t index){
+    static const char * const names[] = {
+        "NONE", "DISCOVER", "GET_CAPABILITIES", "SET_CONFIGURATION", "GET_CONFIGURATION", "RECONFIGURE",
+        "OPEN", "START", "CLOSE", "SUSPEND", "ABORT", "SECURITY_CONTROL", "GET_ALL_CAPABILITIES", "DELAY_REPORT",
+    };
+    return index < count_of(names) ? names[index] : "UNKNOWN";
+}
+
+avdtp_stream_endpoint_t *a2dp_source_create_stream_endpoint(avdtp_media_type_t media_type, avdtp_media_codec_type_t media_codec_type,
+                                                            const uint8_t *codec_capabilities, uint16_t codec_capabilities_len,
+                                                            uint8_t *codec_configuration, uint16_t codec_configuration_len){
+    (void) codec_configuration;
+    (void) codec_configuration_len;
+    if (num_local_seps >= SIM_MAX_LOCAL_SEPS) return NULL;
+    avdtp_stream_endpoint_t * sep = &local_seps[num_local_seps++];
+    memset(sep, 0, sizeof(avdtp_stream_endpoint_t));
+    sep->sep.seid = num_local_seps;
+    sep->sep.media_type = media_type;
+    sep->sep.type = AVDTP_SOURCE;
+    sep->sep.capabilities.media_codec.media_type = media_type;
+    sep->sep.capabilities.media_codec.media_codec_type = media_codec_type;
+    sep->sep.capabilities.media_codec.media_codec_information = (uint8_t *) codec_capabilities;
+    sep->sep.capabilities.media_codec.media_codec_information_len = codec_capabilities_len;
+    sep->media_codec_type = media_codec_type;
+    return sep;
+}
+
+void a2dp_source_create_sdp_record(uint8_t *service, uint32_t service_record_handle, uint16_t supported_features,
+                                   const char *service_name, const char *service_provider_name){
+    (void) service;
+    (void) service_record_handle;
+    (void) supported_features;
+    (void) service_name;
+    (void) service_provider_name;
+}
+
+// SBC configuration, picked the way BTstack does from what both sides support
+
+uint16_t avdtp_choose_sbc_sampling_frequency(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_sampling_frequency_bitmap){
+    static const uint8_t order[] = {AVDTP_SBC_44100, AVDTP_SBC_48000, AVDTP_SBC_32000, AVDTP_SBC_16000};
+    for (uint i = 0; i < count_of(order); i++){
+        if ((remote_sampling_frequency_bitmap & order[i]) &&
+            sbc_sampling_frequency(order[i]) == stream_endpoint->preferred_sampling_frequency){
+            return (uint16_t) stream_endpoint->preferred_sampling_frequency;
+        }
+    }
+    for (uint i = 0; i < count_of(order); i++){
+        if (remote_sampling_frequency_bitmap & order[i]) return (uint16_t) sbc_sampling_frequency(order[i]);
+    }
+    return 0;
+}
+
+avdtp_channel_mode_t avdtp_choose_sbc_channel_mode(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_channel_mode_bitmap){
+    if (remote_channel_mode_bitmap & stream_endpoint->preferred_channel_mode){
+        return (avdtp_channel_mode_t) stream_endpoint->preferred_channel_mode;
+    }
+    static const avdtp_channel_mode_t order[] = {AVDTP_CHANNEL_MODE_JOINT_STEREO, AVDTP_CHANNEL_MODE_STEREO,
+                                                 AVDTP_CHANNEL_MODE_DUAL_CHANNEL, AVDTP_CHANNEL_MODE_MONO};
+    for (uint i = 0; i < count_of(order); i++){
+        if (remote_channel_mode_bitmap & order[i]) return order[i];
+    }
+    return AVDTP_CHANNEL_MODE_JOINT_STEREO;
+}
+
+uint8_t avdtp_choose_sbc_block_length(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_block_length_bitmap){
+    (void) stream_endpoint;
+    if (remote_block_length_bitmap & 1) return 16;
+    if (remote_block_length_bitmap & 2) return 12;
+    if (remote_block_length_bitmap & 4) return 8;
+    return 4;
+}
+
+uint8_t avdtp_choose_sbc_subbands(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_subbands_bitmap){
+    (void) stream_endpoint;
+    return (remote_subbands_bitmap & 1) ? 8 : 4;
+}
+
+avdtp_sbc_allocation_method_t avdtp_choose_sbc_allocation_method(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_allocation_method_bitmap){
+    (void) stream_endpoint;
+    return (remote_allocation_method_bitmap & AVDTP_SBC_ALLOCATION_METHOD_LOUDNESS) ?
+           AVDTP_SBC_ALLOCATION_METHOD_LOUDNESS : AVDTP_SBC_ALLOCATION_METHOD_SNR;
+}
+
+uint8_t avdtp_choose_sbc_max_bitpool_value(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_max_bitpool_value){
+    uint8_t local_max = stream_endpoint->sep.capabilities.media_codec.media_codec_information[3];
+    return remote_max_bitpool_value < local_max ? remote_max_bitpool_value : local_max;
+}
+
+uint8_t avdtp_choose_sbc_min_bitpool_value(avdtp_stream_endpoint_t *stream_endpoint, uint8_t remote_min_bitpool_value){
+    uint8_t local_min = stream_endpoint->sep.capabilities.media_codec.media_codec_information[2];
+    return remote_min_bitpool_value > local_min ? remote_min_bitpool_value : local_min;
+}
+
+void avdtp_config_sbc_store(uint8_t *config, const avdtp_configuration_sbc_t *configuration){
+    uint8_t sampling_frequency;
+    switch (configuration->sampling_frequency){
+        case 48000: sampling_frequency = AVDTP_SBC_48000; break;
+        case 32000: sampling_frequency = AVDTP_SBC_32000; break;
+        case 16000: sampling_frequency = AVDTP_SBC_16000; break;
+        default:    sampling_frequency = AVDTP_SBC_44100; break;
+    }
+    uint8_t block_length;
+    switch (configuration->block_length){
+        case 4:  block_length = 8; break;
+        case 8:  block_length = 4; break;
+        case 12: block_length = 2; break;
+        default: block_length = 1; break;
+    }
+    uint8_t subbands = configuration->subbands == 4 ? 2 : 1;
+    config[0] = (uint8_t) ((sampling_frequency << 4) | configuration->channel_mode);
+    config[1] = (uint8_t) ((block_length << 4) | (subbands << 2) | configuration->allocation_method);
+    config[2] = configuration->min_bitpool_value;
+    config[3] = configuration->max_bitpool_value;
+}
+
+void avdtp_config_mpeg_aac_store(uint8_t *config, const avdtp_configuration_mpeg_aac_t *configuration){
+    (void) configuration;
+    memset(config, 0, 6);
+}
+
+// radio
+
+static uint64_t radio_skip_stall(uint64_t at_us){
+    if (config.stall_period_ms == 0 || config.stall_ms == 0) return at_us;
+    uint64_t period_us = (uint64_t) config.stall_period_ms * 1000u;
+    uint64_t offset_us = at_us % period_us;
+    uint64_t stall_us = (uint64_t) config.stall_ms * 1000u;
+    return offset_us < stall_us ? at_us - offset_us + stall_us : at_us;
+}
+
+// ACL buffers whose packet is still on its way at the given time
+static void radio_release(uint64_t now_us){
+    uint8_t used = 0;
+    for (uint8_t i = 0; i < acl_used; i++){
+        if (acl_done_us[i] > now_us){
+            acl_done_us[used++] = acl_done_us[i];
+        }
+    }
+    acl_used = used;
+}
+
+static uint64_t radio_transmit(uint16_t bytes){
+    uint64_t start_us = radio_skip_stall(radio_busy_until_us > sim_time_us() ? radio_busy_until_us : sim_time_us());
+    uint64_t air_us = ((uint64_t) (bytes + SIM_MEDIA_OVERHEAD_BYTES) * 8u * 1000u) / config.link_kbps;
+    radio_busy_until_us = start_us + air_us;
+    radio_release(sim_time_us());
+    if (acl_used < SIM_MAX_ACL_BUFFERS){
+        acl_done_us[acl_used++] = radio_busy_until_us;
+    }
+    return radio_busy_until_us;
+}
+
+uint16_t hci_number_free_acl_slots_for_handle(hci_con_handle_t con_handle){
+    (void) con_handle;
+    radio_release(sim_time_us());
+    return acl_used < config.acl_buffers ? (uint16_t) (config.acl_buffers - acl_used) : 0;
+}
+
+static void deliver_can_send_now(void * arg){
+    (void) arg;
+    uint64_t wait_us = sim_time_us() - can_send_requested_us;
+    stats.grants++;
+    stats.grant_wait_sum_us += wait_us;
+    if (wait_us > stats.grant_wait_max_us){
+        stats.grant_wait_max_us = wait_us;
+    }
+    uint8_t fields[] = {stream_local_seid};
+    sim_avdtp_event_t * event = calloc(1, sizeof(sim_avdtp_event_t));
+    btstack_assert(event != NULL);
+    event->data[0] = HCI_EVENT_AVDTP_META;
+    event->data[1] = AVDTP_SIM_EVENT_FIELDS - 2 + sizeof(fields);
+    event->data[2] = AVDTP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW;
+    event->data[AVDTP_SIM_EVENT_CID] = SIM_AVDTP_CID & 0xff;
+    event->data[AVDTP_SIM_EVENT_CID + 1] = SIM_AVDTP_CID >> 8;
+    memcpy(&event->data[AVDTP_SIM_EVENT_FIELDS], fields, sizeof(fields));
+    event->size = AVDTP_SIM_EVENT_FIELDS + sizeof(fields);
+    deliver_event(event);
+}
+
+uint8_t a2dp_source_stream_endpoint_request_can_send_now(uint16_t avdtp_cid, uint8_t local_seid){
+    (void) avdtp_cid;
+    if (!stream_started || local_seid != stream_local_seid) return ERROR_CODE_COMMAND_DISALLOWED;
+    can_send_requested_us = sim_time_us();
+    uint64_t grant_us = sim_time_us() + config.can_send_latency_us;
+    if (config.can_send_jitter_us){
+        grant_us += (uint64_t) rand() % config.can_send_jitter_us;
+    }
+    // all ACL buffers taken, wait for the oldest that is still taken at the grant to come back
+    radio_release(sim_time_us());
+    if (acl_used >= config.acl_buffers){
+        uint64_t sorted[SIM_MAX_ACL_BUFFERS];
+        memcpy(sorted, acl_done_us, acl_used * sizeof(uint64_t));
+        for (uint8_t i = 1; i < acl_used; i++){
+            for (uint8_t j = i; j > 0 && sorted[j - 1] > sorted[j]; j--){
+                uint64_t swap = sorted[j];
+                sorted[j] = sorted[j - 1];
+                sorted[j - 1] = swap;
+            }
+        }
+        uint64_t free_us = sorted[acl_used - config.acl_buffers];
+        if (free_us > grant_us){
+            grant_us = free_us;
+        }
+    }
+    sim_call_at(grant_us, &deliver_can_send_now, NULL, false);
+    return ERROR_CODE_SUCCESS;
+}
+
+int a2dp_max_media_payload_size(uint16_t avdtp_cid, uint8_t local_seid){
+    (void) avdtp_cid;
+    (void) local_seid;
+    return config.media_mtu - AVDTP_MEDIA_PAYLOAD_HEADER_SIZE;
+}
+
+// sink
+
+static void sink_advance(uint64_t now_us){
+    if (sink_playing){
+        double played = (double) (now_us - sink_last_us) * stream_sample_rate / 1e6;
+        if (played > sink_level){
+            // ran dry, silence until enough is buffered again
+            double empty_after_us = sink_level * 1e6 / stream_sample_rate;
+            stats.sink_underruns++;
+            stats.sink_silent_ms += ((double) (now_us - sink_last_us) - empty_after_us) / 1000.0;
+            sink_level = 0;
+            sink_playing = false;
+        } else {
+            sink_level -= played;
+        }
+    } else if (sink_started){
+        stats.sink_silent_ms += (double) (now_us - sink_last_us) / 1000.0;
+    }
+    sink_last_us = now_us;
+}
+
+// stream suspended or closed: the sink stops playing, silence meanwhile is not an underrun
+static void sink_stop(void){
+    sink_advance(sim_time_us());
+    sink_level = 0;
+    sink_playing = false;
+    sink_started = false;
+}
+
+static void sink_receive(void * arg){
+    uint32_t samples = (uint32_t) (uintptr_t) arg;
+    sink_advance(sim_time_us());
+    sink_level += samples;
+    if (!sink_playing && sink_level * 1000.0 >= (double) config.prebuffer_ms * stream_sample_rate){
+        sink_playing = true;
+        sink_started = true;
+        if (stats.resume_us != 0 && stats.resume_playing_us == 0){
+            stats.resume_playing_us = sim_time_us();
+        }
+    }
+}
+
+static uint32_t payload_samples(const uint8_t * payload, uint16_t payload_size){
+    if (payload_size == 0) return 0;
+    // both carry the frame count in the low bits of the first byte
+    return (payload[0] & 0x0fu) * stream_frame_samples;
+}
+
+static void record_rtp(uint8_t marker, uint32_t timestamp, const uint8_t * payload, uint16_t payload_size){
+    if (config.rtp_dump == NULL) return;
+    uint8_t header[4 + 12];
+    uint32_t length = 12u + payload_size;
+    header[0] = length & 0xff;
+    header[1] = (length >> 8) & 0xff;
+    header[2] = (length >> 16) & 0xff;
+    header[3] = length >> 24;
+    header[4] = 0x80;
+    header[5] = (uint8_t) ((marker ? 0x80 : 0x00) | 96);
+    header[6] = rtp_sequence >> 8;
+    header[7] = rtp_sequence & 0xff;
+    header[8] = timestamp >> 24;
+    header[9] = (timestamp >> 16) & 0xff;
+    header[10] = (timestamp >> 8) & 0xff;
+    header[11] = timestamp & 0xff;
+    memset(&header[12], 0, 3);
+    header[15] = 1;     // ssrc
+    fwrite(header, 1, sizeof(header), config.rtp_dump);
+    fwrite(payload, 1, payload_size, config.rtp_dump);
+}
+
+static void send_media(uint8_t marker, uint32_t timestamp, const uint8_t * payload, uint16_t payload_size){
+    uint64_t now_us = sim_time_us();
+    uint32_t samples = payload_samples(payload, payload_size);
+
+    record_rtp(marker, timestamp, payload, payload_size);
+    rtp_sequence++;
+
+    if (stats.resume_us != 0 && stats.resume_first_send_us == 0){
+        stats.resume_first_send_us = now_us;
+    }
+    if (stats.packets == 0){
+        stats.first_send_us = now_us;
+    } else if (!stream_restarted){
+        double interval_ms = (double) (now_us - stats.last_send_us) / 1000.0;
+        stats.interval_sum_ms += interval_ms;
+        stats.interval_sum_sq_ms += interval_ms * interval_ms;
+        if (interval_ms > stats.interval_max_ms){
+            stats.interval_max_ms = interval_ms;
+        }
+        if (timestamp != stats.expected_timestamp){
+            stats.timestamp_gaps++;
+        }
+    }
+
+    uint64_t arrival_us = radio_transmit(payload_size);
+    if (stats.packets > 0 && !stream_restarted){
+        double transit_ms = (double) (arrival_us - stats.last_arrival_us) / 1000.0 -
+                            (double) (uint32_t) (timestamp - stats.last_timestamp) * 1000.0 / stream_sample_rate;
+        stats.jitter_ms += (fabs(transit_ms) - stats.jitter_ms) / 16.0;
+    }
+    stream_restarted = false;
+    stats.last_arrival_us = arrival_us;
+    stats.last_timestamp = timestamp;
+    stats.expected_timestamp = timestamp + samples;
+    stats.last_send_us = now_us;
+    stats.packets++;
+    stats.payload_bytes += payload_size;
+
+    sim_call_at(arrival_us, &sink_receive, (void *) (uintptr_t) samples, false);
+}
+
+uint8_t a2dp_source_stream_send_media_payload_rtp(uint16_t a2dp_cid, uint8_t local_seid, uint8_t marker, uint32_t timestamp,
+                                                  uint8_t *payload, uint16_t payload_size){
+    (void) a2dp_cid;
+    if (!stream_started || local_seid != stream_local_seid) return ERROR_CODE_COMMAND_DISALLOWED;
+    send_media(marker, timestamp, payload, payload_size);
+    return ERROR_CODE_SUCCESS;
+}
+
+int a2dp_source_stream_send_media_packet(uint16_t a2dp_cid, uint8_t local_seid, const uint8_t *packet, uint16_t size){
+    (void) a2dp_cid;
+    if (!stream_started || local_seid != stream_local_seid) return ERROR_CODE_COMMAND_DISALLOWED;
+    send_media(0, 0, packet, size);
+    return ERROR_CODE_SUCCESS;
+}
+
+// stand-in SBC encoder: the real one comes with the pico-sdk, frames here only have the right size
+
+static uint16_t sbc_frame_length(void){
+    int channels = sbc.channel_mode == SBC_CHANNEL_MODE_MONO ? 1 : 2;
+    int length = 4 + (4 * sbc.subbands * channels) / 8;
+    switch (sbc.channel_mode){
+        case SBC_CHANNEL_MODE_MONO:
+        case SBC_CHANNEL_MODE_DUAL_CHANNEL:
+            length += (sbc.blocks * channels * sbc.bitpool + 7) / 8;
+            break;
+        case SBC_CHANNEL_MODE_STEREO:
+            length += (sbc.blocks * sbc.bitpool + 7) / 8;
+            break;
+        default:
+            length += (sbc.subbands + sbc.blocks * sbc.bitpool + 7) / 8;
+            break;
+    }
+    return (uint16_t) length;
+}
+
+void btstack_sbc_encoder_init(btstack_sbc_encoder_state_t *state, btstack_sbc_mode_t mode, int blocks, int subbands,
+                              btstack_sbc_allocation_method_t allocation_method, int sample_rate, int bitpool,
+                              btstack_sbc_channel_mode_t channel_mode){
+    (void) state;
+    (void) mode;
+    sbc.blocks = blocks;
+    sbc.subbands = subbands;
+    sbc.bitpool = bitpool;
+    sbc.channel_mode = channel_mode;
+    sbc.sample_rate = sample_rate;
+    sbc.allocation_method = allocation_method;
+    sbc.frame_length = sbc_frame_length();
+    btstack_assert(sbc.frame_length <= sizeof(sbc.frame));
+
+    uint8_t sampling_frequency = sample_rate == 16000 ? 0 : sample_rate == 32000 ? 1 : sample_rate == 44100 ? 2 : 3;
+    memset(sbc.frame, 0, sizeof(sbc.frame));
+    sbc.frame[0] = 0x9c;
+    sbc.frame[1] = (uint8_t) ((sampling_frequency << 6) | (((blocks / 4) - 1) << 4) | (channel_mode << 2) |
+                              (allocation_method << 1) | (subbands == 8 ? 1 : 0));
+    sbc.frame[2] = (uint8_t) bitpool;
+}
+
+void btstack_sbc_encoder_process_data(int16_t *input_buffer){
+    (void) input_buffer;
+}
+
+uint8_t *btstack_sbc_encoder_sbc_buffer(void){
+    return sbc.frame;
+}
+
+uint16_t btstack_sbc_encoder_sbc_buffer_length(void){
+    return sbc.frame_length;
+}
+
+int btstack_sbc_encoder_num_audio_frames(void){
+    return sbc.blocks * sbc.subbands;
+}
+
+// rest of the stack
+
+int hci_power_control(HCI_POWER_MODE mode){
+    (void) mode;
+    return 0;
+}
+
+void l2cap_init(void){
+}
+
+void sdp_init(void){
+}
+
+uint8_t sdp_register_service(const uint8_t *record){
+    (void) record;
+    return ERROR_CODE_SUCCESS;
+}
+
+void gap_local_bd_addr(bd_addr_t address_buffer){
+    static const bd_addr_t local_addr = {0x28, 0xcd, 0xc1, 0x00, 0x00, 0x01};
+    memcpy(address_buffer, local_addr, sizeof(bd_addr_t));
+}
+
+void gap_delete_all_link_keys(void){
+}
+
+char *bd_addr_to_str(const bd_addr_t addr){
+    static char buffer[18];
+    snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X", addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
+    return buffer;
+}
+
+// setup and report
+
+void sim_sink_init(const sim_sink_config_t * sink_config){
+    config = *sink_config;
+    if (config.acl_buffers == 0) config.acl_buffers = 1;
+    if (config.acl_buffers > SIM_MAX_ACL_BUFFERS) config.acl_buffers = SIM_MAX_ACL_BUFFERS;
+    if (config.link_kbps == 0) config.link_kbps = 1;
+}
+
+void sim_sink_host_resumed(void){
+    stats.resume_us = sim_time_us();
+    stats.resume_first_send_us = 0;
+    stats.resume_playing_us = 0;
+}
+
+bool sim_sink_streaming(void){
+    return stream_started && stats.packets > 0;
+}
+
+void sim_sink_report(void){
+    uint64_t now_us = sim_time_us();
+    sink_advance(now_us);
+
+    printf("\n--- stream ---\n");
+    if (stats.packets == 0){
+        printf("no media packets sent\n");
+        return;
+    }
+    double duration_s = (double) (stats.last_send_us - stats.first_send_us) / 1e6;
+    uint32_t intervals = stats.packets - 1;
+    double interval_mean_ms = intervals ? stats.interval_sum_ms / intervals : 0;
+    double interval_var = intervals ? stats.interval_sum_sq_ms / intervals - interval_mean_ms * interval_mean_ms : 0;
+    printf("codec             %s, %u Hz\n", stream_ldac ? "LDAC" : "SBC", (unsigned) stream_sample_rate);
+    printf("packets           %u, %llu payload bytes, avg %.0f bytes\n", (unsigned) stats.packets,
+           (unsigned long long) stats.payload_bytes, (double) stats.payload_bytes / stats.packets);
+    printf("throughput        %.1f kbps over %.3f s\n",
+           duration_s > 0 ? (double) stats.payload_bytes * 8 / duration_s / 1000.0 : 0, duration_s);
+    printf("send interval     avg %.2f ms, stddev %.2f ms, max %.2f ms\n",
+           interval_mean_ms, interval_var > 0 ? sqrt(interval_var) : 0, stats.interval_max_ms);
+    printf("arrival jitter    %.2f ms (RFC 3550)\n", stats.jitter_ms);
+    printf("timestamp gaps    %u\n", (unsigned) stats.timestamp_gaps);
+    printf("can send now      %u grants, avg wait %.2f ms, max %.2f ms\n", (unsigned) stats.grants,
+           stats.grants ? (double) stats.grant_wait_sum_us / stats.grants / 1000.0 : 0,
+           (double) stats.grant_wait_max_us / 1000.0);
+    printf("sink underruns    %u, %.1f ms silent after a %u ms prebuffer\n", (unsigned) stats.sink_underruns,
+           stats.sink_silent_ms, (unsigned) config.prebuffer_ms);
+    printf("stream starts     %u, %u suspends\n", (unsigned) stats.starts, (unsigned) stats.suspends);
+    if (stats.resume_us != 0){
+        printf("host resume       first packet after %.1f ms, sink playing after %.1f ms\n",
+               stats.resume_first_send_us ? (double) (stats.resume_first_send_us - stats.resume_us) / 1000.0 : -1.0,
+               stats.resume_playing_us ? (double) (stats.resume_playing_us - stats.resume_us) / 1000.0 : -1.0);
+    }
+}
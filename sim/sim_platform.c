@@ -0,0 +1,459 @@
+//
+// Simulated clock, BTstack run loop, the two cores and the pico USB device library, see sim.h
+//
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "btstack.h"
+#include "pico/multicore.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include "btstack/btstack_hci.h"
+#include "pico_w_led.h"
+
+#include "sim.h"
+
+typedef enum {
+    SIM_EVENT_CALL = 0,
+    SIM_EVENT_TIMER,
+    SIM_EVENT_MAIN_THREAD,
+} sim_event_kind_t;
+
+typedef struct sim_event {
+    struct sim_event * next;
+    uint64_t at_us;
+    sim_event_kind_t kind;
+    bool interrupt;
+    void (*fn)(void *arg);
+    void * arg;
+    btstack_timer_source_t * timer;
+    btstack_context_callback_registration_t * registration;
+} sim_event_t;
+
+// pending events, sorted by time, equal times in the order they were scheduled
+static sim_event_t * sim_events;
+static uint64_t sim_now_us;
+
+// core 1 woke the run loop during its current job, the poll is scheduled once its run time is known
+static bool core1_poll_pending;
+static double encoder_cost_factor;
+static uint64_t core1_job_start_ns;
+static uint64_t core1_busy_us;
+
+static __thread uint sim_core_num;
+static sem_t core0_sem;
+static sem_t core1_sem;
+static void (*core1_entry)(void);
+
+sim_usb_device_t sim_usb_device;
+struct usb_buffer sim_usb_out_buffer;
+struct usb_buffer sim_usb_in_buffer;
+audio_ring_t * sim_audio_ring;
+
+uint64_t sim_time_us(void){
+    return sim_now_us;
+}
+
+void sim_set_encoder_cost(double factor){
+    encoder_cost_factor = factor;
+}
+
+uint64_t sim_core1_busy_us(void){
+    return core1_busy_us;
+}
+
+static void sim_insert(sim_event_t * event){
+    sim_event_t ** it = &sim_events;
+    while (*it != NULL && (*it)->at_us <= event->at_us){
+        it = &(*it)->next;
+    }
+    event->next = *it;
+    *it = event;
+}
+
+static sim_event_t * sim_new_event(uint64_t at_us, sim_event_kind_t kind){
+    sim_event_t * event = calloc(1, sizeof(sim_event_t));
+    if (event == NULL){
+        fprintf(stderr, "sim: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    event->at_us = at_us;
+    event->kind = kind;
+    return event;
+}
+
+void sim_call_at(uint64_t at_us, void (*fn)(void *arg), void *arg, bool interrupt){
+    sim_event_t * event = sim_new_event(at_us, SIM_EVENT_CALL);
+    event->fn = fn;
+    event->arg = arg;
+    event->interrupt = interrupt;
+    sim_insert(event);
+}
+
+static void sim_dispatch(sim_event_t * event){
+    if (event->at_us > sim_now_us){
+        sim_now_us = event->at_us;
+    }
+    switch (event->kind){
+        case SIM_EVENT_CALL:
+            event->fn(event->arg);
+            break;
+        case SIM_EVENT_TIMER:
+            event->timer->process(event->timer);
+            break;
+        case SIM_EVENT_MAIN_THREAD:
+            event->registration->callback(event->registration->context);
+            break;
+        default:
+            break;
+    }
+    free(event);
+}
+
+void sim_run_until(uint64_t until_us){
+    while (sim_events != NULL && sim_events->at_us <= until_us){
+        sim_event_t * event = sim_events;
+        sim_events = event->next;
+        sim_dispatch(event);
+    }
+    if (until_us > sim_now_us){
+        sim_now_us = until_us;
+    }
+}
+
+// core 0 blocked in sleep_ms, only interrupts get through
+void sleep_ms(uint32_t ms){
+    uint64_t until_us = sim_now_us + (uint64_t) ms * 1000u;
+    while (true){
+        sim_event_t ** it = &sim_events;
+        while (*it != NULL && (*it)->at_us <= until_us && !(*it)->interrupt){
+            it = &(*it)->next;
+        }
+        if (*it == NULL || (*it)->at_us > until_us) break;
+        sim_event_t * event = *it;
+        *it = event->next;
+        sim_dispatch(event);
+    }
+    sim_now_us = until_us;
+}
+
+// run loop
+
+void btstack_run_loop_set_timer(btstack_timer_source_t *ts, uint32_t timeout_in_ms){
+    ts->timeout = btstack_run_loop_get_time_ms() + timeout_in_ms;
+}
+
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *ts)){
+    ts->process = process;
+}
+
+void btstack_run_loop_set_timer_context(btstack_timer_source_t *ts, void *context){
+    ts->context = context;
+}
+
+void *btstack_run_loop_get_timer_context(btstack_timer_source_t *ts){
+    return ts->context;
+}
+
+int btstack_run_loop_remove_timer(btstack_timer_source_t *ts){
+    for (sim_event_t ** it = &sim_events; *it != NULL; it = &(*it)->next){
+        if ((*it)->kind == SIM_EVENT_TIMER && (*it)->timer == ts){
+            sim_event_t * event = *it;
+            *it = event->next;
+            free(event);
+            return true;
+        }
+    }
+    return false;
+}
+
+void btstack_run_loop_add_timer(btstack_timer_source_t *ts){
+    btstack_run_loop_remove_timer(ts);
+    sim_event_t * event = sim_new_event((uint64_t) ts->timeout * 1000u, SIM_EVENT_TIMER);
+    event->timer = ts;
+    sim_insert(event);
+}
+
+uint32_t btstack_run_loop_get_time_ms(void){
+    return (uint32_t) (sim_now_us / 1000u);
+}
+
+static void sim_post_main_thread(btstack_context_callback_registration_t *callback_registration, uint64_t at_us){
+    // like BTstack, a registration already queued is not queued twice
+    for (sim_event_t * it = sim_events; it != NULL; it = it->next){
+        if (it->kind == SIM_EVENT_MAIN_THREAD && it->registration == callback_registration) return;
+    }
+    sim_event_t * event = sim_new_event(at_us, SIM_EVENT_MAIN_THREAD);
+    event->registration = callback_registration;
+    sim_insert(event);
+}
+
+// takes the run loop lock on the Pico, which core 0 may hold while it waits for core 1
+void btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t *callback_registration){
+    if (sim_core_num != 0){
+        fprintf(stderr, "sim: core 1 must not take the run loop lock\n");
+        exit(EXIT_FAILURE);
+    }
+    sim_post_main_thread(callback_registration, sim_now_us);
+}
+
+// data sources
+
+static btstack_data_source_t * data_sources;
+static bool data_sources_poll_pending;
+
+void btstack_run_loop_set_data_source_handler(btstack_data_source_t *ds,
+                                              void (*process)(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type)){
+    ds->process = process;
+}
+
+void btstack_run_loop_enable_data_source_callbacks(btstack_data_source_t *ds, uint16_t callbacks){
+    ds->flags |= callbacks;
+}
+
+void btstack_run_loop_add_data_source(btstack_data_source_t *ds){
+    ds->next = data_sources;
+    data_sources = ds;
+}
+
+static void poll_data_sources(void * arg){
+    (void) arg;
+    data_sources_poll_pending = false;
+    for (btstack_data_source_t * ds = data_sources; ds != NULL; ds = ds->next){
+        if (ds->flags & DATA_SOURCE_CALLBACK_POLL){
+            ds->process(ds, DATA_SOURCE_CALLBACK_POLL);
+        }
+    }
+}
+
+// the run loop wakes up and polls right after the interrupt returns
+void btstack_run_loop_poll_data_sources_from_irq(void){
+    if (sim_core_num != 0){
+        core1_poll_pending = true;
+        return;
+    }
+    if (data_sources_poll_pending) return;
+    data_sources_poll_pending = true;
+    sim_call_at(sim_now_us, &poll_data_sources, NULL, false);
+}
+
+// cores: core 1 is a thread running in lockstep with core 0. It only ever runs between a __sev()
+// from core 0 and its own next __wfe(), so both never touch shared state at the same time.
+
+uint get_core_num(void){
+    return sim_core_num;
+}
+
+static void *core1_thread(void *arg){
+    (void) arg;
+    sim_core_num = 1;
+    core1_entry();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)){
+    pthread_t thread;
+    core1_entry = entry;
+    sem_init(&core0_sem, 0, 0);
+    sem_init(&core1_sem, 0, 0);
+    if (pthread_create(&thread, NULL, &core1_thread, NULL) != 0){
+        fprintf(stderr, "sim: cannot start core 1\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_detach(thread);
+    // until it waits for its first job
+    sem_wait(&core0_sem);
+}
+
+static uint64_t host_time_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+uint32_t time_us_32(void){
+    if (sim_core_num != 1) return (uint32_t) sim_now_us;
+    uint64_t run_us = (host_time_ns() - core1_job_start_ns) / 1000u;
+    return (uint32_t) (sim_now_us + (uint64_t) ((double) run_us * encoder_cost_factor));
+}
+
+void __sev(void){
+    if (sim_core_num != 0) return;
+
+    uint64_t start_ns = host_time_ns();
+    core1_job_start_ns = start_ns;
+    sem_post(&core1_sem);
+    sem_wait(&core0_sem);
+    uint64_t run_us = (host_time_ns() - start_ns) / 1000u;
+
+    // whatever core 1 handed back arrives once it would have finished
+    uint64_t busy_us = (uint64_t) ((double) run_us * encoder_cost_factor);
+    uint64_t done_us = sim_now_us + busy_us;
+    core1_busy_us += busy_us;
+    if (core1_poll_pending){
+        core1_poll_pending = false;
+        sim_call_at(done_us, &poll_data_sources, NULL, false);
+    }
+}
+
+void __wfe(void){
+    if (sim_core_num != 1) return;
+    sem_post(&core0_sem);
+    sem_wait(&core1_sem);
+}
+
+static spin_lock_t sim_spin_locks[32];
+
+spin_lock_t *spin_lock_instance(uint lock_num){
+    return &sim_spin_locks[lock_num];
+}
+
+int spin_lock_claim_unused(bool required){
+    static int next_lock = 16;
+    if (next_lock >= 32){
+        if (required){
+            fprintf(stderr, "sim: no spin lock left\n");
+            exit(EXIT_FAILURE);
+        }
+        return -1;
+    }
+    return next_lock++;
+}
+
+uint32_t spin_lock_blocking(spin_lock_t *lock){
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)){
+    }
+    return 0;
+}
+
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq){
+    (void) saved_irq;
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+// USB device library, the host in pipeline_sim.c drives the endpoints
+
+struct usb_interface *usb_interface_init(struct usb_interface *interface, const struct usb_interface_descriptor *descriptor,
+                                         struct usb_endpoint *const *endpoints, uint endpoint_count,
+                                         bool double_buffered){
+    (void) double_buffered;
+    memset(interface, 0, sizeof(struct usb_interface));
+    interface->descriptor = descriptor;
+    interface->endpoints = endpoints;
+    interface->endpoint_count = (uint8_t) endpoint_count;
+    return interface;
+}
+
+struct usb_device *usb_device_init(const struct usb_device_descriptor *descriptor,
+                                   const struct usb_configuration_descriptor *config_desc,
+                                   struct usb_interface *const *interfaces, uint interface_count,
+                                   const char *(*get_descriptor_string)(uint index)){
+    static struct usb_device device;
+    (void) get_descriptor_string;
+    device.device_descriptor = descriptor;
+    device.config_descriptor = config_desc;
+    sim_usb_device.interface_count = interface_count < count_of(sim_usb_device.interfaces) ?
+                                     interface_count : count_of(sim_usb_device.interfaces);
+    for (uint i = 0; i < sim_usb_device.interface_count; i++){
+        sim_usb_device.interfaces[i] = interfaces[i];
+    }
+    return &device;
+}
+
+void usb_device_start(void){
+}
+
+void usb_set_default_transfer(struct usb_endpoint *ep, struct usb_transfer *transfer){
+    ep->default_transfer = transfer;
+    ep->current_transfer = transfer;
+}
+
+struct usb_buffer *usb_current_out_packet_buffer(struct usb_endpoint *ep){
+    (void) ep;
+    return &sim_usb_out_buffer;
+}
+
+struct usb_buffer *usb_current_in_packet_buffer(struct usb_endpoint *ep){
+    (void) ep;
+    return &sim_usb_in_buffer;
+}
+
+void usb_grow_transfer(struct usb_transfer *transfer, uint packet_count){
+    transfer->remaining_packets_to_submit += packet_count;
+}
+
+void usb_packet_done(struct usb_endpoint *ep){
+    (void) ep;
+}
+
+// data stage of a control OUT request, delivered by sim_usb_control_out()
+static const struct usb_transfer_type * control_out_type;
+
+void usb_start_control_out_transfer(const struct usb_transfer_type *type){
+    control_out_type = type;
+}
+
+bool sim_usb_control_out(struct usb_endpoint *ep, struct usb_setup_packet *setup, uint8_t *data, uint16_t len){
+    control_out_type = NULL;
+    if (ep->setup_request_handler == NULL || !ep->setup_request_handler(ep, setup)) return false;
+    if (control_out_type == NULL) return false;
+    sim_usb_out_buffer.data = data;
+    sim_usb_out_buffer.data_max = len;
+    sim_usb_out_buffer.data_len = len;
+    control_out_type->on_packet(ep);
+    return true;
+}
+
+void usb_start_empty_control_in_transfer_null_completion(void){
+}
+
+void usb_start_tiny_control_in_transfer(uint32_t data, uint8_t len){
+    (void) data;
+    (void) len;
+}
+
+// the PCM ring is static in usb_sound.c, the link wraps its init to find it
+void __real_audio_ring_init(audio_ring_t * ring, int16_t * buffer, uint32_t size_frames,
+                            audio_ring_overrun_policy_t overrun_policy, audio_ring_underrun_policy_t underrun_policy);
+
+void __wrap_audio_ring_init(audio_ring_t * ring, int16_t * buffer, uint32_t size_frames,
+                            audio_ring_overrun_policy_t overrun_policy, audio_ring_underrun_policy_t underrun_policy){
+    sim_audio_ring = ring;
+    __real_audio_ring_init(ring, buffer, size_frames, overrun_policy, underrun_policy);
+}
+
+// board: LED, HCI setup and pairing are not simulated, the sink is already known
+
+static bd_addr_t sim_remote_addr = {0x00, 0x1b, 0xdc, 0x00, 0x00, 0x01};
+
+void set_led_mode_pairing(){
+}
+
+void set_led_mode_playing_sbc(){
+}
+
+void set_led_mode_playing_ldac(){
+}
+
+void set_led_mode_off(){
+}
+
+void bt_hci_init(void){
+}
+
+const char * get_device_addr_string(){
+    return bd_addr_to_str(sim_remote_addr);
+}
+
+bd_addr_t * get_device_addr(){
+    return &sim_remote_addr;
+}
+
+void gap_start_scanning(void){
+}
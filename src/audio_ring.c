@@ -0,0 +1,165 @@
+//
+// Single-producer / single-consumer PCM ring, see audio_ring.h
+//
+
+#include <string.h>
+#include <assert.h>
+
+#include "audio_ring.h"
+
+
+void audio_ring_init(audio_ring_t * ring, int16_t * buffer, uint32_t size_frames,
+                     audio_ring_overrun_policy_t overrun_policy, audio_ring_underrun_policy_t underrun_policy){
+    assert(size_frames && !(size_frames & (size_frames - 1)));
+
+    ring->buffer = buffer;
+    ring->size = size_frames;
+    ring->mask = size_frames - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->resync_pending = false;
+    ring->sound_end = 0;
+    ring->overrun_policy = overrun_policy;
+    ring->underrun_policy = underrun_policy;
+    ring->overrun_frames = 0;
+    ring->underrun_frames = 0;
+}
+
+uint32_t audio_ring_reserve(audio_ring_t * ring, uint32_t num_frames){
+    uint32_t space = audio_ring_space(ring);
+    if (num_frames > space){
+        ring->overrun_frames += num_frames - space;
+        if (ring->overrun_policy == AUDIO_RING_OVERRUN_RESYNC){
+            ring->resync_pending = true;
+        }
+        num_frames = space;
+    }
+    return num_frames;
+}
+
+int16_t * audio_ring_write_span(const audio_ring_t * ring, uint32_t offset, uint32_t * num_frames){
+    uint32_t index = (ring->head + offset) & ring->mask;
+    uint32_t contiguous = ring->size - index;
+    if (*num_frames > contiguous){
+        *num_frames = contiguous;
+    }
+    return &ring->buffer[index * AUDIO_RING_CHANNELS];
+}
+
+static bool audio_ring_frame_silent(const audio_ring_t * ring, uint32_t frame){
+    const int16_t * samples = &ring->buffer[(frame & ring->mask) * AUDIO_RING_CHANNELS];
+    for (int ch = 0; ch < AUDIO_RING_CHANNELS; ch++){
+        if (samples[ch]) return false;
+    }
+    return true;
+}
+
+void audio_ring_commit(audio_ring_t * ring, uint32_t num_frames){
+    // newest first, with sound playing the very last frame usually ends the scan
+    uint32_t head = ring->head + num_frames;
+    uint32_t frame = head;
+    while (frame != ring->head && audio_ring_frame_silent(ring, frame - 1)){
+        frame--;
+    }
+    if (frame != ring->head){
+        ring->sound_end = frame;
+    } else if (head - ring->sound_end > ring->size){
+        // keep it within reach of tail, so the comparison does not wrap over long silence
+        ring->sound_end = head - ring->size;
+    }
+
+    // publish samples before the new head becomes visible to the other core
+    __mem_fence_release();
+    ring->head = head;
+}
+
+uint32_t audio_ring_write(audio_ring_t * ring, const int16_t * frames, uint32_t num_frames){
+    num_frames = audio_ring_reserve(ring, num_frames);
+
+    uint32_t written = 0;
+    while (written < num_frames){
+        uint32_t span = num_frames - written;
+        int16_t * dst = audio_ring_write_span(ring, written, &span);
+        memcpy(dst, &frames[written * AUDIO_RING_CHANNELS], span * AUDIO_RING_CHANNELS * sizeof(int16_t));
+        written += span;
+    }
+
+    audio_ring_commit(ring, num_frames);
+    return num_frames;
+}
+
+static void CODEC_HOT_FUNC(audio_ring_apply_resync)(audio_ring_t * ring){
+    if (ring->resync_pending){
+        ring->resync_pending = false;
+        uint32_t level = audio_ring_level(ring);
+        if (level > ring->size / 2){
+            ring->tail += level - ring->size / 2;
+        }
+    }
+}
+
+const int16_t * CODEC_HOT_FUNC(audio_ring_peek)(audio_ring_t * ring, int16_t * scratch, uint32_t num_frames,
+                                                uint32_t * num_read){
+    audio_ring_apply_resync(ring);
+
+    uint32_t level = audio_ring_level(ring);
+    uint32_t offset = ring->tail & ring->mask;
+
+    if (level >= num_frames && offset + num_frames <= ring->size){
+        // contiguous, hand out the ring storage directly
+        *num_read = num_frames;
+        return &ring->buffer[offset * AUDIO_RING_CHANNELS];
+    }
+
+    if (level < num_frames && ring->underrun_policy == AUDIO_RING_UNDERRUN_WAIT){
+        *num_read = 0;
+        return NULL;
+    }
+
+    // wraps or runs short, assemble in scratch and pad with silence
+    uint32_t available = level < num_frames ? level : num_frames;
+    ring->underrun_frames += num_frames - available;
+    *num_read = available;
+    uint32_t first = ring->size - offset;
+    if (first > available){
+        first = available;
+    }
+    memcpy(scratch, &ring->buffer[offset * AUDIO_RING_CHANNELS], first * AUDIO_RING_CHANNELS * sizeof(int16_t));
+    memcpy(&scratch[first * AUDIO_RING_CHANNELS], &ring->buffer[0], (available - first) * AUDIO_RING_CHANNELS * sizeof(int16_t));
+    memset(&scratch[available * AUDIO_RING_CHANNELS], 0, (num_frames - available) * AUDIO_RING_CHANNELS * sizeof(int16_t));
+    return scratch;
+}
+
+uint32_t CODEC_HOT_FUNC(audio_ring_read_spans)(audio_ring_t * ring, const int16_t ** span0, uint32_t * frames0,
+                               const int16_t ** span1, uint32_t * frames1){
+    audio_ring_apply_resync(ring);
+
+    uint32_t level = audio_ring_level(ring);
+    uint32_t offset = ring->tail & ring->mask;
+    uint32_t first = ring->size - offset;
+    if (first > level){
+        first = level;
+    }
+
+    *span0 = &ring->buffer[offset * AUDIO_RING_CHANNELS];
+    *frames0 = first;
+    *span1 = &ring->buffer[0];
+    *frames1 = level - first;
+    return level;
+}
+
+void CODEC_HOT_FUNC(audio_ring_consume)(audio_ring_t * ring, uint32_t num_frames){
+    // only ever frames the caller has read, those are still stored
+    uint32_t level = audio_ring_level(ring);
+    if (num_frames > level){
+        num_frames = level;
+    }
+    // finish reading the slots before handing them back to the producer
+    __mem_fence_release();
+    ring->tail += num_frames;
+}
+
+void audio_ring_flush(audio_ring_t * ring){
+    ring->resync_pending = false;
+    ring->tail = ring->head;
+}
@@ -0,0 +1,109 @@
+//
+// Single-producer / single-consumer PCM ring shared by USB ingest and the BT encoders.
+//
+// The producer (USB isochronous OUT handler) only ever writes `head`, the consumer
+// (the codec encoder) only ever writes `tail`. Both are free-running frame counters,
+// so occupancy is simply `head - tail` and wraps correctly at 2^32.
+//
+
+#ifndef PICOW_USB_BT_AUDIO_AUDIO_RING_H
+#define PICOW_USB_BT_AUDIO_AUDIO_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hardware/sync.h"
+
+// USB stream is always interleaved 16 bit stereo
+#define AUDIO_RING_CHANNELS 2
+
+// Per packet encoder code, the ring consumer included. CODEC_HOT_PATHS_IN_RAM (see CMakeLists.txt)
+// runs it from RAM so a flash cache miss cannot stall an encode.
+#ifdef CODEC_HOT_PATHS_IN_RAM
+#define CODEC_HOT_FUNC(func_name) __not_in_flash_func(func_name)
+#else
+#define CODEC_HOT_FUNC(func_name) func_name
+#endif
+
+// ring capacity in frames, must be a power of two
+#define AUDIO_RING_FRAMES 2048
+
+typedef enum {
+    // producer discards incoming frames that do not fit
+    AUDIO_RING_OVERRUN_DROP_NEWEST = 0,
+    // producer discards incoming frames and asks the consumer to skip ahead
+    // to half full on its next read, restoring the nominal latency
+    AUDIO_RING_OVERRUN_RESYNC,
+} audio_ring_overrun_policy_t;
+
+typedef enum {
+    // consumer is handed the available frames padded with silence
+    AUDIO_RING_UNDERRUN_SILENCE = 0,
+    // consumer is handed nothing and should retry later
+    AUDIO_RING_UNDERRUN_WAIT,
+} audio_ring_underrun_policy_t;
+
+typedef struct {
+    int16_t * buffer;
+    uint32_t  size;     // frames
+    uint32_t  mask;
+
+    volatile uint32_t head;     // written by producer only
+    volatile uint32_t tail;     // written by consumer only
+    volatile bool     resync_pending;
+
+    // written by producer only: one past the newest frame holding a non zero sample, never more
+    // than the ring size behind head, so everything from tail on is silent once it reaches tail
+    volatile uint32_t sound_end;
+
+    audio_ring_overrun_policy_t  overrun_policy;
+    audio_ring_underrun_policy_t underrun_policy;
+
+    // statistics, in frames
+    volatile uint32_t overrun_frames;
+    volatile uint32_t underrun_frames;
+} audio_ring_t;
+
+void audio_ring_init(audio_ring_t * ring, int16_t * buffer, uint32_t size_frames,
+                     audio_ring_overrun_policy_t overrun_policy, audio_ring_underrun_policy_t underrun_policy);
+
+// producer side
+uint32_t audio_ring_write(audio_ring_t * ring, const int16_t * frames, uint32_t num_frames);
+
+// producer side, zero copy: reserve, fill the spans in place, then commit
+uint32_t audio_ring_reserve(audio_ring_t * ring, uint32_t num_frames);
+int16_t * audio_ring_write_span(const audio_ring_t * ring, uint32_t offset, uint32_t * num_frames);
+void audio_ring_commit(audio_ring_t * ring, uint32_t num_frames);
+
+// consumer side, peek hands out num_frames contiguous frames. On underrun the stored frames are padded
+// with silence, num_read tells how many came from the ring: consume exactly those, frames committed
+// after the peek have not been read.
+const int16_t * audio_ring_peek(audio_ring_t * ring, int16_t * scratch, uint32_t num_frames, uint32_t * num_read);
+// consumer side, zero copy: all stored frames as at most two spans
+uint32_t audio_ring_read_spans(audio_ring_t * ring, const int16_t ** span0, uint32_t * frames0,
+                               const int16_t ** span1, uint32_t * frames1);
+// hands back frames read through peek or the spans
+void audio_ring_consume(audio_ring_t * ring, uint32_t num_frames);
+void audio_ring_flush(audio_ring_t * ring);
+
+// frames currently stored, safe to call from either side
+static inline uint32_t audio_ring_level(const audio_ring_t * ring){
+    uint32_t level = ring->head - ring->tail;
+    __mem_fence_acquire();
+    return level;
+}
+
+// consumer side: every stored frame is digital silence, and so is the padding of an underrun. A frame
+// committed right after may still hold sound.
+static inline bool audio_ring_silent(const audio_ring_t * ring){
+    // sound_end is stored before head, reading head first makes it as recent as the frames seen
+    (void) audio_ring_level(ring);
+    return (int32_t) (ring->sound_end - ring->tail) <= 0;
+}
+
+// frames that can be written without overrun
+static inline uint32_t audio_ring_space(const audio_ring_t * ring){
+    return ring->size - audio_ring_level(ring);
+}
+
+#endif //PICOW_USB_BT_AUDIO_AUDIO_RING_H
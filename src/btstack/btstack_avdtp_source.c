@@ -48,10 +48,14 @@
 #include "btstack.h"
 #include "btstack_avdtp_source.h"
 #include "pico/multicore.h"
+#include "pico/flash.h"
+#include "hardware/sync.h"
+#include "hardware/clocks.h"
 
 #include "btstack_hci.h"
 
 #include "../pico_w_led.h"
+#include "../stage_prof.h"
 
 
 #ifdef HAVE_AAC_FDK
@@ -60,10 +64,15 @@
 #endif
 
 #define HAVE_LDAC_ENCODER
+// LDAC_DUAL_CORE_CHANNELS (CMake option): the second LDAC channel is processed on core 0 while
+// core 1 does the first
 #include <ldacBT.h>
+#include <ldacBT_abr.h>
 
 #define A2DP_CODEC_VENDOR_ID_SONY 0x12d
 #define A2DP_SONY_CODEC_LDAC 0xaa
+#define A2DP_LDAC_SAMPLING_FREQ_44100 0x20
+#define A2DP_LDAC_SAMPLING_FREQ_48000 0x10
 
 #ifdef HAVE_APTX
 #include <openaptx.h>
@@ -88,6 +97,12 @@
 #define VOLUME_REDUCTION 2
 
 #define AUDIO_TIMEOUT_MS            3
+
+// Grace period between the host closing its USB stream and AVDTP SUSPEND. A pause shorter than
+// this, e.g. between tracks, only stops the encoder and resumes without any signaling.
+#ifndef USB_IDLE_SUSPEND_MS
+#define USB_IDLE_SUSPEND_MS         3000
+#endif
 #define TABLE_SIZE_441HZ            100
 
 static const int16_t sine_int16[] = {
@@ -165,14 +180,29 @@ typedef struct {
 
 #endif
 
+// encoded packets the encoder may run ahead of the radio, must be a power of two
+#define MEDIA_QUEUE_LEN             4
+#define MEDIA_PACKET_STORAGE_SIZE   1030
+
+// 4 bit frame count in the sbc media header
+#define SBC_MAX_FRAMES_PER_PACKET   15
+
+typedef struct {
+    uint8_t  data[MEDIA_PACKET_STORAGE_SIZE];
+    uint16_t len;
+    uint16_t num_frames;
+} a2dp_media_packet_t;
+
 typedef struct {
     uint16_t avdtp_cid;
     uint8_t  local_seid;
     uint8_t  remote_seid;
+    hci_con_handle_t con_handle;
 
     uint32_t time_audio_data_sent; // ms
     uint32_t acc_num_missed_samples;
     uint32_t samples_ready;
+    uint32_t samples_pending;   // paced on core 0, handed to the encoder when it is idle
     btstack_timer_source_t audio_timer;
     uint8_t  streaming;
     int      max_media_payload_size;
@@ -180,10 +210,27 @@ typedef struct {
     uint32_t rtp_timestamp;
 
 
-    uint8_t  codec_storage[1030];
+    // finished packets, head is advanced by the encoder (core 1), tail by the sender (core 0)
+    a2dp_media_packet_t media_queue[MEDIA_QUEUE_LEN];
+    volatile uint32_t media_queue_head;
+    volatile uint32_t media_queue_tail;
+
+    // packet currently being encoded, NULL if the queue was full
+    uint8_t  * codec_storage;
     uint16_t codec_storage_count;
-    uint8_t  codec_ready_to_send;
+    uint8_t  codec_ready_to_send;   // can send now requested
     uint16_t codec_num_frames;
+
+    volatile bool encoder_busy;
+    volatile bool encoder_packet_ready;
+    // set by core 0, core 1 leaves its frame loop at the next frame boundary and the done handler
+    // carries out the actions
+    volatile bool encoder_stop;
+    uint8_t  encoder_stop_actions;
+
+    // tx queue depth sampling for the LDAC adaptive bitrate
+    uint32_t abr_elapsed_ms;
+    uint16_t acl_slots_idle;
 } a2dp_media_sending_context_t;
 
 
@@ -194,8 +241,124 @@ static AACENC_InfoStruct aacinf;
 
 #ifdef HAVE_LDAC_ENCODER
 HANDLE_LDAC_BT handleLDAC;
+// the handle and the encoder behind it live here, selecting LDAC again reuses the same memory
+static uint64_t ldac_arena[LDACBT_STATIC_SIZE_MAX / sizeof(uint64_t)];
+static HANDLE_LDAC_ABR handleLDAC_ABR;
+static bool ldac_abr_enabled;
+// encoder is set up once the media channel, and with it the MTU, exists
+static bool ldac_encoder_configured;
+// how often the tx queue depth is fed to ABR, must be within 1..500 ms
+#define LDAC_ABR_INTERVAL_MS 20
+
+// Quality governor: ABR picks the step the link sustains, the governor lowers it further while
+// the encoder needs too long per frame. These are the steps ldacBT_alter_eqmid_priority walks,
+// highest quality first, Q0 and Q1 sit between SQ and MQ (ldacBT_ex.h).
+#define LDAC_GOVERNOR_NUM_STEPS         5
+// share of the frame duration the encoder may take, core 0 needs the rest for USB and sending
+#define LDAC_GOVERNOR_BUDGET_PERCENT    75
+// frames timed at a step before its cost is judged
+#define LDAC_GOVERNOR_MIN_FRAMES        32
+// a step found over budget is tried again after this long, twice as long every time it still is
+#define LDAC_GOVERNOR_RETRY_MS          10000
+#define LDAC_GOVERNOR_RETRY_MAX_MS      80000
+#define LDAC_GOVERNOR_HISTORY_LEN       32
+
+static const struct {
+    int          eqmid;
+    const char * name;
+} ldac_governor_steps[LDAC_GOVERNOR_NUM_STEPS] = {
+    { LDACBT_EQMID_HQ,     "HQ" },
+    { LDACBT_EQMID_SQ,     "SQ" },
+    { LDACBT_EQMID_Q0,     "Q0" },
+    { LDACBT_EQMID_Q1,     "Q1" },
+    { LDACBT_EQMID_MQ,     "MQ" },
+};
+
+typedef enum {
+    LDAC_GOVERNOR_LINK_DOWN = 0,
+    LDAC_GOVERNOR_LINK_UP,
+    LDAC_GOVERNOR_CPU_CAP,
+    LDAC_GOVERNOR_CPU_RETRY,
+} ldac_governor_reason_t;
+
+static const char * const ldac_governor_reason_names[] = { "link down", "link up", "cpu cap", "cpu retry" };
+
+typedef struct {
+    uint32_t time_ms;
+    uint8_t  reason;
+    uint8_t  step_from;
+    uint8_t  step_to;
+    uint8_t  link_step;
+    uint8_t  cpu_step;
+    uint8_t  tx_depth;
+    uint16_t frame_us;      // average encode time at step_from
+    uint16_t budget_us;
+} ldac_governor_decision_t;
+
+static struct {
+    // summed up by core 1 while encoding, taken by core 0 while it is idle
+    uint32_t busy_us;
+    uint32_t busy_frames;
+    uint8_t  step;                                  // what the encoder runs
+    uint8_t  link_step;                             // where ABR left the link
+    uint8_t  cpu_step;                              // highest quality the encoder keeps up with
+    uint16_t frame_us[LDAC_GOVERNOR_NUM_STEPS];     // moving average of the encode time per frame
+    uint16_t frames[LDAC_GOVERNOR_NUM_STEPS];       // frames behind it, saturates
+    uint16_t budget_us;
+    uint32_t retry_ms;
+    uint32_t retry_left_ms;
+    bool     retrying;                              // cpu_step was raised and is being timed
+    ldac_governor_decision_t history[LDAC_GOVERNOR_HISTORY_LEN];
+    uint32_t history_count;
+} ldac_governor;
 #endif
 
+// SBC packets are packed to fill one baseband packet: 2-DH5 carries 679 and 3-DH5 1021 bytes,
+// less the L2CAP (4) and RTP (12) headers
+#define SBC_2DH5_MEDIA_PAYLOAD_SIZE     663
+#define SBC_3DH5_MEDIA_PAYLOAD_SIZE     1005
+// SBC-XQ: dual channel gives each channel its own bitpool, 38 fills 2-DH5 with 4 frames and 47
+// fills 3-DH5 with 5, about 450 and 550 kbps at 44.1 kHz
+#define SBC_XQ_MIN_BITPOOL              38
+#define SBC_XQ_MAX_BITPOOL              47
+// bitpool steps, every step down packs one more frame into the same baseband packet. The top
+// step has to fill the packet, a higher bitpool that leaves a gap costs more air time than it gains.
+#define SBC_ABR_MAX_LEVELS              4
+#define SBC_MIN_PACKET_FILL_PERCENT     95
+// how often the tx queue depth is sampled, and the depths that step down and allow a step up,
+// the same as LDAC ABR uses
+#define SBC_ABR_INTERVAL_MS             20
+#define SBC_ABR_THRESHOLD_CRITICAL      6
+#define SBC_ABR_THRESHOLD_DANGEROUS     4
+#define SBC_ABR_THRESHOLD_SAFE          2
+// shallow queue needed before a step up, times the penalty, which doubles whenever a step up
+// is followed by a step down within that time and is forgotten after a minute without one
+#define SBC_ABR_STEADY_MS               3000
+#define SBC_ABR_PENALTY_MAX             4
+#define SBC_ABR_PENALTY_RESET_MS        60000
+// the SBC analysis filter looks back 10 blocks. Once that many silent blocks went in, a silent
+// frame always codes to the same bytes and leaves the encoder as it was, so it is sent from a copy.
+// Frames beyond the copy size, only seen with bitpools far above what sinks ask for, are encoded.
+#define SBC_ANALYSIS_WINDOW_BLOCKS      10
+#define SBC_SILENT_FRAME_MAX_SIZE       256
+
+static struct {
+    avdtp_media_codec_configuration_sbc_t configuration;  // as negotiated, max_bitpool_value is the ceiling
+    bool     configured;
+    uint16_t packet_payload_size;
+    uint8_t  bitpool[SBC_ABR_MAX_LEVELS];                 // highest quality first
+    uint8_t  num_levels;
+    uint8_t  level;
+    uint32_t elapsed_ms;
+    uint32_t safe_ms;
+    uint32_t since_step_up_ms;
+    uint32_t prev_depth;
+    uint8_t  penalty;
+    uint8_t  silent_frame[SBC_SILENT_FRAME_MAX_SIZE];
+    uint16_t silent_frame_length;                         // 0 until a silent frame was encoded
+    uint16_t silent_blocks;                               // silent blocks encoded in a row
+} sbc_stream;
+
 #ifdef HAVE_LC3PLUS
 LC3PLUS_Enc *    lc3plus_handle  = NULL;
 static uint8_t * lc3plus_scratch = NULL;
@@ -217,6 +380,36 @@ static uint16_t     cur_num_remote_seps;
 
 static uint8_t cur_capability = 0;
 static bool is_streaming = false;
+// START accepted and no SUSPEND since
+static bool stream_started = false;
+
+// USB streaming interface, the host selects alternate setting 1 while it plays and 0 once it
+// closes the stream, and sets the sample rate. The USB interrupt only records the changes, the
+// run loop polls for them.
+static struct {
+    btstack_data_source_t data_source;
+    bool registered;
+    volatile bool active;
+    volatile bool changed;
+    volatile uint32_t changed_us;
+    volatile uint32_t sample_rate;
+    volatile bool rate_changed;
+    bool rate_change_pending;   // stream closed or aborted to configure it at the new rate
+    bool rate_refused;          // no codec of the sink takes the host rate, nothing configured
+
+    btstack_timer_source_t suspend_timer;
+    bool idle;          // encoder timer paused while the host is away
+    bool suspended;     // and the stream suspended after the grace period
+    bool resuming;      // host is back, no packet sent yet
+    uint32_t resume_start_us;
+
+    // alternate setting 1 to the first media packet
+    uint32_t resumes;
+    uint32_t resume_last_us;
+    uint32_t resume_max_us;
+} usb_stream = {
+    .sample_rate = 44100,
+};
 
 
 
@@ -275,7 +468,7 @@ static uint8_t media_aac_codec_capabilities[] = {
 static uint8_t media_ldac_codec_capabilities[] = {
         0x2D, 0x1, 0x0, 0x0,
         0xAA, 0,
-        0x20,
+        A2DP_LDAC_SAMPLING_FREQ_44100 | A2DP_LDAC_SAMPLING_FREQ_48000,
         0x01,
         0x1
 };
@@ -317,6 +510,39 @@ static avdtp_media_codec_configuration_aptx_t aptxhd_configuration;
 static uint8_t local_stream_endpoint_lc3plus_media_codec_configuration[10];
 static avdtp_media_codec_configuration_lc3plus_t lc3plus_configuration;
 
+static uint32_t CODEC_HOT_FUNC(media_queue_level)(const a2dp_media_sending_context_t * context){
+    return context->media_queue_head - context->media_queue_tail;
+}
+
+static void media_queue_reset(a2dp_media_sending_context_t * context){
+    context->media_queue_head = 0;
+    context->media_queue_tail = 0;
+    context->codec_storage = NULL;
+    context->codec_storage_count = 0;
+    context->codec_num_frames = 0;
+    context->codec_ready_to_send = 0;
+}
+
+// encoder side: make sure there is a packet to encode into
+static bool CODEC_HOT_FUNC(media_queue_open_packet)(a2dp_media_sending_context_t * context){
+    if (context->codec_storage != NULL) return true;
+    if (media_queue_level(context) >= MEDIA_QUEUE_LEN) return false;
+    context->codec_storage = context->media_queue[context->media_queue_head & (MEDIA_QUEUE_LEN - 1)].data;
+    context->codec_storage_count = 0;
+    context->codec_num_frames = 0;
+    return true;
+}
+
+// encoder side: hand the current packet to the sender
+static void CODEC_HOT_FUNC(media_queue_commit_packet)(a2dp_media_sending_context_t * context){
+    a2dp_media_packet_t * packet = &context->media_queue[context->media_queue_head & (MEDIA_QUEUE_LEN - 1)];
+    packet->len = context->codec_storage_count;
+    packet->num_frames = context->codec_num_frames;
+    context->codec_storage = NULL;
+    __mem_fence_release();
+    context->media_queue_head++;
+}
+
 bool get_a2dp_connected_flag(){
     return a2dp_is_connected_flag;
 }
@@ -325,26 +551,36 @@ static int a2dp_sample_rate(void){
     return current_sample_rate;
 }
 
-static void configure_sample_rate(int sampling_frequency){
+static void a2dp_encoder_wait_idle(a2dp_media_sending_context_t * context);
+
+// false if the sink runs at another rate than the host sends, the stream must not open then
+static bool configure_sample_rate(int sampling_frequency){
     switch (sampling_frequency){
-        case AVDTP_SBC_48000:
-            current_sample_rate = 48000;
-            break;
-        case AVDTP_SBC_44100:
-            current_sample_rate = 44100;
-            break;
-        case AVDTP_SBC_32000:
-            current_sample_rate = 32000;
-            break;
-        case AVDTP_SBC_16000:
-            current_sample_rate = 16000;
+        case 48000:
+        case 44100:
+        case 32000:
+        case 16000:
+            current_sample_rate = sampling_frequency;
             break;
         default:
             break;
     }
 
-    media_tracker.codec_storage_count = 0;
+    a2dp_encoder_wait_idle(&media_tracker);
+    media_queue_reset(&media_tracker);
     media_tracker.samples_ready = 0;
+    return (uint32_t) current_sample_rate == usb_stream.sample_rate;
+}
+
+static int configure_codec_from(uint8_t num);
+
+// The configuration the sink accepted is not at the host rate, the host switched while it was on
+// its way. Abort it, the abort configures the stream again at the current rate.
+static void refuse_sample_rate(void){
+    printf("Sink configured at %d Hz, the host sends %u Hz, configuring again\n",
+           current_sample_rate, (unsigned) usb_stream.sample_rate);
+    usb_stream.rate_change_pending = true;
+    avdtp_source_abort_stream(media_tracker.avdtp_cid, media_tracker.local_seid);
 }
 
 static const char * codec_name_for_type(avdtp_media_codec_type_t codec_type){
@@ -358,15 +594,14 @@ static const char * codec_name_for_type(avdtp_media_codec_type_t codec_type){
     }
 }
 
-static void a2dp_demo_send_media_packet_sbc(void){
-    int num_bytes_in_frame = btstack_sbc_encoder_sbc_buffer_length();
-    int bytes_in_storage = media_tracker.codec_storage_count;
-    uint8_t num_sbc_frames = bytes_in_storage / num_bytes_in_frame;
+static void a2dp_demo_send_media_packet_sbc(a2dp_media_packet_t * packet){
+    int bytes_in_storage = packet->len;
+    uint8_t num_sbc_frames = packet->num_frames;
     // Prepend SBC Header
-    media_tracker.codec_storage[0] = num_sbc_frames;  // (fragmentation << 7) | (starting_packet << 6) | (last_packet << 5) | num_frames;
+    packet->data[0] = num_sbc_frames;  // (fragmentation << 7) | (starting_packet << 6) | (last_packet << 5) | num_frames;
     a2dp_source_stream_send_media_payload_rtp(media_tracker.avdtp_cid, media_tracker.local_seid, 0,
                                                media_tracker.rtp_timestamp,
-                                               media_tracker.codec_storage, bytes_in_storage + 1);
+                                               packet->data, bytes_in_storage + 1);
 
 
 
@@ -374,49 +609,28 @@ static void a2dp_demo_send_media_packet_sbc(void){
     unsigned int num_audio_samples_per_sbc_buffer = btstack_sbc_encoder_num_audio_frames();
 
     media_tracker.rtp_timestamp += num_sbc_frames * num_audio_samples_per_sbc_buffer;
-
-    media_tracker.codec_storage_count = 0;
-    media_tracker.codec_ready_to_send = 0;
 }
 
-static void a2dp_demo_send_media_packet_aac(void) {
-    int bytes_to_send;
-    if (media_tracker.codec_storage_count > media_tracker.max_media_payload_size)
-        bytes_to_send = media_tracker.max_media_payload_size;
-    else
-        bytes_to_send = media_tracker.codec_storage_count;
-    a2dp_source_stream_send_media_payload_rtp(media_tracker.avdtp_cid, media_tracker.local_seid, 0, media_tracker.rtp_timestamp, media_tracker.codec_storage, media_tracker.codec_storage_count);
-
-    //a2dp_source_stream_send_media_packet(media_tracker.avdtp_cid, media_tracker.local_seid, media_tracker.codec_storage, bytes_to_send);
-    media_tracker.codec_storage_count -= bytes_to_send;
-    memcpy(media_tracker.codec_storage, &media_tracker.codec_storage[bytes_to_send], media_tracker.codec_storage_count);
-    media_tracker.codec_ready_to_send = 0;
+static void a2dp_demo_send_media_packet_aac(a2dp_media_packet_t * packet) {
+    a2dp_source_stream_send_media_payload_rtp(media_tracker.avdtp_cid, media_tracker.local_seid, 0, media_tracker.rtp_timestamp, packet->data, packet->len);
 }
 
-static void a2dp_demo_send_media_packet_ldac(void) {
+static void a2dp_demo_send_media_packet_ldac(a2dp_media_packet_t * packet) {
 
-    uint8_t num_frames = media_tracker.codec_num_frames;
-    media_tracker.codec_storage[0] = num_frames; // frames in first byte
+    uint8_t num_frames = packet->num_frames;
+    packet->data[0] = num_frames; // frames in first byte
 
-    a2dp_source_stream_send_media_payload_rtp(media_tracker.avdtp_cid, media_tracker.local_seid, 0, media_tracker.rtp_timestamp, &media_tracker.codec_storage[0], media_tracker.codec_storage_count);
+    a2dp_source_stream_send_media_payload_rtp(media_tracker.avdtp_cid, media_tracker.local_seid, 0, media_tracker.rtp_timestamp, &packet->data[0], packet->len);
     media_tracker.rtp_timestamp += num_frames * LDACBT_ENC_LSU;
-
-    media_tracker.codec_storage_count = 0;
-    media_tracker.codec_ready_to_send = 0;
-    media_tracker.codec_num_frames = 0;
 }
 
-static void a2dp_send_aptx(void) {
+static void a2dp_send_aptx(a2dp_media_packet_t * packet) {
     // incorrect
-    a2dp_source_stream_send_media_packet(media_tracker.avdtp_cid, media_tracker.local_seid, media_tracker.codec_storage, media_tracker.codec_storage_count);
-    media_tracker.codec_storage_count = 0;
-    media_tracker.codec_ready_to_send = 0;
+    a2dp_source_stream_send_media_packet(media_tracker.avdtp_cid, media_tracker.local_seid, packet->data, packet->len);
 }
 
-static void a2dp_send_aptx_hd(void) {
-    a2dp_source_stream_send_media_packet(media_tracker.avdtp_cid, media_tracker.local_seid, media_tracker.codec_storage, media_tracker.codec_storage_count);
-    media_tracker.codec_storage_count = 0;
-    media_tracker.codec_ready_to_send = 0;
+static void a2dp_send_aptx_hd(a2dp_media_packet_t * packet) {
+    a2dp_source_stream_send_media_packet(media_tracker.avdtp_cid, media_tracker.local_seid, packet->data, packet->len);
 }
 
 //static void a2dp_send_lc3plus(void) {
@@ -472,7 +686,7 @@ static void a2dp_send_aptx_hd(void) {
 //    }
 //}
 
-static uint32_t get_vendor_id(const uint8_t *codec_info) {
+static uint32_t CODEC_HOT_FUNC(get_vendor_id)(const uint8_t *codec_info) {
     uint32_t vendor_id = 0;
     vendor_id |= codec_info[0];
     vendor_id |= codec_info[1] << 8;
@@ -481,32 +695,46 @@ static uint32_t get_vendor_id(const uint8_t *codec_info) {
     return vendor_id;
 }
 
-static uint16_t get_codec_id(const uint8_t *codec_info) {
+static uint16_t CODEC_HOT_FUNC(get_codec_id)(const uint8_t *codec_info) {
     uint16_t codec_id = 0;
     codec_id |= codec_info[4];
     codec_id |= codec_info[5] << 8;
     return codec_id;
 }
 
+static void usb_stream_first_packet_sent(void){
+    usb_stream.resuming = false;
+    usb_stream.resume_last_us = time_us_32() - usb_stream.resume_start_us;
+    usb_stream.resume_max_us = btstack_max(usb_stream.resume_max_us, usb_stream.resume_last_us);
+    usb_stream.resumes++;
+    printf("USB stream resumed, first packet after %u us, max %u us over %u resumes\n",
+           (unsigned) usb_stream.resume_last_us, (unsigned) usb_stream.resume_max_us, (unsigned) usb_stream.resumes);
+}
+
 static void a2dp_demo_send_media_packet(void) {
     adtvp_media_codec_capabilities_t local_cap;
+    if (media_queue_level(&media_tracker) == 0) return;
+    __mem_fence_acquire();
+    stage_prof_begin(STAGE_MEDIA_SEND);
+    a2dp_media_packet_t * packet = &media_tracker.media_queue[media_tracker.media_queue_tail & (MEDIA_QUEUE_LEN - 1)];
+
     switch (remote_seps[selected_remote_sep_index].sep.capabilities.media_codec.media_codec_type){
         case AVDTP_CODEC_SBC:
-            a2dp_demo_send_media_packet_sbc();
+            a2dp_demo_send_media_packet_sbc(packet);
             break;
         case AVDTP_CODEC_MPEG_2_4_AAC:
-            a2dp_demo_send_media_packet_aac();
+            a2dp_demo_send_media_packet_aac(packet);
             break;
         case AVDTP_CODEC_NON_A2DP:
             local_cap = sc.local_stream_endpoint->sep.capabilities.media_codec;
             uint32_t local_vendor_id = get_vendor_id(local_cap.media_codec_information);
             uint16_t local_codec_id = get_codec_id(local_cap.media_codec_information);
             if (local_vendor_id == A2DP_CODEC_VENDOR_ID_SONY && local_codec_id == A2DP_SONY_CODEC_LDAC)
-                a2dp_demo_send_media_packet_ldac();
+                a2dp_demo_send_media_packet_ldac(packet);
             else if (local_vendor_id == A2DP_CODEC_VENDOR_ID_APT_LTD && local_codec_id == A2DP_APT_LTD_CODEC_APTX)
-                a2dp_send_aptx();
+                a2dp_send_aptx(packet);
             else if (local_vendor_id == A2DP_CODEC_VENDOR_ID_QUALCOMM && local_codec_id == A2DP_QUALCOMM_CODEC_APTX_HD)
-                a2dp_send_aptx_hd();
+                a2dp_send_aptx_hd(packet);
             //else if (local_vendor_id == A2DP_CODEC_VENDOR_ID_FRAUNHOFER && local_codec_id == A2DP_FRAUNHOFER_CODEC_LC3PLUS)
                 //a2dp_send_lc3plus();
             break;
@@ -515,6 +743,359 @@ static void a2dp_demo_send_media_packet(void) {
             printf("Send media payload for %s not implemented yet\n", codec_name_for_type(sc.local_stream_endpoint->media_codec_type));
             break;
     }
+
+    // slot goes back to the encoder
+    __mem_fence_release();
+    media_tracker.media_queue_tail++;
+    stage_prof_end(STAGE_MEDIA_SEND);
+
+    if (usb_stream.resuming){
+        usb_stream_first_packet_sent();
+    }
+}
+
+static void a2dp_demo_request_send(a2dp_media_sending_context_t * context){
+    if (context->codec_ready_to_send) return;
+    if (media_queue_level(context) == 0) return;
+    context->codec_ready_to_send = 1;
+    stage_prof_begin(STAGE_RADIO_WAIT);
+    a2dp_source_stream_endpoint_request_can_send_now(context->avdtp_cid, context->local_seid);
+}
+
+// Packets waiting to go out: encoded but not yet handed to L2CAP, plus
+// ACL packets queued in the controller behind the one it is sending.
+static uint32_t a2dp_tx_queue_depth(a2dp_media_sending_context_t * context){
+    uint32_t depth = media_queue_level(context);
+    if (context->con_handle == HCI_CON_HANDLE_INVALID) return depth;
+
+    uint16_t free_slots = hci_number_free_acl_slots_for_handle(context->con_handle);
+    // the link is idle whenever we see the most free slots
+    if (free_slots > context->acl_slots_idle){
+        context->acl_slots_idle = free_slots;
+    }
+    // on a clear link a packet is on air about every third look, ABR only steps up after
+    // windows of an empty queue so counting it would pin the quality where it started
+    uint16_t in_flight = context->acl_slots_idle - free_slots;
+    return depth + (in_flight > 1 ? in_flight - 1 : 0);
+}
+
+#ifdef HAVE_LDAC_ENCODER
+static uint8_t ldac_governor_step_of(int eqmid){
+    for (uint8_t step = 0; step < LDAC_GOVERNOR_NUM_STEPS; step++){
+        if (ldac_governor_steps[step].eqmid == eqmid) return step;
+    }
+    return LDAC_GOVERNOR_NUM_STEPS - 1;
+}
+
+// alter moves one step along the same order per call
+static void ldac_governor_move(uint8_t step){
+    while (ldac_governor.step > step && ldacBT_alter_eqmid_priority(handleLDAC, LDACBT_EQMID_INC_QUALITY) == 0){
+        ldac_governor.step--;
+    }
+    while (ldac_governor.step < step && ldacBT_alter_eqmid_priority(handleLDAC, LDACBT_EQMID_INC_CONNECTION) == 0){
+        ldac_governor.step++;
+    }
+}
+
+static void ldac_governor_record(ldac_governor_reason_t reason, uint8_t step_from, uint8_t step_to, uint32_t tx_depth){
+    ldac_governor_decision_t * decision = &ldac_governor.history[ldac_governor.history_count % LDAC_GOVERNOR_HISTORY_LEN];
+    decision->time_ms = btstack_run_loop_get_time_ms();
+    decision->reason = (uint8_t) reason;
+    decision->step_from = step_from;
+    decision->step_to = step_to;
+    decision->link_step = ldac_governor.link_step;
+    decision->cpu_step = ldac_governor.cpu_step;
+    decision->tx_depth = (uint8_t) btstack_min(tx_depth, 255);
+    decision->frame_us = ldac_governor.frame_us[step_from];
+    decision->budget_us = ldac_governor.budget_us;
+    ldac_governor.history_count++;
+    printf("LDAC: %s -> %s, %s, queue %u, %u of %u us per frame\n", ldac_governor_steps[step_from].name,
+           ldac_governor_steps[step_to].name, ldac_governor_reason_names[reason], (unsigned) tx_depth,
+           decision->frame_us, decision->budget_us);
+}
+
+// Folds the frames core 1 encoded since the last update into the average of the running step,
+// and lowers the CPU ceiling once that is over budget or raises it again when a retry is due.
+static bool ldac_governor_judge_cpu(uint32_t period_ms){
+    uint8_t step = ldac_governor.step;
+    if (ldac_governor.busy_frames > 0){
+        uint32_t frame_us = ldac_governor.busy_us / ldac_governor.busy_frames;
+        if (ldac_governor.frames[step] == 0){
+            ldac_governor.frame_us[step] = (uint16_t) btstack_min(frame_us, UINT16_MAX);
+        } else {
+            ldac_governor.frame_us[step] = (uint16_t) btstack_min((3 * ldac_governor.frame_us[step] + frame_us) / 4, UINT16_MAX);
+        }
+        ldac_governor.frames[step] = (uint16_t) btstack_min(ldac_governor.frames[step] + ldac_governor.busy_frames, UINT16_MAX);
+        ldac_governor.busy_us = 0;
+        ldac_governor.busy_frames = 0;
+    }
+    if (ldac_governor.frames[step] < LDAC_GOVERNOR_MIN_FRAMES) return false;
+
+    if (ldac_governor.frame_us[step] > ldac_governor.budget_us){
+        if (step + 1 >= LDAC_GOVERNOR_NUM_STEPS || ldac_governor.cpu_step > step) return false;
+        ldac_governor.cpu_step = step + 1;
+        if (ldac_governor.retrying){
+            ldac_governor.retry_ms = btstack_min(2 * ldac_governor.retry_ms, LDAC_GOVERNOR_RETRY_MAX_MS);
+            ldac_governor.retrying = false;
+        }
+        ldac_governor.retry_left_ms = ldac_governor.retry_ms;
+        return true;
+    }
+    // only a ceiling that holds the encoder back is worth retrying
+    if (step != ldac_governor.cpu_step || ldac_governor.link_step >= step) return false;
+    if (ldac_governor.retrying){
+        // the retried step keeps up, a later cap starts over with the short retry
+        ldac_governor.retry_ms = LDAC_GOVERNOR_RETRY_MS;
+        ldac_governor.retrying = false;
+    }
+    if (ldac_governor.retry_left_ms > period_ms){
+        ldac_governor.retry_left_ms -= period_ms;
+        return false;
+    }
+    // the old average of the step above is stale, time it afresh
+    ldac_governor.cpu_step--;
+    ldac_governor.frames[ldac_governor.cpu_step] = 0;
+    ldac_governor.retrying = true;
+    return true;
+}
+
+// Runs on core 0 while the encoder is idle. ABR moves the link step from the tx queue depth, the
+// governor then runs the encoder at that step or below it, whichever the CPU allows.
+static void a2dp_ldac_abr_update(a2dp_media_sending_context_t * context, uint32_t elapsed_ms){
+    if (!ldac_abr_enabled) return;
+
+    context->abr_elapsed_ms += elapsed_ms;
+    if (context->abr_elapsed_ms < LDAC_ABR_INTERVAL_MS) return;
+    uint32_t period_ms = context->abr_elapsed_ms;
+    context->abr_elapsed_ms = 0;
+
+    uint32_t depth = a2dp_tx_queue_depth(context);
+    uint8_t cpu_step_before = ldac_governor.cpu_step;
+    bool cpu_changed = ldac_governor_judge_cpu(period_ms);
+
+    // ABR judges the step it chose itself, not the one the CPU left
+    uint8_t step_before = ldac_governor.step;
+    ldac_governor_move(ldac_governor.link_step);
+    int eqmid = ldac_ABR_Proc(handleLDAC, handleLDAC_ABR, depth, 1);
+    if (eqmid >= 0){
+        ldac_governor.step = ldac_governor_step_of(eqmid);
+    }
+    ldac_governor.link_step = ldac_governor.step;
+    ldac_governor_move(btstack_max(ldac_governor.link_step, ldac_governor.cpu_step));
+
+    uint8_t step = ldac_governor.step;
+    if (step == step_before && !cpu_changed) return;
+    ldac_governor_reason_t reason;
+    if (cpu_changed){
+        reason = ldac_governor.cpu_step > cpu_step_before ? LDAC_GOVERNOR_CPU_CAP : LDAC_GOVERNOR_CPU_RETRY;
+    } else {
+        reason = step > step_before ? LDAC_GOVERNOR_LINK_DOWN : LDAC_GOVERNOR_LINK_UP;
+    }
+    ldac_governor_record(reason, step_before, step, depth);
+}
+
+const char * a2dp_ldac_link_quality(void){
+    return ldac_abr_enabled ? ldac_governor_steps[ldac_governor.link_step].name : NULL;
+}
+
+// Prints the latest governor decisions, oldest first, and the encode time per step.
+void a2dp_ldac_governor_dump(void){
+    uint32_t cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    printf("LDAC governor: running %s, link %s, cpu %s, budget %u us (%u kcycles) per frame\n",
+           ldac_governor_steps[ldac_governor.step].name, ldac_governor_steps[ldac_governor.link_step].name,
+           ldac_governor_steps[ldac_governor.cpu_step].name, ldac_governor.budget_us,
+           (unsigned) (ldac_governor.budget_us * cycles_per_us / 1000));
+    for (uint8_t step = 0; step < LDAC_GOVERNOR_NUM_STEPS; step++){
+        if (ldac_governor.frames[step] == 0) continue;
+        printf("  %s %5u us %5u kcycles per frame, %u frames\n", ldac_governor_steps[step].name,
+               ldac_governor.frame_us[step], (unsigned) (ldac_governor.frame_us[step] * cycles_per_us / 1000),
+               ldac_governor.frames[step]);
+    }
+    uint32_t first = ldac_governor.history_count > LDAC_GOVERNOR_HISTORY_LEN ?
+                     ldac_governor.history_count - LDAC_GOVERNOR_HISTORY_LEN : 0;
+    for (uint32_t i = first; i < ldac_governor.history_count; i++){
+        const ldac_governor_decision_t * decision = &ldac_governor.history[i % LDAC_GOVERNOR_HISTORY_LEN];
+        printf("  %8u ms %s -> %s %-9s link %s cpu %s queue %u, %u of %u us\n", (unsigned) decision->time_ms,
+               ldac_governor_steps[decision->step_from].name, ldac_governor_steps[decision->step_to].name,
+               ldac_governor_reason_names[decision->reason], ldac_governor_steps[decision->link_step].name,
+               ldac_governor_steps[decision->cpu_step].name, decision->tx_depth, decision->frame_us, decision->budget_us);
+    }
+}
+
+// LDAC packs for 2-DH5 internally, the media MTU only has to be at least LDACBT_MTU_REQUIRED
+static int a2dp_ldac_encoder_init(a2dp_media_sending_context_t * context){
+    int mtu = a2dp_max_media_payload_size(context->avdtp_cid, context->local_seid) + AVDTP_MEDIA_PAYLOAD_HEADER_SIZE;
+    if (ldacBT_init_handle_encode(handleLDAC, mtu, LDACBT_EQMID_SQ, ldac_configuration.channel_mode,
+                LDACBT_SMPL_FMT_S16, ldac_configuration.sampling_frequency) == -1) {
+        printf("Couldn't initialize LDAC encoder with mtu %d: %d\n", mtu, ldacBT_get_error_code(handleLDAC));
+        return -1;
+    }
+    printf("LDAC encoder: mtu %d, eqmid %d, %d kbps\n", mtu, ldacBT_get_eqmid(handleLDAC), ldacBT_get_bitrate(handleLDAC));
+    return 0;
+}
+
+// start over with an empty history whenever the queues were cleared, the governor keeps its
+// decision log and times every step afresh
+static void a2dp_ldac_abr_reset(a2dp_media_sending_context_t * context){
+    context->abr_elapsed_ms = 0;
+    if (!ldac_abr_enabled) return;
+    if (ldac_ABR_Init(handleLDAC_ABR, LDAC_ABR_INTERVAL_MS) != 0){
+        printf("Couldn't initialize LDAC ABR\n");
+        ldac_abr_enabled = false;
+        return;
+    }
+
+    // one encode call takes LDACBT_ENC_LSU samples, twice that at 88.2/96 kHz
+    uint32_t frame_samples = ldac_configuration.sampling_frequency > 48000 ? 2 * LDACBT_ENC_LSU : LDACBT_ENC_LSU;
+    uint32_t frame_us = frame_samples * 1000000u / ldac_configuration.sampling_frequency;
+    ldac_governor.budget_us = (uint16_t) (frame_us * LDAC_GOVERNOR_BUDGET_PERCENT / 100);
+    ldac_governor.busy_us = 0;
+    ldac_governor.busy_frames = 0;
+    ldac_governor.step = ldac_governor_step_of(ldacBT_get_eqmid(handleLDAC));
+    ldac_governor.link_step = ldac_governor.step;
+    ldac_governor.cpu_step = 0;
+    memset(ldac_governor.frame_us, 0, sizeof(ldac_governor.frame_us));
+    memset(ldac_governor.frames, 0, sizeof(ldac_governor.frames));
+    ldac_governor.retry_ms = LDAC_GOVERNOR_RETRY_MS;
+    ldac_governor.retry_left_ms = 0;
+    ldac_governor.retrying = false;
+}
+#endif
+
+// bytes of one SBC frame, A2DP spec 12.9
+static uint16_t sbc_frame_length(const avdtp_media_codec_configuration_sbc_t * configuration, int bitpool){
+    int channels = configuration->num_channels;
+    int length = 4 + (4 * configuration->subbands * channels) / 8;
+    switch (configuration->channel_mode){
+        case SBC_CHANNEL_MODE_MONO:
+        case SBC_CHANNEL_MODE_DUAL_CHANNEL:
+            length += (configuration->block_length * channels * bitpool + 7) / 8;
+            break;
+        case SBC_CHANNEL_MODE_STEREO:
+            length += (configuration->block_length * bitpool + 7) / 8;
+            break;
+        default:
+            length += (configuration->subbands + configuration->block_length * bitpool + 7) / 8;
+            break;
+    }
+    return (uint16_t) length;
+}
+
+// largest bitpool up to max_bitpool that fits num_frames frames into frame_space bytes, 0 if none does
+static uint8_t sbc_fit_bitpool(const avdtp_media_codec_configuration_sbc_t * configuration, uint16_t frame_space,
+                               int num_frames, int max_bitpool){
+    for (int bitpool = max_bitpool; bitpool >= configuration->min_bitpool_value && bitpool > 0; bitpool--){
+        if (num_frames * sbc_frame_length(configuration, bitpool) <= frame_space) return (uint8_t) bitpool;
+    }
+    return 0;
+}
+
+// Core 0, encoder idle. Frames already in the current packet keep their bitpool, every SBC frame
+// header carries its own.
+static void a2dp_sbc_set_bitpool(uint8_t bitpool){
+    const avdtp_media_codec_configuration_sbc_t * configuration = &sbc_stream.configuration;
+    btstack_sbc_encoder_init(&sbc_encoder_state, SBC_MODE_STANDARD,
+        configuration->block_length, configuration->subbands,
+        configuration->allocation_method, configuration->sampling_frequency,
+        bitpool, configuration->channel_mode);
+    sbc_stream.silent_frame_length = 0;
+}
+
+// Runs on core 0 while the encoder is idle, steps the bitpool through the levels from the tx
+// queue depth: straight to the lowest when critical, one down on a rising dangerous depth, one up
+// after the queue stayed shallow long enough.
+static void a2dp_sbc_abr_update(a2dp_media_sending_context_t * context, uint32_t elapsed_ms){
+    if (!sbc_stream.configured || sbc_stream.num_levels < 2) return;
+
+    sbc_stream.elapsed_ms += elapsed_ms;
+    if (sbc_stream.elapsed_ms < SBC_ABR_INTERVAL_MS) return;
+    uint32_t period_ms = sbc_stream.elapsed_ms;
+    sbc_stream.elapsed_ms = 0;
+
+    uint32_t depth = a2dp_tx_queue_depth(context);
+    uint8_t level = sbc_stream.level;
+    if (depth >= SBC_ABR_THRESHOLD_CRITICAL){
+        level = sbc_stream.num_levels - 1;
+    } else if (depth >= SBC_ABR_THRESHOLD_DANGEROUS && depth > sbc_stream.prev_depth && level + 1 < sbc_stream.num_levels){
+        level++;
+    }
+    sbc_stream.prev_depth = depth;
+    sbc_stream.safe_ms = depth <= SBC_ABR_THRESHOLD_SAFE ? sbc_stream.safe_ms + period_ms : 0;
+    if (sbc_stream.since_step_up_ms < SBC_ABR_PENALTY_RESET_MS){
+        sbc_stream.since_step_up_ms += period_ms;
+    } else {
+        sbc_stream.penalty = 1;
+    }
+
+    if (level > sbc_stream.level){
+        if (sbc_stream.since_step_up_ms < SBC_ABR_STEADY_MS && sbc_stream.penalty < SBC_ABR_PENALTY_MAX){
+            sbc_stream.penalty *= 2;
+        }
+        sbc_stream.safe_ms = 0;
+    } else if (level > 0 && sbc_stream.safe_ms >= SBC_ABR_STEADY_MS * sbc_stream.penalty){
+        level--;
+        sbc_stream.safe_ms = 0;
+        sbc_stream.since_step_up_ms = 0;
+    }
+
+    if (level != sbc_stream.level){
+        printf("SBC ABR: bitpool %u -> %u\n", sbc_stream.bitpool[sbc_stream.level], sbc_stream.bitpool[level]);
+        sbc_stream.level = level;
+        a2dp_sbc_set_bitpool(sbc_stream.bitpool[level]);
+    }
+}
+
+// Packs for 3-DH5 when the media channel takes a full one, for 2-DH5 otherwise, and lays out the
+// bitpool levels for that packet size. Starts at the highest.
+static void a2dp_sbc_abr_reset(a2dp_media_sending_context_t * context){
+    sbc_stream.elapsed_ms = 0;
+    sbc_stream.safe_ms = 0;
+    sbc_stream.since_step_up_ms = SBC_ABR_STEADY_MS;
+    sbc_stream.prev_depth = 0;
+    sbc_stream.penalty = 1;
+    sbc_stream.level = 0;
+    sbc_stream.num_levels = 0;
+    if (!sbc_stream.configured) return;
+
+    const avdtp_media_codec_configuration_sbc_t * configuration = &sbc_stream.configuration;
+    if (context->max_media_payload_size >= SBC_3DH5_MEDIA_PAYLOAD_SIZE){
+        sbc_stream.packet_payload_size = SBC_3DH5_MEDIA_PAYLOAD_SIZE;
+    } else {
+        sbc_stream.packet_payload_size = btstack_min(context->max_media_payload_size, SBC_2DH5_MEDIA_PAYLOAD_SIZE);
+    }
+
+    // first byte is the sbc media header
+    uint16_t frame_space = sbc_stream.packet_payload_size - 1;
+    int bitpool = configuration->max_bitpool_value;
+    int num_frames = frame_space / sbc_frame_length(configuration, bitpool);
+    if (num_frames < 1){
+        num_frames = 1;
+    }
+    int first_bitpool = 0;
+    while (sbc_stream.num_levels < SBC_ABR_MAX_LEVELS && num_frames <= SBC_MAX_FRAMES_PER_PACKET){
+        bitpool = sbc_fit_bitpool(configuration, frame_space, num_frames, bitpool);
+        if (bitpool == 0) break;
+        if (first_bitpool == 0){
+            first_bitpool = bitpool;
+        }
+        bool packet_filled = num_frames * sbc_frame_length(configuration, bitpool) * 100 >= frame_space * SBC_MIN_PACKET_FILL_PERCENT;
+        if ((sbc_stream.num_levels == 0 && packet_filled) ||
+            (sbc_stream.num_levels > 0 && bitpool < sbc_stream.bitpool[sbc_stream.num_levels - 1])){
+            sbc_stream.bitpool[sbc_stream.num_levels++] = (uint8_t) bitpool;
+        }
+        num_frames++;
+    }
+    if (sbc_stream.num_levels == 0){
+        // nothing fills the packet, or not even one frame fits and the packet check sends single frames
+        sbc_stream.bitpool[sbc_stream.num_levels++] = (uint8_t) (first_bitpool ? first_bitpool : configuration->max_bitpool_value);
+    }
+
+    printf("SBC: %u byte packets, bitpool", sbc_stream.packet_payload_size);
+    for (int i = 0; i < sbc_stream.num_levels; i++){
+        printf(" %u", sbc_stream.bitpool[i]);
+    }
+    printf("\n");
+    a2dp_sbc_set_bitpool(sbc_stream.bitpool[0]);
 }
 
 static void produce_sine_audio(int16_t * pcm_buffer, int num_samples_to_write){
@@ -530,57 +1111,68 @@ static void produce_sine_audio(int16_t * pcm_buffer, int num_samples_to_write){
 }
 
 
-static int shared_audio_counter = 0;
-static uint16_t usb_audio_buf_counter = 0;
-static int16_t * shared_audio_ptr;
-
-
-void set_usb_buf_counter(uint16_t counter){
-    usb_audio_buf_counter = counter;
-}
-
-
+// largest block any encoder pulls from the ring in one go (SBC 16x8, LDAC frame at 96 kHz)
+#define MAX_ENCODER_INPUT_FRAMES 256
 
-int get_bt_buf_counter(void) {
-    return shared_audio_counter;
-}
+static audio_ring_t * shared_audio_ring;
+static int16_t audio_ring_scratch[MAX_ENCODER_INPUT_FRAMES * AUDIO_RING_CHANNELS];
 
 
-void set_shared_audio_buffer(int16_t *data) {
-    shared_audio_ptr = data;
+void set_shared_audio_ring(audio_ring_t *ring) {
+    shared_audio_ring = ring;
 }
 
 
 
-static int fill_sbc_audio_buffer(a2dp_media_sending_context_t * context){
+static int CODEC_HOT_FUNC(fill_sbc_audio_buffer)(a2dp_media_sending_context_t * context){
     // perform sbc encoding
     int total_num_bytes_read = 0;
     unsigned int num_audio_samples_per_sbc_buffer = btstack_sbc_encoder_num_audio_frames();
-
-
-    while (context->samples_ready >= num_audio_samples_per_sbc_buffer &&
-           (context->max_media_payload_size - context->codec_storage_count) >= btstack_sbc_encoder_sbc_buffer_length()){
-
-        btstack_sbc_encoder_process_data(&shared_audio_ptr[shared_audio_counter]);
-
-        uint16_t sbc_frame_size = btstack_sbc_encoder_sbc_buffer_length();
-        uint8_t * sbc_frame = btstack_sbc_encoder_sbc_buffer();
+    stage_prof_begin(STAGE_SBC_FILL);
+
+
+    // first byte of the payload is the sbc media header, it holds at most 15 frames
+    while (context->samples_ready >= num_audio_samples_per_sbc_buffer && !context->encoder_stop &&
+           context->codec_num_frames < SBC_MAX_FRAMES_PER_PACKET &&
+           (sbc_stream.packet_payload_size - 1 - context->codec_storage_count) >= btstack_sbc_encoder_sbc_buffer_length()){
+
+        uint16_t sbc_frame_size;
+        uint8_t * sbc_frame;
+        // peek first, the silence check then covers at least the frames read
+        uint32_t num_read;
+        const int16_t * pcm = audio_ring_peek(shared_audio_ring, audio_ring_scratch, num_audio_samples_per_sbc_buffer, &num_read);
+        bool silent = audio_ring_silent(shared_audio_ring);
+        if (silent && sbc_stream.silent_frame_length){
+            sbc_frame_size = sbc_stream.silent_frame_length;
+            sbc_frame = sbc_stream.silent_frame;
+        } else {
+            btstack_sbc_encoder_process_data((int16_t *) pcm);
+            sbc_frame_size = btstack_sbc_encoder_sbc_buffer_length();
+            sbc_frame = btstack_sbc_encoder_sbc_buffer();
+
+            if (!silent){
+                sbc_stream.silent_blocks = 0;
+            } else {
+                if (sbc_stream.silent_blocks >= SBC_ANALYSIS_WINDOW_BLOCKS && sbc_frame_size <= SBC_SILENT_FRAME_MAX_SIZE){
+                    memcpy(sbc_stream.silent_frame, sbc_frame, sbc_frame_size);
+                    sbc_stream.silent_frame_length = sbc_frame_size;
+                }
+                sbc_stream.silent_blocks = btstack_min(sbc_stream.silent_blocks + sbc_stream.configuration.block_length,
+                                                       SBC_ANALYSIS_WINDOW_BLOCKS);
+            }
+        }
+        audio_ring_consume(shared_audio_ring, num_read);
 
         total_num_bytes_read += num_audio_samples_per_sbc_buffer;
 
         // first byte in sbc storage contains sbc media header
         memcpy(&context->codec_storage[1 + context->codec_storage_count], sbc_frame, sbc_frame_size);
         context->codec_storage_count += sbc_frame_size;
+        context->codec_num_frames++;
         context->samples_ready -= num_audio_samples_per_sbc_buffer;
-
-        shared_audio_counter += num_audio_samples_per_sbc_buffer * 2;
-
-        if (shared_audio_counter > AUDIO_BUF_POOL_LEN - 1){
-            shared_audio_counter = 0;
-        }
-
     }
 
+    stage_prof_end(STAGE_SBC_FILL);
     return total_num_bytes_read;
 }
 
@@ -625,7 +1217,7 @@ static int fill_sbc_audio_buffer(a2dp_media_sending_context_t * context){
          produce_sine_audio((int16_t *) pcm_frame, num_audio_samples_per_aac_buffer);
          in_args.numInSamples = required_bytes;
          out_ptr              = &context->codec_storage[context->codec_storage_count];
-         out_size             = sizeof(context->codec_storage) - context->codec_storage_count;
+         out_size             = MEDIA_PACKET_STORAGE_SIZE - context->codec_storage_count;
          out_buf.bufs         = &out_ptr;
          out_buf.bufSizes     = &out_size;
          AACENC_ERROR err;
@@ -644,9 +1236,11 @@ static int fill_sbc_audio_buffer(a2dp_media_sending_context_t * context){
 
 
 #ifdef HAVE_LDAC_ENCODER
-static int a2dp_demo_fill_ldac_audio_buffer(a2dp_media_sending_context_t *context) {
+static int CODEC_HOT_FUNC(a2dp_demo_fill_ldac_audio_buffer)(a2dp_media_sending_context_t *context) {
     int          total_samples_read                = 0;
-    unsigned int num_audio_samples_per_ldac_buffer = LDACBT_ENC_LSU;//LDACBT_ENC_LSU;
+    // one LDAC frame per call, 256 samples at 88.2/96 kHz
+    unsigned int num_audio_samples_per_ldac_buffer = ldac_configuration.sampling_frequency > 48000 ?
+                                                     2 * LDACBT_ENC_LSU : LDACBT_ENC_LSU;
     int          consumed;
 	int          encoded = 0;
 	int          frames;
@@ -655,25 +1249,68 @@ static int a2dp_demo_fill_ldac_audio_buffer(a2dp_media_sending_context_t *contex
     if (context->codec_storage_count == 0)
         context->codec_storage_count = 1;
 
-    while (context->samples_ready >= num_audio_samples_per_ldac_buffer && encoded == 0) {
-
-        if (ldacBT_encode(handleLDAC, &shared_audio_ptr[shared_audio_counter], &consumed, &context->codec_storage[context->codec_storage_count], &encoded, &frames) != 0) {
+    stage_prof_begin(STAGE_LDAC_FILL);
+    while (context->samples_ready >= num_audio_samples_per_ldac_buffer && encoded == 0 && !context->encoder_stop) {
+
+        // the encoder reads the ring in place while splitting the channels, the volume is in the samples
+        const int16_t * span0;
+        const int16_t * span1;
+        uint32_t frames0;
+        uint32_t frames1;
+        uint32_t level = audio_ring_read_spans(shared_audio_ring, &span0, &frames0, &span1, &frames1);
+        if (level < num_audio_samples_per_ldac_buffer) {
+            // underrun, let the ring pad with silence
+            span0 = audio_ring_peek(shared_audio_ring, audio_ring_scratch, num_audio_samples_per_ldac_buffer, &level);
+            if (span0 == NULL) break;
+            frames0 = num_audio_samples_per_ldac_buffer;
+            frames1 = 0;
+        }
+        uint32_t frame_start_us = time_us_32();
+        int status;
+        bool silent = audio_ring_silent(shared_audio_ring);
+        if (silent) {
+            // nothing to hear, once the window is silent the encoder sends null frames without DSP
+            status = ldacBT_encode_silence(handleLDAC, &consumed,
+                                           &context->codec_storage[context->codec_storage_count], &encoded, &frames);
+        } else {
+            status = ldacBT_encode_s16_view(handleLDAC, span0, (int) frames0, span1, (int) frames1, LDACBT_GAIN_UNITY, &consumed,
+                                            &context->codec_storage[context->codec_storage_count], &encoded, &frames);
+        }
+        if (status != 0) {
             printf("LDAC encoding error: %d\n", ldacBT_get_error_code(handleLDAC));
         }
         consumed = consumed / (2 * ldac_configuration.num_channels);
+        if (consumed == 0) break;
+        // for the quality governor, core 0 reads it while we are idle. Silence would make every
+        // step look cheap.
+        if (!silent) {
+            ldac_governor.busy_us += time_us_32() - frame_start_us;
+            ldac_governor.busy_frames++;
+        }
+        // the padding of an underrun was never in the ring
+        audio_ring_consume(shared_audio_ring, btstack_min((uint32_t) consumed, level));
         total_samples_read += consumed;
         context->codec_storage_count += encoded;
         context->codec_num_frames += frames;
         context->samples_ready -= consumed;
-
-        shared_audio_counter += num_audio_samples_per_ldac_buffer * 2;
-        if (shared_audio_counter > AUDIO_BUF_POOL_LEN - 1){
-            shared_audio_counter = 0;
-        }
     }
+    stage_prof_end(STAGE_LDAC_FILL);
 
     return total_samples_read;
 }
+
+#ifdef STAGE_PROFILE
+// the encoder stages come in LDACBT_PROF_* order, from whichever core runs them
+static void CODEC_HOT_FUNC(ldac_stage_begin)(int stage, void * user){
+    UNUSED(user);
+    stage_prof_begin(STAGE_LDAC_MDCT + stage);
+}
+
+static void CODEC_HOT_FUNC(ldac_stage_end)(int stage, void * user){
+    UNUSED(user);
+    stage_prof_end(STAGE_LDAC_MDCT + stage);
+}
+#endif
 #endif
 
 #ifdef HAVE_APTX
@@ -727,10 +1364,7 @@ static int a2dp_demo_fill_aptx_audio_buffer(a2dp_media_sending_context_t *contex
         aptx_encode(aptx_handle, pcm_frame8, 4 * 3 * 2, &context->codec_storage[context->codec_storage_count], 4, &written);
 
 
-        shared_audio_counter += num_audio_samples_per_aptx_buffer * 2;
-        if (shared_audio_counter > AUDIO_BUF_POOL_LEN - 1){
-            shared_audio_counter = 0;
-        }
+        audio_ring_consume(shared_audio_ring, num_audio_samples_per_aptx_buffer);
 
         total_num_bytes_read += num_audio_samples_per_aptx_buffer;
         context->codec_storage_count += out_size;  // LLRR  for aptx or LLLRRR for aptx hd
@@ -792,40 +1426,10 @@ static int a2dp_demo_fill_aptx_audio_buffer(a2dp_media_sending_context_t *contex
 // #endif
 
 
-static void * avdtp_audio_timeout_handler2(btstack_timer_source_t * timer){
-    //printf("sending data\n");
-    //printf("time out called!\n");
-
+// Runs on core 1. Encodes into the current packet, returns true once it is complete.
+static bool CODEC_HOT_FUNC(a2dp_encode_media_packet)(a2dp_media_sending_context_t * context){
     adtvp_media_codec_capabilities_t local_cap;
-    a2dp_media_sending_context_t * context = (a2dp_media_sending_context_t *) btstack_run_loop_get_timer_context(timer);
-    btstack_run_loop_set_timer(&context->audio_timer, audio_timer_interval);
-    btstack_run_loop_add_timer(&context->audio_timer);
-    uint32_t now = btstack_run_loop_get_time_ms();
-
-    uint32_t update_period_ms = audio_timer_interval;
-    if (context->time_audio_data_sent > 0){
-        update_period_ms = now - context->time_audio_data_sent;
-    }
-
-    //printf("update_period_ms is %d\n", update_period_ms);
-    //printf("a2dp_sample_rate() is %d\n", a2dp_sample_rate());
-
-
-    uint32_t num_samples = (update_period_ms * a2dp_sample_rate()) / 1000;
-    context->acc_num_missed_samples += (update_period_ms * a2dp_sample_rate()) % 1000;
-    
-    while (context->acc_num_missed_samples >= 1000){
-        num_samples++;
-        context->acc_num_missed_samples -= 1000;
-    }
-    context->time_audio_data_sent = now;
-    context->samples_ready += num_samples;
-
-    //printf("num_samples is %d\n", num_samples);
-    //printf("samples_ready is %d\n", context->samples_ready);
-
-
-    if (context->codec_ready_to_send) return 0;
+    bool packet_ready = false;
 
     avdtp_media_codec_type_t codec_type = sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_type;
 
@@ -833,10 +1437,10 @@ static void * avdtp_audio_timeout_handler2(btstack_timer_source_t * timer){
 
         case AVDTP_CODEC_SBC:
             fill_sbc_audio_buffer(context);
-            if ((context->codec_storage_count + btstack_sbc_encoder_sbc_buffer_length()) > context->max_media_payload_size){
+            if (context->codec_num_frames >= SBC_MAX_FRAMES_PER_PACKET ||
+                (1 + context->codec_storage_count + btstack_sbc_encoder_sbc_buffer_length()) > sbc_stream.packet_payload_size){
                 // schedule sending
-                context->codec_ready_to_send = 1;
-                a2dp_source_stream_endpoint_request_can_send_now(context->avdtp_cid, context->local_seid);
+                packet_ready = true;
             }
             break;
         case AVDTP_CODEC_MPEG_1_2_AUDIO:
@@ -849,8 +1453,7 @@ static void * avdtp_audio_timeout_handler2(btstack_timer_source_t * timer){
 
             if (context->codec_storage_count > 0) {
                 // schedule sending
-                context->codec_ready_to_send = 1;
-                a2dp_source_stream_endpoint_request_can_send_now(context->avdtp_cid, context->local_seid);
+                packet_ready = true;
             }
             break;
 #endif
@@ -864,15 +1467,11 @@ static void * avdtp_audio_timeout_handler2(btstack_timer_source_t * timer){
             // LDAC
 #ifdef HAVE_LDAC_ENCODER
             if (local_vendor_id == A2DP_CODEC_VENDOR_ID_SONY && local_codec_id == A2DP_SONY_CODEC_LDAC) {
-                
-                if (context->codec_ready_to_send)
-                    return 0;
                 a2dp_demo_fill_ldac_audio_buffer(context);
 
                 if (context->codec_storage_count > 1) {
                     // schedule sending
-                    context->codec_ready_to_send = 1;
-                    a2dp_source_stream_endpoint_request_can_send_now(context->avdtp_cid, context->local_seid);
+                    packet_ready = true;
                 }
             }
 #endif
@@ -880,14 +1479,11 @@ static void * avdtp_audio_timeout_handler2(btstack_timer_source_t * timer){
             // APTX / APTX HD
             if ((local_vendor_id == A2DP_CODEC_VENDOR_ID_APT_LTD && local_codec_id == A2DP_APT_LTD_CODEC_APTX) ||
                     (local_vendor_id == A2DP_CODEC_VENDOR_ID_QUALCOMM && local_codec_id == A2DP_QUALCOMM_CODEC_APTX_HD)) {
-                if (context->codec_ready_to_send)
-                    return 0;
                 a2dp_demo_fill_aptx_audio_buffer(context);
 
                 if ((context->codec_storage_count + 6) > context->max_media_payload_size) {
                     // schedule sending
-                    context->codec_ready_to_send = 1;
-                    a2dp_source_stream_endpoint_request_can_send_now(context->avdtp_cid, context->local_seid);
+                    packet_ready = true;
                 }
             }
 #endif
@@ -896,8 +1492,7 @@ static void * avdtp_audio_timeout_handler2(btstack_timer_source_t * timer){
                 a2dp_demo_fill_lc3plus_audio_buffer(context);
                 if (context->codec_storage_count > 0) {
                     // schedule sending
-                    context->codec_ready_to_send = 1;
-                    a2dp_source_stream_endpoint_request_can_send_now(context->avdtp_cid, context->local_seid);
+                    packet_ready = true;
                 }
             }
 #endif
@@ -905,42 +1500,343 @@ static void * avdtp_audio_timeout_handler2(btstack_timer_source_t * timer){
         default:
             break;
     }
+    return packet_ready;
+}
+
+// Runs on core 1. Encodes as far ahead as pacing and queue space allow, btstack must not be touched here.
+static bool CODEC_HOT_FUNC(a2dp_encode_media)(a2dp_media_sending_context_t * context){
+    while (!context->encoder_stop && media_queue_open_packet(context)){
+        if (!a2dp_encode_media_packet(context)) break;
+        media_queue_commit_packet(context);
+    }
+    return media_queue_level(context) > 0;
+}
+
+// Core 1 never takes the run loop lock: core 0 may hold it while it waits for the encoder. Whatever
+// core 1 hands over goes through a flag and btstack_run_loop_poll_data_sources_from_irq(), which
+// only marks the run loop's work pending, and core 0 picks it up in encoder_data_source.
+static btstack_data_source_t encoder_data_source;
+
+#if defined(HAVE_LDAC_ENCODER) && defined(LDAC_DUAL_CORE_CHANNELS)
+// One channel job per LDAC stage, whichever core claims it first runs it.
+// Core 0 picks it up when the run loop polls, core 1 takes it back when core 0 is busy.
+static spin_lock_t * ldac_channel_lock;
+static LDACBT_CH_JOB volatile ldac_channel_job;
+static void * volatile ldac_channel_job_arg;
+static volatile bool ldac_channel_job_done;
+
+static bool CODEC_HOT_FUNC(ldac_channel_job_run)(void){
+    uint32_t save = spin_lock_blocking(ldac_channel_lock);
+    LDACBT_CH_JOB job = ldac_channel_job;
+    void * arg = ldac_channel_job_arg;
+    ldac_channel_job = NULL;
+    spin_unlock(ldac_channel_lock, save);
+
+    if (job == NULL) return false;
+    job(arg);
+    __mem_fence_release();
+    ldac_channel_job_done = true;
+    return true;
+}
+
+// core 1
+static void CODEC_HOT_FUNC(ldac_channel_job_start)(LDACBT_CH_JOB job, void * job_arg, void * user){
+    UNUSED(user);
+    uint32_t save = spin_lock_blocking(ldac_channel_lock);
+    ldac_channel_job_done = false;
+    ldac_channel_job_arg = job_arg;
+    ldac_channel_job = job;
+    spin_unlock(ldac_channel_lock, save);
+
+    btstack_run_loop_poll_data_sources_from_irq();
+}
+
+// core 1
+static void CODEC_HOT_FUNC(ldac_channel_job_wait)(void * user){
+    UNUSED(user);
+    if (!ldac_channel_job_run()){
+        while (!ldac_channel_job_done){
+            tight_loop_contents();
+        }
+    }
+    __mem_fence_acquire();
+}
+#endif
+
+static a2dp_media_sending_context_t * volatile encoder_job;
+static a2dp_media_sending_context_t * volatile encoder_done;
+static volatile bool encoder_running;
+
+static void a2dp_encoder_stopped(a2dp_media_sending_context_t * context);
+
+// back on core 0 once core 1 finished a job
+static void a2dp_encoder_done_handler(a2dp_media_sending_context_t * context){
+    context->encoder_busy = false;
+    if (context->encoder_stop){
+        a2dp_encoder_stopped(context);
+        return;
+    }
+    if (context->encoder_packet_ready){
+        context->encoder_packet_ready = false;
+        a2dp_demo_request_send(context);
+    }
+}
+
+// core 0, polled whenever core 1 has something for it
+static void a2dp_encoder_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+#if defined(HAVE_LDAC_ENCODER) && defined(LDAC_DUAL_CORE_CHANNELS)
+    ldac_channel_job_run();
+#endif
+    a2dp_media_sending_context_t * context = encoder_done;
+    if (context == NULL) return;
+    encoder_done = NULL;
+    __mem_fence_acquire();
+    a2dp_encoder_done_handler(context);
+}
+
+// long-lived encoder loop, sleeps until core 0 rings the doorbell
+static void CODEC_HOT_FUNC(encoder_core1_main)(void){
+    // core 0 writes link keys to flash, it must be able to park us
+    flash_safe_execute_core_init();
+    stage_prof_core_init();
+
+    while (true){
+        a2dp_media_sending_context_t * context;
+        while ((context = encoder_job) == NULL){
+            __wfe();
+        }
+        encoder_running = true;
+        encoder_job = NULL;
+        __mem_fence_acquire();
+
+        context->encoder_packet_ready = a2dp_encode_media(context);
+
+        __mem_fence_release();
+        encoder_done = context;
+        encoder_running = false;
+        btstack_run_loop_poll_data_sources_from_irq();
+    }
+}
+
+// Only for replacing the encoder on a new codec configuration. Core 1 was asked to stop when the
+// stream closed and never waits for core 0, this returns within a frame, in practice at once.
+static void a2dp_encoder_wait_idle(a2dp_media_sending_context_t * context){
+    while (encoder_job != NULL || encoder_running){
+        tight_loop_contents();
+    }
+    __mem_fence_acquire();
+    // a done callback may still be queued, it must not schedule a stale packet
+    context->encoder_packet_ready = false;
 }
 
 static void avdtp_audio_timeout_handler(btstack_timer_source_t * timer){
-    //avdtp_audio_timeout_handler2(timer);
-   multicore_reset_core1();
-   multicore_launch_core1(avdtp_audio_timeout_handler2(timer));
+    a2dp_media_sending_context_t * context = (a2dp_media_sending_context_t *) btstack_run_loop_get_timer_context(timer);
+    btstack_run_loop_set_timer(&context->audio_timer, audio_timer_interval);
+    btstack_run_loop_add_timer(&context->audio_timer);
+    uint32_t now = btstack_run_loop_get_time_ms();
+
+    uint32_t update_period_ms = audio_timer_interval;
+    if (context->time_audio_data_sent > 0){
+        update_period_ms = now - context->time_audio_data_sent;
+    }
+
+    uint32_t num_samples = (update_period_ms * a2dp_sample_rate()) / 1000;
+    context->acc_num_missed_samples += (update_period_ms * a2dp_sample_rate()) % 1000;
+    
+    while (context->acc_num_missed_samples >= 1000){
+        num_samples++;
+        context->acc_num_missed_samples -= 1000;
+    }
+    context->time_audio_data_sent = now;
+    context->samples_pending += num_samples;
+
+    if (context->encoder_busy) return;
+
+#ifdef HAVE_LDAC_ENCODER
+    a2dp_ldac_abr_update(context, update_period_ms);
+#endif
+    a2dp_sbc_abr_update(context, update_period_ms);
+
+    // core 1 owns samples_ready and the packet being encoded while busy
+    context->samples_ready += context->samples_pending;
+    context->samples_pending = 0;
+    context->encoder_busy = true;
+    __mem_fence_release();
+    encoder_job = context;
+    __sev();
 }
 
-static void a2dp_demo_timer_start(a2dp_media_sending_context_t * context){
-    //context->max_media_payload_size = 0x290;// avdtp_max_media_payload_size(context->local_seid);
-    //context->max_media_payload_size = btstack_min(a2dp_max_media_payload_size(context->a2dp_cid, context->local_seid), SBC_STORAGE_SIZE);
+// what core 0 does once the encoder stopped
+#define ENCODER_STOP_FLUSH_RING     (1u << 0)  // the ring holds audio that must not be played any more
+#define ENCODER_STOP_RESET_QUEUE    (1u << 1)  // drop the packets encoded so far
+#define ENCODER_STOP_RESTART        (1u << 2)  // then start the timer again
 
-    context->max_media_payload_size = 0x290;
-    context->codec_storage_count = 0;
-    context->codec_ready_to_send = 0;
-    context->streaming = 1;
-    btstack_run_loop_remove_timer(&context->audio_timer);
+static void a2dp_demo_timer_arm(a2dp_media_sending_context_t * context){
+    // fill whatever the media channel allows, 3-DH5 links get the full ~1000 bytes
+    context->max_media_payload_size = btstack_min(a2dp_max_media_payload_size(context->avdtp_cid, context->local_seid), MEDIA_PACKET_STORAGE_SIZE);
+    context->acl_slots_idle = 0;
+#ifdef HAVE_LDAC_ENCODER
+    a2dp_ldac_abr_reset(context);
+#endif
+    a2dp_sbc_abr_reset(context);
     btstack_run_loop_set_timer_handler(&context->audio_timer, avdtp_audio_timeout_handler);
     btstack_run_loop_set_timer_context(&context->audio_timer, context);
     btstack_run_loop_set_timer(&context->audio_timer, audio_timer_interval);
     btstack_run_loop_add_timer(&context->audio_timer);
 }
 
-static void a2dp_demo_timer_stop(a2dp_media_sending_context_t * context){
+// core 0, core 1 is idle
+static void a2dp_encoder_stopped(a2dp_media_sending_context_t * context){
+    uint8_t actions = context->encoder_stop_actions;
+    context->encoder_stop_actions = 0;
+    context->encoder_stop = false;
+    context->encoder_packet_ready = false;
+    // the first tick after a restart must not claim the time spent stopped
     context->time_audio_data_sent = 0;
     context->acc_num_missed_samples = 0;
     context->samples_ready = 0;
-    context->streaming = 1;
-    context->codec_storage_count = 0;
-    context->codec_ready_to_send = 0;
+    context->samples_pending = 0;
+    if (actions & ENCODER_STOP_FLUSH_RING){
+        audio_ring_flush(shared_audio_ring);
+    }
+    if (actions & ENCODER_STOP_RESET_QUEUE){
+        media_queue_reset(context);
+    }
+    if (actions & ENCODER_STOP_RESTART){
+        a2dp_demo_timer_arm(context);
+    }
+}
+
+// Stops the encoder without waiting for core 1: the actions run once it is done with its frame,
+// right away if it is idle. A later stop drops a restart still pending.
+static void a2dp_encoder_stop(a2dp_media_sending_context_t * context, uint8_t actions){
     btstack_run_loop_remove_timer(&context->audio_timer);
-} 
+    context->encoder_stop_actions = (context->encoder_stop_actions & ~ENCODER_STOP_RESTART) | actions;
+    if (context->encoder_busy){
+        context->encoder_stop = true;
+        return;
+    }
+    a2dp_encoder_stopped(context);
+}
+
+static void a2dp_demo_timer_start(a2dp_media_sending_context_t * context){
+    context->streaming = 1;
+    a2dp_encoder_stop(context, ENCODER_STOP_RESET_QUEUE | ENCODER_STOP_RESTART);
+}
+
+static void a2dp_demo_timer_stop(a2dp_media_sending_context_t * context){
+    context->streaming = 1;
+    a2dp_encoder_stop(context, ENCODER_STOP_RESET_QUEUE);
+}
 
 static void a2dp_demo_timer_pause(a2dp_media_sending_context_t * context){
-    btstack_run_loop_remove_timer(&context->audio_timer);
-} 
+    a2dp_encoder_stop(context, 0);
+}
+
+static void usb_stream_suspend_timeout(btstack_timer_source_t * timer){
+    UNUSED(timer);
+    if (!usb_stream.idle || !stream_started) return;
+    printf("USB stream idle for %u ms, suspending the A2DP stream\n", (unsigned) USB_IDLE_SUSPEND_MS);
+    usb_stream.suspended = true;
+    avdtp_source_suspend(media_tracker.avdtp_cid, media_tracker.local_seid);
+}
+
+// host closed its stream: stop encoding at once, suspend the stream if it stays away
+static void usb_stream_enter_idle(void){
+    if (usb_stream.idle || !stream_started || !finish_scan_avdtp_codec) return;
+    usb_stream.idle = true;
+    usb_stream.resuming = false;
+    // whatever is left in the ring is the end of what the host played, it must not come first
+    // once the host is back
+    a2dp_encoder_stop(&media_tracker, ENCODER_STOP_FLUSH_RING);
+    btstack_run_loop_set_timer_handler(&usb_stream.suspend_timer, &usb_stream_suspend_timeout);
+    btstack_run_loop_set_timer(&usb_stream.suspend_timer, USB_IDLE_SUSPEND_MS);
+    btstack_run_loop_add_timer(&usb_stream.suspend_timer);
+    printf("USB stream idle.\n");
+}
+
+static void usb_stream_leave_idle(void){
+    btstack_run_loop_remove_timer(&usb_stream.suspend_timer);
+    if (!usb_stream.idle) return;
+    usb_stream.idle = false;
+    usb_stream.resuming = true;
+    usb_stream.resume_start_us = usb_stream.changed_us;
+    if (!usb_stream.suspended){
+        a2dp_demo_timer_start(&media_tracker);
+    } else if (!stream_started){
+        // the START accept restarts the timer
+        usb_stream.suspended = false;
+        avdtp_source_start_stream(media_tracker.avdtp_cid, media_tracker.local_seid);
+    }
+    // else the SUSPEND is still on its way, its accept sends the START
+}
+
+static void usb_stream_reset(void){
+    btstack_run_loop_remove_timer(&usb_stream.suspend_timer);
+    usb_stream.idle = false;
+    usb_stream.suspended = false;
+    usb_stream.resuming = false;
+    stream_started = false;
+}
+
+// host switched the sample rate: close the stream, the release configures it again at the new rate
+static void usb_stream_change_rate(void){
+    uint32_t sample_rate = usb_stream.sample_rate;
+    if (usb_stream.rate_refused && !usb_stream.rate_change_pending){
+        // nothing is configured, the sink may take the new rate
+        configure_codec_from(cur_capability - 1);
+        return;
+    }
+    // before the first START the configuration already follows the host
+    if (!is_streaming || usb_stream.rate_change_pending || sample_rate == (uint32_t) current_sample_rate) return;
+    printf("USB sample rate %u Hz, reconfiguring the %d Hz stream\n", (unsigned) sample_rate, current_sample_rate);
+    usb_stream.rate_change_pending = true;
+    usb_stream_reset();
+    // the ring holds audio at the old rate, core 1 may still be reading it
+    a2dp_encoder_stop(&media_tracker, ENCODER_STOP_RESET_QUEUE | ENCODER_STOP_FLUSH_RING);
+    avdtp_source_stop_stream(media_tracker.avdtp_cid, media_tracker.local_seid);
+}
+
+static void usb_stream_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    if (usb_stream.rate_changed){
+        usb_stream.rate_changed = false;
+        __mem_fence_acquire();
+        usb_stream_change_rate();
+    }
+    if (usb_stream.changed){
+        usb_stream.changed = false;
+        __mem_fence_acquire();
+        if (usb_stream.active){
+            usb_stream_leave_idle();
+        } else {
+            usb_stream_enter_idle();
+        }
+    }
+}
+
+void a2dp_source_usb_streaming(bool active){
+    usb_stream.active = active;
+    usb_stream.changed_us = time_us_32();
+    __mem_fence_release();
+    usb_stream.changed = true;
+    // the USB stack comes up before BTstack
+    if (usb_stream.registered){
+        btstack_run_loop_poll_data_sources_from_irq();
+    }
+}
+
+void a2dp_source_usb_sample_rate(uint32_t sample_rate){
+    usb_stream.sample_rate = sample_rate;
+    __mem_fence_release();
+    usb_stream.rate_changed = true;
+    if (usb_stream.registered){
+        btstack_run_loop_poll_data_sources_from_irq();
+    }
+}
 
 
 static void dump_sbc_capability(media_codec_information_sbc_t media_codec_sbc){
@@ -1158,6 +2054,7 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
                 break;
             }
             media_tracker.avdtp_cid = avdtp_subevent_signaling_connection_established_get_avdtp_cid(packet);
+            media_tracker.con_handle = avdtp_subevent_signaling_connection_established_get_con_handle(packet);
             printf("AVDTP source signaling connection established: avdtp_cid 0x%02x\n", avdtp_cid);
 
             set_led_mode_off();
@@ -1180,6 +2077,11 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             media_tracker.remote_seid = avdtp_subevent_streaming_connection_established_get_remote_seid(packet);
             a2dp_is_connected_flag = true;
 
+#ifdef HAVE_LDAC_ENCODER
+            if (ldac_encoder_configured && a2dp_ldac_encoder_init(&media_tracker) != 0) {
+                break;
+            }
+#endif
             printf("Streaming connection established, avdtp_cid 0x%02x\n", avdtp_cid);
             avdtp_source_start_stream(media_tracker.avdtp_cid, media_tracker.local_seid);
             break;
@@ -1412,13 +2314,20 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
                     break;
             }
             dump_sbc_configuration(sbc_configuration);
+            sbc_stream.configuration = sbc_configuration;
+            sbc_stream.configured = true;
 
-            configure_sample_rate(sc.sampling_frequency);
+            if (!configure_sample_rate(sbc_configuration.sampling_frequency)){
+                refuse_sample_rate();
+                break;
+            }
             btstack_sbc_encoder_init(&sbc_encoder_state, SBC_MODE_STANDARD, 
                 sbc_configuration.block_length, sbc_configuration.subbands, 
                 sbc_configuration.allocation_method, sbc_configuration.sampling_frequency, 
                 sbc_configuration.max_bitpool_value,
                 sbc_configuration.channel_mode);
+            sbc_stream.silent_frame_length = 0;
+            sbc_stream.silent_blocks = 0;
 
             audio_timer_interval = 10;
 
@@ -1531,24 +2440,47 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
                 printf("A2DP Source: Received LDAC configuration! Sampling frequency: %d, channel mode: %d channels: %d\n",
                         ldac_configuration.sampling_frequency, ldac_configuration.channel_mode, ldac_configuration.num_channels);
 
-                handleLDAC = ldacBT_get_handle();
+                // no stream is open while the codec is configured, the previous handle is idle
+                a2dp_encoder_wait_idle(&media_tracker);
+                if (handleLDAC != NULL) {
+                    ldacBT_free_handle(handleLDAC);
+                }
+                handleLDAC = ldacBT_get_handle_static(ldac_arena, sizeof(ldac_arena));
                 if (handleLDAC == NULL) {
                     printf("Failed to get LDAC handle\n");
                     break;
                 }
+#ifdef LDAC_DUAL_CORE_CHANNELS
+                ldacBT_set_channel_parallel(handleLDAC, &ldac_channel_job_start, &ldac_channel_job_wait, NULL);
+#endif
+#ifdef LDAC_FAST_SIGANA
+                // the frame status only goes into the frame header, a steady one needs no analysis
+                ldacBT_set_sigana_mode(handleLDAC, LDACBT_SIGANA_FAST);
+#endif
+#ifdef STAGE_PROFILE
+                ldacBT_set_profile_hook(handleLDAC, &ldac_stage_begin, &ldac_stage_end, NULL);
+#endif
 
-                // init ldac encoder
-                int mtu = 679; // minimal required mtu
-                if (ldacBT_init_handle_encode(handleLDAC, mtu, LDACBT_EQMID_SQ, ldac_configuration.channel_mode,
-                            LDACBT_SMPL_FMT_S16, ldac_configuration.sampling_frequency) == -1) {
-                    printf("Couldn't initialize LDAC encoder: %d\n", ldacBT_get_error_code(handleLDAC));
-                    break;
+                // encoder itself is initialized once the media channel is open
+                ldac_encoder_configured = true;
+                sbc_stream.configured = false;
+                // start at SQ, ABR steps between HQ/SQ/Q0/Q1/MQ from the tx queue depth and the
+                // governor keeps it within what the encoder manages per frame
+                if (handleLDAC_ABR == NULL) {
+                    handleLDAC_ABR = ldac_ABR_get_handle();
+                }
+                ldac_abr_enabled = handleLDAC_ABR != NULL;
+                if (!ldac_abr_enabled) {
+                    printf("Failed to get LDAC ABR handle, staying at fixed quality\n");
                 }
                 // HQ -> audio_timer_interval = 1
                 // SQ -> audio_timer_interval <= 5
                 // MQ -> audio_timer_interval <= 10
                 audio_timer_interval = 3;
-                current_sample_rate = ldac_configuration.sampling_frequency;
+                if (!configure_sample_rate(ldac_configuration.sampling_frequency)){
+                    refuse_sample_rate();
+                    break;
+                }
                 printf("current LDAC sampling rate is %d \n", current_sample_rate);
 
                 avdtp_source_open_stream(media_tracker.avdtp_cid, media_tracker.local_seid, media_tracker.remote_seid);
@@ -1637,7 +2569,11 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
 
 
         case AVDTP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW:
+            stage_prof_end(STAGE_RADIO_WAIT);
             a2dp_demo_send_media_packet();
+            media_tracker.codec_ready_to_send = 0;
+            // drain whatever the encoder queued meanwhile back to back
+            a2dp_demo_request_send(&media_tracker);
             break;  
 
 
@@ -1656,20 +2592,36 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
                     break;
                 case  AVDTP_SI_START:
                     printf("Stream started.\n");
+                    stream_started = true;
                     if (finish_scan_avdtp_codec){
                         a2dp_demo_timer_start(&media_tracker);
                         is_streaming = true;
                         start_led_blink();
+                        // the host closed its stream meanwhile
+                        if (!usb_stream.active){
+                            usb_stream_enter_idle();
+                        }
                     }
                     break;
                 case AVDTP_SI_SUSPEND:
                     printf("Stream paused.\n");
+                    stream_started = false;
                     a2dp_demo_timer_pause(&media_tracker);
+                    // the host came back while the SUSPEND was on its way
+                    if (usb_stream.suspended && !usb_stream.idle){
+                        usb_stream.suspended = false;
+                        avdtp_source_start_stream(media_tracker.avdtp_cid, media_tracker.local_seid);
+                    }
                     break;
                 case AVDTP_SI_ABORT:
                 case AVDTP_SI_CLOSE:
                     printf("Stream released.\n");
                     a2dp_demo_timer_stop(&media_tracker);
+                    usb_stream_reset();
+                    if (signal_identifier == AVDTP_SI_ABORT && usb_stream.rate_change_pending){
+                        usb_stream.rate_change_pending = false;
+                        configure_codec_from(cur_capability - 1);
+                    }
                     break;
                 default:
                     break;
@@ -1686,6 +2638,12 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             break;
         case AVDTP_SUBEVENT_STREAMING_CONNECTION_RELEASED:
             a2dp_demo_timer_stop(&media_tracker);
+            usb_stream_reset();
+#ifdef HAVE_LDAC_ENCODER
+            ldac_abr_enabled = false;
+            ldac_encoder_configured = false;
+#endif
+            sbc_stream.configured = false;
 // #ifdef HAVE_LC3PLUS
 //             if (lc3plus_handle) {
 //                 free(lc3plus_handle);
@@ -1699,12 +2657,21 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             printf("Streaming connection released.\n");
             set_led_mode_off();
             is_streaming = false;
+            if (usb_stream.rate_change_pending){
+                usb_stream.rate_change_pending = false;
+                // same codec again if it takes the new rate, cur_capability already points past it
+                configure_codec_from(cur_capability - 1);
+            }
             break;
         case AVDTP_SUBEVENT_SIGNALING_CONNECTION_RELEASED:
             a2dp_demo_timer_stop(&media_tracker);
+            usb_stream_reset();
+            usb_stream.rate_change_pending = false;
+            usb_stream.rate_refused = false;
             finish_scan_avdtp_codec = false;
             a2dp_is_connected_flag = false;
             cur_capability = 0;
+            media_tracker.con_handle = HCI_CON_HANDLE_INVALID;
             set_led_mode_off();
             printf("Signaling connection released.\n");
             break;
@@ -1739,6 +2706,13 @@ static void show_usage(void){
     printf("u      - set up sbc           for remote seid %u\n", media_tracker.remote_seid);
     printf("i      - set up aac           for remote seid %u\n", media_tracker.remote_seid);
     printf("X      - stop streaming sine\n");
+#ifdef HAVE_LDAC_ENCODER
+    printf("q      - show LDAC quality governor decisions\n");
+#endif
+#ifdef STAGE_PROFILE
+    printf("t      - show encoder stage timing\n");
+    printf("T      - reset encoder stage timing\n");
+#endif
     printf("Ctrl-c - exit\n");
     printf("---\n");
 }
@@ -1892,6 +2866,22 @@ static void stdin_process(char cmd){
             a2dp_demo_send_media_packet();
             break;
 
+#ifdef HAVE_LDAC_ENCODER
+        case 'q':
+            a2dp_ldac_governor_dump();
+            break;
+#endif
+
+#ifdef STAGE_PROFILE
+        case 't':
+            stage_prof_dump();
+            break;
+        case 'T':
+            printf("Reset encoder stage timing\n");
+            stage_prof_reset();
+            break;
+#endif
+
         case 'u':
             printf("Setup SBC codec\n");
             status = setup_sbc_configuration();
@@ -1929,14 +2919,27 @@ static int setup_sbc_configuration(){
         }
     }
 
+    // choose SBC config params
+    const uint8_t * packet = remote_seps[sbc_num].media_codec_event;
+    uint8_t host_sampling_frequency = usb_stream.sample_rate == 48000 ? AVDTP_SBC_48000 : AVDTP_SBC_44100;
+    if ((avdtp_subevent_signaling_media_codec_sbc_capability_get_sampling_frequency_bitmap(packet) & host_sampling_frequency) == 0){
+        printf("SBC sink does not take %u Hz\n", (unsigned) usb_stream.sample_rate);
+        return -1;
+    }
+
     // // - SBC
     stream_endpoint_sbc = a2dp_source_create_stream_endpoint(AVDTP_AUDIO, AVDTP_CODEC_SBC, (uint8_t *) media_sbc_codec_capabilities, sizeof(media_sbc_codec_capabilities), (uint8_t*) local_stream_endpoint_sbc_media_codec_configuration, sizeof(local_stream_endpoint_sbc_media_codec_configuration));
     btstack_assert(stream_endpoint_sbc != NULL);
     stream_endpoint_sbc->media_codec_configuration_info = local_stream_endpoint_sbc_media_codec_configuration;
     stream_endpoint_sbc->media_codec_configuration_len  = sizeof(local_stream_endpoint_sbc_media_codec_configuration);
     avdtp_source_register_delay_reporting_category(avdtp_local_seid(stream_endpoint_sbc));
-    avdtp_set_preferred_sampling_frequency(stream_endpoint_sbc, 44100);
-    avdtp_set_preferred_channel_mode(stream_endpoint_sbc, AVDTP_SBC_STEREO);
+
+    // SBC-XQ on sinks that take dual channel at a high enough bitpool, plain stereo otherwise
+    uint8_t remote_max_bitpool = avdtp_subevent_signaling_media_codec_sbc_capability_get_max_bitpool_value(packet);
+    bool sbc_xq = (avdtp_subevent_signaling_media_codec_sbc_capability_get_channel_mode_bitmap(packet) & AVDTP_SBC_DUAL_CHANNEL) &&
+                  remote_max_bitpool >= SBC_XQ_MIN_BITPOOL;
+    avdtp_set_preferred_sampling_frequency(stream_endpoint_sbc, usb_stream.sample_rate);
+    avdtp_set_preferred_channel_mode(stream_endpoint_sbc, sbc_xq ? AVDTP_SBC_DUAL_CHANNEL : AVDTP_SBC_STEREO);
 
     // set up local stream_endpoint; need change
     sc.local_stream_endpoint = stream_endpoint_sbc;
@@ -1945,11 +2948,6 @@ static int setup_sbc_configuration(){
     media_tracker.local_seid  = avdtp_local_seid(sc.local_stream_endpoint);
     media_tracker.remote_seid = remote_seps[sbc_num].sep.seid;
 
-
-    // choose SBC config params
-    const uint8_t * packet = remote_seps[sbc_num].media_codec_event;
-
-    // choose SBC config params
     avdtp_configuration_sbc_t configuration;
     configuration.sampling_frequency = avdtp_choose_sbc_sampling_frequency(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_sampling_frequency_bitmap(packet));
     configuration.channel_mode       = avdtp_choose_sbc_channel_mode(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_channel_mode_bitmap(packet));
@@ -1958,6 +2956,11 @@ static int setup_sbc_configuration(){
     configuration.allocation_method  = avdtp_choose_sbc_allocation_method(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_allocation_method_bitmap(packet));
     configuration.max_bitpool_value  = avdtp_choose_sbc_max_bitpool_value(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_max_bitpool_value(packet));
     configuration.min_bitpool_value  = avdtp_choose_sbc_min_bitpool_value(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_min_bitpool_value(packet));
+    if (sbc_xq && configuration.channel_mode == AVDTP_CHANNEL_MODE_DUAL_CHANNEL){
+        // the bitpool is per channel here, what the sink allows for joint stereo is too much
+        configuration.max_bitpool_value = btstack_min(configuration.max_bitpool_value, SBC_XQ_MAX_BITPOOL);
+        printf("SBC-XQ: dual channel, bitpool up to %u\n", configuration.max_bitpool_value);
+    }
 
     // setup SBC configuration
     avdtp_config_sbc_store(media_codec_config_data, &configuration);
@@ -2020,6 +3023,14 @@ static int set_ldac_configuration(){
         printf("Remote Stream Endpoints not discovered yet, please discover stream endpoints first\n");
         return -1;
     }
+#ifdef HAVE_LDAC_ENCODER
+    // the arena is sized at compile time, a library that needs more leaves the stream to SBC
+    int ldac_static_size = ldacBT_get_static_size(0);
+    if (ldac_static_size < 0 || ldac_static_size > (int) sizeof(ldac_arena)){
+        printf("LDAC needs %d bytes, the arena has %u, skipping LDAC\n", ldac_static_size, (unsigned) sizeof(ldac_arena));
+        return -1;
+    }
+#endif
     for (int i = 0; i < num_remote_seps; i++){
         if (remote_seps[i].vendor_id == A2DP_CODEC_VENDOR_ID_SONY && remote_seps[i].codec_id == A2DP_SONY_CODEC_LDAC){
             printf("found LDAC!!! Remote Stream Endpoints ID is %d\n", i);
@@ -2035,9 +3046,15 @@ static int set_ldac_configuration(){
     }
 
     avdtp_media_codec_type_t codec_type = remote_seps[ladc_num].sep.capabilities.media_codec.media_codec_type;
+    // the host rate or nothing, the encoder does not resample
+    uint8_t sampling_frequency = usb_stream.sample_rate == 48000 ? A2DP_LDAC_SAMPLING_FREQ_48000 : A2DP_LDAC_SAMPLING_FREQ_44100;
     if (codec_type == AVDTP_CODEC_NON_A2DP) {
         const uint8_t * packet = remote_seps[ladc_num].media_codec_event;
         const uint8_t *media_info = a2dp_subevent_signaling_media_codec_other_capability_get_media_codec_information(packet);
+        if ((media_info[6] & sampling_frequency) == 0){
+            printf("LDAC sink does not take %u Hz\n", (unsigned) usb_stream.sample_rate);
+            return -1;
+        }
     } else {
         printf("LDAC codec unmatch!!!\n");
         return -1;
@@ -2069,7 +3086,7 @@ static int set_ldac_configuration(){
     media_codec_config_data[4] = 0xAA;
     media_codec_config_data[5] = 0x0;  // A2DP_LDAC_CODEC_ID 0x00AA
 
-    media_codec_config_data[6] = 0x20; // A2DP_LDAC_SAMPLING_FREQ_44100
+    media_codec_config_data[6] = sampling_frequency;
 
     media_codec_config_data[7] = 0x01; // A2DP_LDAC_CHANNEL_MODE_STEREO
 
@@ -2231,10 +3248,9 @@ static int setup_aptx_hd_configuration(){
 
 
 void avdtp_disconnect_and_scan(){
-    a2dp_demo_timer_stop(&media_tracker);
+    a2dp_encoder_stop(&media_tracker, ENCODER_STOP_RESET_QUEUE | ENCODER_STOP_FLUSH_RING);
     a2dp_source_disconnect(media_tracker.avdtp_cid);
     avrcp_disconnect(media_tracker.avdtp_cid);
-    shared_audio_counter = 0;
     gap_delete_all_link_keys();
     gap_start_scanning();
 }
@@ -2252,6 +3268,8 @@ void avdtp_source_establish_stream(){
 }
 
 
+#define NUM_CODECS 2
+
 int set_next_codec(uint8_t num){
 
     switch (num){
@@ -2277,20 +3295,29 @@ void set_next_capablity_and_start_stream(){
 
     sleep_ms(200);
 
-    int result = set_next_codec(cur_capability);
+    configure_codec_from(cur_capability);
+}
 
-    while (result != 0){
-        if (result == 1){
-            cur_capability = 0;
-        }else{
-            cur_capability++;
+// Configures codec num, or the next one that takes the host rate, trying each codec once.
+// cur_capability ends up past the codec configured, past num if none was.
+static int configure_codec_from(uint8_t num){
+    if (num >= NUM_CODECS){
+        num = 0;
+    }
+    cur_capability = num + 1;
+    for (uint8_t i = 0; i < NUM_CODECS; i++){
+        if (set_next_codec(num) == 0){
+            cur_capability = num + 1;
+            usb_stream.rate_refused = false;
+            finish_scan_avdtp_codec = true;
+            return 0;
         }
-        result = set_next_codec(cur_capability);
-        printf("result is %d\n", result);
+        num = (num + 1) % NUM_CODECS;
     }
-
-    cur_capability++;
-    finish_scan_avdtp_codec = true;
+    printf("No codec could be configured at %u Hz, not streaming\n", (unsigned) usb_stream.sample_rate);
+    usb_stream.rate_refused = true;
+    finish_scan_avdtp_codec = false;
+    return -1;
 }
 
 
@@ -2310,6 +3337,26 @@ void start_led_blink(){
 
 int btstack_main(int argc, const char * argv[]){
 
+#if defined(HAVE_LDAC_ENCODER) && defined(LDAC_DUAL_CORE_CHANNELS)
+    ldac_channel_lock = spin_lock_instance(spin_lock_claim_unused(true));
+#endif
+
+    // codec encoding lives on core 1 for the rest of the session
+    multicore_launch_core1(encoder_core1_main);
+
+    media_tracker.con_handle = HCI_CON_HANDLE_INVALID;
+
+    // encoder results and LDAC channel jobs from core 1
+    btstack_run_loop_set_data_source_handler(&encoder_data_source, &a2dp_encoder_process);
+    btstack_run_loop_enable_data_source_callbacks(&encoder_data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_add_data_source(&encoder_data_source);
+
+    // USB alternate setting changes are picked up by polling
+    btstack_run_loop_set_data_source_handler(&usb_stream.data_source, &usb_stream_process);
+    btstack_run_loop_enable_data_source_callbacks(&usb_stream.data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_add_data_source(&usb_stream.data_source);
+    usb_stream.registered = true;
+
     l2cap_init();
     // Initialize AVDTP Sink
     avdtp_source_init();
@@ -5,13 +5,9 @@
 #ifndef PICOW_USB_BT_AUDIO_SSP_COUNTER_H
 #define PICOW_USB_BT_AUDIO_SSP_COUNTER_H
 
-#define AUDIO_BUF_POOL_LEN 5120
+#include "../audio_ring.h"
 
-int get_bt_buf_counter();
-
-void set_usb_buf_counter(uint16_t counter);
-
-void set_shared_audio_buffer(int16_t *data);
+void set_shared_audio_ring(audio_ring_t *ring);
 
 int btstack_main(int argc, const char * argv[]);
 
@@ -27,8 +23,24 @@ void avdtp_source_establish_stream();
 
 void set_next_capablity_and_start_stream();
 
+int set_next_codec(uint8_t num);
+
 void start_led_blink();
 
+// USB streaming interface switched to alternate setting 1 (host plays) or 0 (host closed it),
+// safe to call from the USB interrupt
+void a2dp_source_usb_streaming(bool active);
+
+// sample rate the host selected for the streaming endpoint, the stream to the sink follows it.
+// Safe to call from the USB interrupt.
+void a2dp_source_usb_sample_rate(uint32_t sample_rate);
+
+// LDAC quality governor: encode time per step and the latest decisions, for tuning
+void a2dp_ldac_governor_dump(void);
+
+// LDAC quality ABR has the link at, NULL while the stream is not LDAC with ABR
+const char * a2dp_ldac_link_quality(void);
+
 static int setup_aac_configuration();
 
 static int setup_sbc_configuration();
@@ -18,6 +18,7 @@
 #include "usb_sound.h"
 #include "pico_w_led.h"
 #include "pico/flash.h"
+#include "stage_prof.h"
 
 // by wasdwasd0105
 
@@ -88,6 +89,7 @@ int main() {
     // // enable to use uart see debug info
     stdio_init_all();
     stdout_uart_init();
+    stage_prof_core_init();
 
     usb_audio_main();
     printf("init ctw43.\n");
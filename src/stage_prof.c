@@ -0,0 +1,120 @@
+//
+// Per stage cycle profiler, see stage_prof.h
+//
+
+#ifdef STAGE_PROFILE
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/platform.h"
+#include "hardware/clocks.h"
+#include "hardware/timer.h"
+#include "hardware/structs/systick.h"
+
+#include "stage_prof.h"
+
+// SysTick is a 24 bit down counter
+#define SYSTICK_MASK 0x00ffffffu
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t histogram[STAGE_PROF_BUCKETS];
+} stage_prof_stats_t;
+
+static const char * const stage_names[STAGE_NUM] = {
+    [STAGE_USB_INGEST]    = "usb ingest",
+    [STAGE_SBC_FILL]      = "sbc fill",
+    [STAGE_LDAC_FILL]     = "ldac fill",
+    [STAGE_LDAC_MDCT]     = " mdct",
+    [STAGE_LDAC_SIGANA]   = " sigana",
+    [STAGE_LDAC_NORM]     = " norm",
+    [STAGE_LDAC_BITALLOC] = " bitalloc",
+    [STAGE_LDAC_QUANT]    = " quant",
+    [STAGE_LDAC_PACK]     = " pack",
+    [STAGE_MEDIA_SEND]    = "media send",
+    [STAGE_RADIO_WAIT]    = "radio wait",
+};
+
+// each core only writes its own row, core 0 reads both for the dump
+static stage_prof_stats_t stage_stats[NUM_CORES][STAGE_NUM];
+static uint32_t stage_start[NUM_CORES][STAGE_NUM];
+static uint32_t cycles_per_us;
+
+void stage_prof_core_init(void){
+    // free running over the full 24 bits, clocked by the CPU
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+    cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+}
+
+// the probes sit on the hot paths, running them from flash would add the misses they measure
+void __not_in_flash_func(stage_prof_begin)(stage_prof_stage_t stage){
+    stage_start[get_core_num()][stage] = stage == STAGE_RADIO_WAIT ? time_us_32() : systick_hw->cvr;
+}
+
+void __not_in_flash_func(stage_prof_end)(stage_prof_stage_t stage){
+    uint core = get_core_num();
+    uint32_t cycles;
+    uint32_t us;
+    if (stage == STAGE_RADIO_WAIT){
+        us = time_us_32() - stage_start[core][stage];
+        cycles = us * cycles_per_us;
+    } else {
+        cycles = (stage_start[core][stage] - systick_hw->cvr) & SYSTICK_MASK;
+        us = cycles / cycles_per_us;
+    }
+
+    stage_prof_stats_t * stats = &stage_stats[core][stage];
+    if (stats->count == 0 || cycles < stats->min_cycles){
+        stats->min_cycles = cycles;
+    }
+    if (cycles > stats->max_cycles){
+        stats->max_cycles = cycles;
+    }
+    stats->count++;
+    stats->total_cycles += cycles;
+
+    uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= STAGE_PROF_BUCKETS){
+        bucket = STAGE_PROF_BUCKETS - 1;
+    }
+    stats->histogram[bucket]++;
+}
+
+void stage_prof_dump(void){
+    printf("stage       core    count   min us   avg us   max us  histogram (runs below N us)\n");
+    for (uint core = 0; core < NUM_CORES; core++){
+        for (int stage = 0; stage < STAGE_NUM; stage++){
+            // the other core keeps counting, print a consistent copy
+            stage_prof_stats_t stats = stage_stats[core][stage];
+            if (stats.count == 0) continue;
+
+            printf("%-11s %4u %8lu %8lu %8lu %8lu ", stage_names[stage], core, (unsigned long) stats.count,
+                   (unsigned long) (stats.min_cycles / cycles_per_us),
+                   (unsigned long) (stats.total_cycles / stats.count / cycles_per_us),
+                   (unsigned long) (stats.max_cycles / cycles_per_us));
+            for (int bucket = 0; bucket < STAGE_PROF_BUCKETS; bucket++){
+                if (stats.histogram[bucket] == 0) continue;
+                if (bucket == STAGE_PROF_BUCKETS - 1){
+                    printf(" >=%lu:%lu", 1ul << (bucket - 1), (unsigned long) stats.histogram[bucket]);
+                } else {
+                    printf(" <%lu:%lu", 1ul << bucket, (unsigned long) stats.histogram[bucket]);
+                }
+            }
+            printf("\n");
+        }
+    }
+}
+
+void stage_prof_reset(void){
+    // a probe running on the other core right now may land in the old or the new counts
+    memset(stage_stats, 0, sizeof(stage_stats));
+}
+
+#endif
@@ -0,0 +1,63 @@
+//
+// Per stage cycle profiler for the USB -> encoder -> radio path.
+//
+// Every stage keeps count, min, max, total and a histogram of its run time, separately for each
+// core, so a dropout can be traced to USB ingest, encoding, bit allocation, packing or the wait
+// for the radio. Built with STAGE_PROFILE (see CMakeLists.txt), otherwise the probes are empty
+// inline functions and compile to nothing.
+//
+// Stages are timed with the SysTick of the calling core, which counts CPU cycles and wraps after
+// 2^24 of them, the radio wait can be longer and uses the 1 us system timer instead.
+//
+
+#ifndef PICOW_USB_BT_AUDIO_STAGE_PROF_H
+#define PICOW_USB_BT_AUDIO_STAGE_PROF_H
+
+#include <stdint.h>
+
+typedef enum {
+    STAGE_USB_INGEST = 0,   // USB isochronous OUT packet into the PCM ring
+    STAGE_SBC_FILL,         // SBC frames of one call into the current packet
+    STAGE_LDAC_FILL,        // LDAC frame into the current packet, the stages below included
+    STAGE_LDAC_MDCT,        // LDAC stages in LDACBT_PROF_* order
+    STAGE_LDAC_SIGANA,
+    STAGE_LDAC_NORM,
+    STAGE_LDAC_BITALLOC,
+    STAGE_LDAC_QUANT,
+    STAGE_LDAC_PACK,
+    STAGE_MEDIA_SEND,       // packet handed to L2CAP
+    STAGE_RADIO_WAIT,       // can send now requested until granted
+    STAGE_NUM
+} stage_prof_stage_t;
+
+#ifdef STAGE_PROFILE
+
+// run times are bucketed by their bit length in us, the last bucket takes everything longer
+#define STAGE_PROF_BUCKETS 16
+
+// starts the cycle counter of the calling core, once on each core before its first probe
+void stage_prof_core_init(void);
+
+void stage_prof_begin(stage_prof_stage_t stage);
+void stage_prof_end(stage_prof_stage_t stage);
+
+// prints the statistics of both cores, reset starts them over
+void stage_prof_dump(void);
+void stage_prof_reset(void);
+
+#else
+
+static inline void stage_prof_core_init(void){
+}
+
+static inline void stage_prof_begin(stage_prof_stage_t stage){
+    (void) stage;
+}
+
+static inline void stage_prof_end(stage_prof_stage_t stage){
+    (void) stage;
+}
+
+#endif
+
+#endif //PICOW_USB_BT_AUDIO_STAGE_PROF_H
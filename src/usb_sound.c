@@ -6,12 +6,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "pico/stdlib.h"
 #include "pico/usb_device.h"
 #include "lufa/AudioClassCommon.h"
 
 #include "btstack/btstack_avdtp_source.h"
+#include "audio_ring.h"
+#include "stage_prof.h"
 
 
 #include "pico/flash.h"
@@ -19,7 +22,6 @@
 
 
 // todo forget why this is using core 1 for sound: presumably not necessary
-// todo noop when muted
 
 CU_REGISTER_DEBUG_PINS(audio_timing)
 
@@ -50,6 +52,20 @@ static char *descriptor_strings[] =
 
 #define ENDPOINT_FREQ_CONTROL 1u
 
+// asynchronous endpoint feedback, 10.14 samples per USB frame
+// consumption is measured over this many USB frames (host clock) ...
+#define FEEDBACK_WINDOW_FRAMES      1024u
+// ... and low passed with weight 1/2^shift per window
+#define FEEDBACK_RATE_FILTER_SHIFT  3u
+// fill level we steer the ring towards, in frames
+#define FEEDBACK_TARGET_LEVEL       (AUDIO_RING_FRAMES / 2)
+// proportional term on the level averaged over the window, the encoder drains in bursts of a
+// codec frame so a single reading is off by up to that much: 1 frame of average level error
+// -> 2^shift / 2^14 samples per USB frame, corrects a quarter of the error per window
+#define FEEDBACK_LEVEL_GAIN_SHIFT   2u
+// never report more than nominal +- nominal / 2^shift
+#define FEEDBACK_MAX_DEVIATION_SHIFT 7u
+
 struct audio_device_config {
     struct usb_configuration_descriptor descriptor;
     struct usb_interface_descriptor ac_interface;
@@ -184,7 +200,7 @@ static const struct audio_device_config audio_device_config = {
                         },
                         .freqs = {
                                 AUDIO_SAMPLE_FREQ(44100),
-                               // AUDIO_SAMPLE_FREQ(48000)
+                                AUDIO_SAMPLE_FREQ(48000)
                         },
                 },
         },
@@ -252,58 +268,106 @@ const char *_get_descriptor_string(uint index) {
 static struct {
     uint32_t freq;
     int16_t volume;
-    int16_t vol_mul;
+    uint16_t vol_mul;
     bool mute;
 } audio_state = {
         .freq = 44100,
 };
 
 
-uint16_t buffer_counter = 0;
-uint16_t audio_buffer_pool[AUDIO_BUF_POOL_LEN] = {0};
+static int16_t audio_buffer_pool[AUDIO_RING_FRAMES * AUDIO_RING_CHANNELS];
+static audio_ring_t usb_audio_ring;
+
+static struct {
+    uint32_t nominal;       // 10.14
+    uint32_t rate;          // 10.14, filtered measured consumption per USB frame
+    uint32_t usb_frames;    // OUT packets seen, i.e. host clock
+    uint32_t window_frames;
+    uint32_t window_tail;
+    uint32_t level_sum;     // ring level after each OUT packet of the window
+    int32_t  level_term;    // 10.14
+    bool     tracking;      // the encoder drained the whole last window
+} feedback;
+
+static void feedback_reset(void) {
+    feedback.nominal = (audio_state.freq << 14u) / 1000u;
+    feedback.rate = feedback.nominal;
+    feedback.window_frames = feedback.usb_frames;
+    feedback.window_tail = usb_audio_ring.tail;
+    feedback.level_sum = 0;
+    feedback.level_term = 0;
+    feedback.tracking = false;
+}
+
+static uint32_t feedback_update(void) {
+    // measure how fast the encoder actually drains the ring against the host frame clock
+    uint32_t frames = feedback.usb_frames - feedback.window_frames;
+    if (frames >= FEEDBACK_WINDOW_FRAMES) {
+        uint32_t tail = usb_audio_ring.tail;
+        uint32_t consumed = tail - feedback.window_tail;
+        if (consumed && !feedback.tracking) {
+            // the encoder started somewhere in this window, measure from the next one
+            feedback.tracking = true;
+        } else if (consumed) {
+            uint32_t measured = (uint32_t) (((uint64_t) consumed << 14u) / frames);
+            feedback.rate += ((int32_t) (measured - feedback.rate)) >> FEEDBACK_RATE_FILTER_SHIFT;
+            // then steer the average fill level back to target, below target asks the host for more
+            int32_t level_error = (int32_t) FEEDBACK_TARGET_LEVEL - (int32_t) (feedback.level_sum / frames);
+            feedback.level_term = level_error * (1 << FEEDBACK_LEVEL_GAIN_SHIFT);
+        } else {
+            // encoder idle, nothing to track
+            feedback.tracking = false;
+            feedback.rate = feedback.nominal;
+            feedback.level_term = 0;
+        }
+        feedback.window_frames = feedback.usb_frames;
+        feedback.window_tail = tail;
+        feedback.level_sum = 0;
+    }
+
+    // both terms only move once per window, in between the host sees a steady value
+    int32_t value = (int32_t) feedback.rate + feedback.level_term;
+
+    int32_t max_deviation = (int32_t) (feedback.nominal >> FEEDBACK_MAX_DEVIATION_SHIFT);
+    if (value > (int32_t) feedback.nominal + max_deviation) value = (int32_t) feedback.nominal + max_deviation;
+    if (value < (int32_t) feedback.nominal - max_deviation) value = (int32_t) feedback.nominal - max_deviation;
+    return (uint32_t) value;
+}
 
 
 void _as_audio_packet(struct usb_endpoint *ep) {
+    stage_prof_begin(STAGE_USB_INGEST);
     assert(ep->current_transfer);
     struct usb_buffer *usb_buffer = usb_current_out_packet_buffer(ep);
 
     assert(!(usb_buffer->data_len & 3u));
 
-    uint16_t vol_mul = audio_state.vol_mul;
-    int16_t *out = malloc(usb_buffer->data_len);
-    int16_t *in = (int16_t *) usb_buffer->data;
+    const int16_t *in = (const int16_t *) usb_buffer->data;
 
     uint8_t sample_count = usb_buffer->data_len / 4;
 
-    for (int i = 0; i < sample_count * 2; i++) {
-        out[i] = (int16_t) ((in[i] * vol_mul) >> 15u);
-    }
-    //printf("usb 1ms ~~~~~~~~~~\n");
-
-    // New resync func
-    // Check if usb_audio_buf_counter is in the range of shared_audio_counter and shared_audio_counter + num_audio_samples_per_sbc_buffer * 2
-    // 128 is a not good value; need get from btstack_sbc_encoder_sbc_buffer_length()
-    if (get_bt_buf_counter() < buffer_counter && buffer_counter < (get_bt_buf_counter() + 128 * 2)){
-            // If so, wait until more data is written
-        buffer_counter += sample_count * 2;
-    }
-
-    for (int i = 0; i < sample_count * 2; i++) {
-
-        if (buffer_counter < AUDIO_BUF_POOL_LEN){
+    // frames that do not fit are dropped and the encoder side resyncs to half full
+    uint32_t num_frames = audio_ring_reserve(&usb_audio_ring, sample_count);
+
+    // scale straight into the ring slots in one pass, at most two spans when wrapping
+    uint16_t vol_mul = audio_state.mute ? 0 : audio_state.vol_mul;
+    uint32_t written = 0;
+    while (written < num_frames) {
+        uint32_t span = num_frames - written;
+        int16_t *out = audio_ring_write_span(&usb_audio_ring, written, &span);
+        for (uint32_t i = 0; i < span * 2; i++) {
+            out[i] = (int16_t) ((in[i] * vol_mul) >> 15u);
         }
-        else{
-            buffer_counter = 0;
-        }
-
-        audio_buffer_pool[buffer_counter] = out[i];
-        buffer_counter++; 
-        
+        in += span * 2;
+        written += span;
     }
-    set_usb_buf_counter(buffer_counter);
-    free(out);
+    audio_ring_commit(&usb_audio_ring, num_frames);
+    feedback.usb_frames++;
+    feedback.level_sum += audio_ring_level(&usb_audio_ring);
+
     usb_grow_transfer(ep->current_transfer, 1);
     usb_packet_done(ep);
+    stage_prof_end(STAGE_USB_INGEST);
 }
 
 static void _as_sync_packet(struct usb_endpoint *ep) {
@@ -314,12 +378,11 @@ static void _as_sync_packet(struct usb_endpoint *ep) {
     assert(buffer->data_max >= 3);
     buffer->data_len = 3;
 
-    // todo lie thru our teeth for now
-    uint feedback = (audio_state.freq << 14u) / 1000u;
+    uint value = feedback_update();
 
-    buffer->data[0] = feedback;
-    buffer->data[1] = feedback >> 8u;
-    buffer->data[2] = feedback >> 16u;
+    buffer->data[0] = value;
+    buffer->data[1] = value >> 8u;
+    buffer->data[2] = value >> 16u;
 
     // keep on truckin'
     usb_grow_transfer(ep->current_transfer, 1);
@@ -446,6 +509,8 @@ static void _audio_reconfigure() {
         default:
             audio_state.freq = 44100;
     }
+    feedback_reset();
+    a2dp_source_usb_sample_rate(audio_state.freq);
     // todo hack overwriting const
 }
 
@@ -502,7 +567,9 @@ static const struct usb_transfer_type _audio_cmd_transfer_type = {
 static bool as_set_alternate(struct usb_interface *interface, uint alt) {
     assert(interface == &as_op_interface);
     usb_warn("SET ALTERNATE %d\n", alt);
-    return alt < 2;
+    if (alt >= 2) return false;
+    a2dp_source_usb_streaming(alt == 1);
+    return true;
 }
 
 static bool do_set_current(struct usb_setup_packet *setup) {
@@ -610,10 +677,13 @@ void * usb_audio_main(void) {
 
     flash_safe_execute_core_init();
 
+    audio_ring_init(&usb_audio_ring, audio_buffer_pool, AUDIO_RING_FRAMES,
+                    AUDIO_RING_OVERRUN_RESYNC, AUDIO_RING_UNDERRUN_SILENCE);
+
     usb_sound_card_init();
 
-    // share the audio pool buf to BT 
-    set_shared_audio_buffer(audio_buffer_pool);
+    // share the audio ring to BT
+    set_shared_audio_ring(&usb_audio_ring);
 
     printf("HAHA %04x %04x %04x %04x\n", MIN_VOLUME, DEFAULT_VOLUME, MAX_VOLUME, VOLUME_RESOLUTION);
 